@@ -0,0 +1,54 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include "ast/ast.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+AST 节点的 bump-pointer arena：一次编译的所有节点都从这里分配
+- 节点按块连续分配，分配只是移动一下指针
+- 节点之间用裸指针连接，不需要引用计数
+- arena 析构时逆序调用所有节点的析构函数，再把整块内存一起释放
+不可拷贝，节点的地址在 arena 析构之前一直有效
+*/
+class ASTArena {
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    size_t block_used = BLOCK_SIZE; // 当前块已经用掉的大小
+    // 所有节点，析构时需要调用析构函数（节点里有 string / vector）
+    std::vector<AST_Node *> nodes;
+    // 分配 size 大小、按 align 对齐的一段内存
+    void *allocate(size_t size, size_t align);
+public:
+    ASTArena() = default;
+    ASTArena(const ASTArena &) = delete;
+    ASTArena &operator=(const ASTArena &) = delete;
+    ~ASTArena();
+
+    // 在 arena 中构造一个节点
+    template <class T, class... Args>
+    T *make(Args &&...args) {
+        static_assert(std::is_base_of_v<AST_Node, T>, "ASTArena only holds AST nodes");
+        T *node = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        nodes.push_back(node);
+        return node;
+    }
+    // 已经分配的节点个数
+    size_t node_count() const { return nodes.size(); }
+    // 按分配顺序对每个节点调用 f
+    template <class F>
+    void for_each_node(F &&f) {
+        for (AST_Node *node : nodes) {
+            f(node);
+        }
+    }
+    // 把 other 的节点（连同内存块）全部接过来，节点地址不变，other 变成空的
+    void adopt(ASTArena &other);
+};
+
+#endif // AST_ARENA_H
@@ -10,6 +10,7 @@
 #include "lexer/lexer.h"
 #include <cfloat>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -20,20 +21,42 @@ using std::vector;
 using std::pair;
 using std::shared_ptr;
 
-struct AST_visitor;
+/*
+每种具体节点一个 NodeKind，存在节点里
+AST_Walker 按它 switch 分发（见 ast/visitor.h），不需要虚函数
+顺序：表达式在最前面，然后是 item、语句、类型、pattern，FlatAST 也用这个顺序
+*/
+enum class NodeKind : uint8_t {
+    LiteralExpr, IdentifierExpr, BinaryExpr, UnaryExpr, CallExpr, FieldExpr, StructExpr,
+    IndexExpr, BlockExpr, IfExpr, WhileExpr, LoopExpr, ReturnExpr, BreakExpr, ContinueExpr,
+    CastExpr, PathExpr, SelfExpr, UnitExpr, ArrayExpr, RepeatArrayExpr,
+    FnItem, StructItem, EnumItem, ImplItem, ConstItem,
+    LetStmt, ExprStmt, ItemStmt,
+    PathType, ArrayType, UnitType, SelfType,
+    IdentifierPattern
+};
+
+/*
+节点之间用裸指针连接，不做引用计数
+所有节点都由一次编译共用的 ASTArena 分配并持有（见 ast/arena.h），整棵树随 arena 一起释放
+*/
 
 struct AST_Node {
     /*
     每个节点一个唯一 id
     方便调试
     用于 map 的 key
-    建立完 ast 树之后，给每个节点分配一个 id
+    Parser 构造节点的时候按顺序分配，一棵树上的 id 是稠密的 [0, 节点个数)
+    不在树上的节点（比如内置函数的参数）没有 id
     */
-    size_t NodeId;
+    size_t NodeId = NO_NODE_ID;
+    static constexpr size_t NO_NODE_ID = SIZE_MAX;
+    // 具体是哪一种节点，构造之后不变
+    const NodeKind kind;
+    AST_Node(NodeKind kind_) : kind(kind_) {}
     virtual ~AST_Node() = default;
-    virtual void accept(AST_visitor &v) = 0;
 };
-using AST_Node_ptr = shared_ptr<AST_Node>;
+using AST_Node_ptr = AST_Node *;
 
 struct Expr_Node;
 struct Stmt_Node;
@@ -41,23 +64,23 @@ struct Item_Node;
 struct Type_Node;
 struct Pattern_Node;
 
-using Expr_ptr = shared_ptr<Expr_Node>;
-using Stmt_ptr = shared_ptr<Stmt_Node>;
-using Item_ptr = shared_ptr<Item_Node>;
-using Type_ptr = shared_ptr<Type_Node>;
-using Pattern_ptr = shared_ptr<Pattern_Node>;
+using Expr_ptr = Expr_Node *;
+using Stmt_ptr = Stmt_Node *;
+using Item_ptr = Item_Node *;
+using Type_ptr = Type_Node *;
+using Pattern_ptr = Pattern_Node *;
 
 struct Expr_Node : public AST_Node {
+    Expr_Node(NodeKind kind_) : AST_Node(kind_) {}
     virtual ~Expr_Node() = default;
-    virtual void accept(AST_visitor &v) override = 0;
 };
 struct Stmt_Node : public AST_Node {
+    Stmt_Node(NodeKind kind_) : AST_Node(kind_) {}
     virtual ~Stmt_Node() = default;
-    virtual void accept(AST_visitor &v) override = 0;
 };
 struct Item_Node : public AST_Node {
+    Item_Node(NodeKind kind_) : AST_Node(kind_) {}
     virtual ~Item_Node() = default;
-    virtual void accept(AST_visitor &v) override = 0;
 };
 
 enum class Mutibility {
@@ -74,13 +97,12 @@ string reference_type_to_string(ReferenceType ref);
 
 struct Type_Node : public AST_Node {
     ReferenceType ref_type;
-    Type_Node(ReferenceType ref_type_) : ref_type(ref_type_) {}
+    Type_Node(NodeKind kind_, ReferenceType ref_type_) : AST_Node(kind_), ref_type(ref_type_) {}
     virtual ~Type_Node() = default;
-    virtual void accept(AST_visitor &v) override = 0;
 };
 struct Pattern_Node : public AST_Node {
+    Pattern_Node(NodeKind kind_) : AST_Node(kind_) {}
     virtual ~Pattern_Node() = default;
-    virtual void accept(AST_visitor &v) override = 0;
 };
 
 struct LiteralExpr; // 字面量 1, "hello", 'c', true
@@ -124,40 +146,40 @@ struct SelfType; // Self 类型
 // Patterns 只需要考虑 IdentifierPattern 即可
 struct IdentifierPattern; // 标识符模式 let x = expr; 的 x
 
-using LiteralExpr_ptr = shared_ptr<LiteralExpr>;
-using IdentifierExpr_ptr = shared_ptr<IdentifierExpr>;
-using BinaryExpr_ptr = shared_ptr<BinaryExpr>;
-using UnaryExpr_ptr = shared_ptr<UnaryExpr>;
-using CallExpr_ptr = shared_ptr<CallExpr>;
-using FieldExpr_ptr = shared_ptr<FieldExpr>;
-using StructExpr_ptr = shared_ptr<StructExpr>;
-using IndexExpr_ptr = shared_ptr<IndexExpr>;
-using BlockExpr_ptr = shared_ptr<BlockExpr>;
-using IfExpr_ptr = shared_ptr<IfExpr>;
-using WhileExpr_ptr = shared_ptr<WhileExpr>;
-using LoopExpr_ptr = shared_ptr<LoopExpr>;
-using ReturnExpr_ptr = shared_ptr<ReturnExpr>;
-using BreakExpr_ptr = shared_ptr<BreakExpr>;
-using ContinueExpr_ptr = shared_ptr<ContinueExpr>;
-using CastExpr_ptr = shared_ptr<CastExpr>;
-using PathExpr_ptr = shared_ptr<PathExpr>;
-using SelfExpr_ptr = shared_ptr<SelfExpr>;
-using UnitExpr_ptr = shared_ptr<UnitExpr>;
-using ArrayExpr_ptr = shared_ptr<ArrayExpr>;
-using RepeatArrayExpr_ptr = shared_ptr<RepeatArrayExpr>;
-using FnItem_ptr = shared_ptr<FnItem>;
-using StructItem_ptr = shared_ptr<StructItem>;
-using EnumItem_ptr = shared_ptr<EnumItem>;
-using ImplItem_ptr = shared_ptr<ImplItem>;
-using ConstItem_ptr = shared_ptr<ConstItem>;
-using LetStmt_ptr = shared_ptr<LetStmt>;
-using ExprStmt_ptr = shared_ptr<ExprStmt>;
-using ItemStmt_ptr = shared_ptr<ItemStmt>;
-using PathType_ptr = shared_ptr<PathType>;
-using ArrayType_ptr = shared_ptr<ArrayType>;
-using UnitType_ptr = shared_ptr<UnitType>;
-using SelfType_ptr = shared_ptr<SelfType>;
-using IdentifierPattern_ptr = shared_ptr<IdentifierPattern>;
+using LiteralExpr_ptr = LiteralExpr *;
+using IdentifierExpr_ptr = IdentifierExpr *;
+using BinaryExpr_ptr = BinaryExpr *;
+using UnaryExpr_ptr = UnaryExpr *;
+using CallExpr_ptr = CallExpr *;
+using FieldExpr_ptr = FieldExpr *;
+using StructExpr_ptr = StructExpr *;
+using IndexExpr_ptr = IndexExpr *;
+using BlockExpr_ptr = BlockExpr *;
+using IfExpr_ptr = IfExpr *;
+using WhileExpr_ptr = WhileExpr *;
+using LoopExpr_ptr = LoopExpr *;
+using ReturnExpr_ptr = ReturnExpr *;
+using BreakExpr_ptr = BreakExpr *;
+using ContinueExpr_ptr = ContinueExpr *;
+using CastExpr_ptr = CastExpr *;
+using PathExpr_ptr = PathExpr *;
+using SelfExpr_ptr = SelfExpr *;
+using UnitExpr_ptr = UnitExpr *;
+using ArrayExpr_ptr = ArrayExpr *;
+using RepeatArrayExpr_ptr = RepeatArrayExpr *;
+using FnItem_ptr = FnItem *;
+using StructItem_ptr = StructItem *;
+using EnumItem_ptr = EnumItem *;
+using ImplItem_ptr = ImplItem *;
+using ConstItem_ptr = ConstItem *;
+using LetStmt_ptr = LetStmt *;
+using ExprStmt_ptr = ExprStmt *;
+using ItemStmt_ptr = ItemStmt *;
+using PathType_ptr = PathType *;
+using ArrayType_ptr = ArrayType *;
+using UnitType_ptr = UnitType *;
+using SelfType_ptr = SelfType *;
+using IdentifierPattern_ptr = IdentifierPattern *;
 
 enum class LiteralType {
     NUMBER,
@@ -173,14 +195,19 @@ string literal_type_to_string(LiteralType type);
 struct LiteralExpr : public Expr_Node {
     LiteralType literal_type;
     string value;
-    LiteralExpr(LiteralType type, const string &val) : literal_type(type), value(val) {}
-    void accept(AST_visitor &v) override;
+    // literal_type 为 NUMBER 时，解码好的值
+    IntegerLiteral number;
+    LiteralExpr(LiteralType type, const string &val)
+        : Expr_Node(NodeKind::LiteralExpr), literal_type(type), value(val) {
+        if (type == LiteralType::NUMBER) number = decode_integer_literal(val);
+    }
+    LiteralExpr(LiteralType type, const string &val, const IntegerLiteral &number_)
+        : Expr_Node(NodeKind::LiteralExpr), literal_type(type), value(val), number(number_) {}
 };
 
 struct IdentifierExpr : public Expr_Node {
     string name;
-    IdentifierExpr(const string &name_) : name(name_) {}
-    void accept(AST_visitor &v) override;
+    IdentifierExpr(const string &name_) : Expr_Node(NodeKind::IdentifierExpr), name(name_) {}
 };
 
 
@@ -208,56 +235,49 @@ struct BinaryExpr : public Expr_Node {
     Expr_ptr left;
     Expr_ptr right;
     BinaryExpr(Binary_Operator oper, Expr_ptr left_, Expr_ptr right_)
-        : op(oper), left(std::move(left_)), right(std::move(right_)) {}
-    void accept(AST_visitor &v) override;
+        : Expr_Node(NodeKind::BinaryExpr), op(oper), left(std::move(left_)), right(std::move(right_)) {}
 };
 
 struct UnaryExpr : public Expr_Node {
     Unary_Operator op;
     Expr_ptr right;
     UnaryExpr(Unary_Operator oper, Expr_ptr right_)
-        : op(oper), right(std::move(right_)) {}
-    void accept(AST_visitor &v) override;
+        : Expr_Node(NodeKind::UnaryExpr), op(oper), right(std::move(right_)) {}
 };
 
 struct CallExpr : public Expr_Node {
     Expr_ptr callee;
     vector<Expr_ptr> arguments;
     CallExpr(Expr_ptr callee_, vector<Expr_ptr> args_)
-        : callee(std::move(callee_)), arguments(std::move(args_)) {}
-    void accept(AST_visitor &v) override;
+        : Expr_Node(NodeKind::CallExpr), callee(std::move(callee_)), arguments(std::move(args_)) {}
 };
 
 struct FieldExpr : public Expr_Node {
     Expr_ptr base;
     string field_name;
     FieldExpr(Expr_ptr base_, const string &field_)
-        : base(std::move(base_)), field_name(field_) {}
-    void accept(AST_visitor &v) override;
+        : Expr_Node(NodeKind::FieldExpr), base(std::move(base_)), field_name(field_) {}
 };
 
 struct StructExpr : public Expr_Node {
     Type_ptr struct_name; // 结构体名，可以是 PathType 也可以是 SelfType
     vector<pair<string, Expr_ptr>> fields;
     StructExpr(Type_ptr name, vector<pair<string, Expr_ptr>> flds)
-        : struct_name(std::move(name)), fields(std::move(flds)) {}
-    void accept(AST_visitor &v) override;
+        : Expr_Node(NodeKind::StructExpr), struct_name(std::move(name)), fields(std::move(flds)) {}
 };
 
 struct IndexExpr : public Expr_Node {
     Expr_ptr base;
     Expr_ptr index;
     IndexExpr(Expr_ptr base_, Expr_ptr index_)
-        : base(std::move(base_)), index(std::move(index_)) {}
-    void accept(AST_visitor &v) override;
+        : Expr_Node(NodeKind::IndexExpr), base(std::move(base_)), index(std::move(index_)) {}
 };
 
 struct BlockExpr : public Expr_Node {
     vector<Stmt_ptr> statements;
     Stmt_ptr tail_statement; // 可选的尾随表达式，若最后有 ; 那么就是 nullptr
     bool must_return_unit; // {} 开头，最后面没有分号，那么一定返回 ()
-    BlockExpr(vector<Stmt_ptr> stmts_, Stmt_ptr tail_ = nullptr) : statements(std::move(stmts_)), tail_statement(std::move(tail_)), must_return_unit(false) {}
-    void accept(AST_visitor &v) override;
+    BlockExpr(vector<Stmt_ptr> stmts_, Stmt_ptr tail_ = nullptr) : Expr_Node(NodeKind::BlockExpr), statements(std::move(stmts_)), tail_statement(std::move(tail_)), must_return_unit(false) {}
 };
 
 // If While Loop 全部当成表达式，返回值可以是值也可以是 ()
@@ -272,66 +292,56 @@ struct IfExpr : public Expr_Node {
     Expr_ptr else_branch; // 如果没有 else 分支则为 nullptr
     bool must_return_unit;
     IfExpr(Expr_ptr condition_, Expr_ptr then_branch_, Expr_ptr else_branch_ = nullptr)
-        : condition(std::move(condition_)), then_branch(std::move(then_branch_)), else_branch(std::move(else_branch_)), must_return_unit(false) {}
-    void accept(AST_visitor &v) override;
+        : Expr_Node(NodeKind::IfExpr), condition(std::move(condition_)), then_branch(std::move(then_branch_)), else_branch(std::move(else_branch_)), must_return_unit(false) {}
 };
 struct WhileExpr : public Expr_Node {
     Expr_ptr condition;
     Expr_ptr body;
     WhileExpr(Expr_ptr condition_, Expr_ptr body_)
-        : condition(std::move(condition_)), body(std::move(body_)) {}
-    void accept(AST_visitor &v) override;
+        : Expr_Node(NodeKind::WhileExpr), condition(std::move(condition_)), body(std::move(body_)) {}
 };
 struct LoopExpr : public Expr_Node {
     Expr_ptr body;
     bool must_return_unit;
-    LoopExpr(Expr_ptr body_) : body(std::move(body_)), must_return_unit(false) {}
-    void accept(AST_visitor &v) override;
+    LoopExpr(Expr_ptr body_) : Expr_Node(NodeKind::LoopExpr), body(std::move(body_)), must_return_unit(false) {}
 };
 struct ReturnExpr : public Expr_Node {
     Expr_ptr return_value; // return 后面可以没有表达式，若没有则为 nullptr
-    ReturnExpr(Expr_ptr return_value_ = nullptr) : return_value(std::move(return_value_)) {}
-    void accept(AST_visitor &v) override;
+    ReturnExpr(Expr_ptr return_value_ = nullptr) : Expr_Node(NodeKind::ReturnExpr), return_value(std::move(return_value_)) {}
 };
 struct BreakExpr : public Expr_Node {
     Expr_ptr break_value; // break 后面可以没有表达式，若没有则为 nullptr
-    BreakExpr(Expr_ptr break_value_ = nullptr) : break_value(std::move(break_value_)) {}
-    void accept(AST_visitor &v) override;
+    BreakExpr(Expr_ptr break_value_ = nullptr) : Expr_Node(NodeKind::BreakExpr), break_value(std::move(break_value_)) {}
 };
 struct ContinueExpr : public Expr_Node {
-    ContinueExpr() = default;
-    void accept(AST_visitor &v) override;
+    ContinueExpr() : Expr_Node(NodeKind::ContinueExpr) {}
 };
 struct CastExpr : public Expr_Node {
     Expr_ptr expr;
     Type_ptr target_type;
-    CastExpr(Expr_ptr expr_, Type_ptr target_type_) : expr(std::move(expr_)), target_type(std::move(target_type_)) {}
-    void accept(AST_visitor &v) override;
+    CastExpr(Expr_ptr expr_, Type_ptr target_type_) : Expr_Node(NodeKind::CastExpr), expr(std::move(expr_)), target_type(std::move(target_type_)) {}
 };
 // base::name
 struct PathExpr : public Expr_Node { 
     // 在这里，base 一定是一个类型，可以是 Self 也可以是其他类型
     Type_ptr base;
     string name;
-    PathExpr(Type_ptr base_, const string &name_) : base(std::move(base_)), name(name_) {}
-    void accept(AST_visitor &v) override;
+    PathExpr(Type_ptr base_, const string &name_) : Expr_Node(NodeKind::PathExpr), base(std::move(base_)), name(name_) {}
 };
 struct SelfExpr : public Expr_Node {
-    void accept(AST_visitor &v) override;
+    SelfExpr() : Expr_Node(NodeKind::SelfExpr) {}
 };
 struct UnitExpr : public Expr_Node {
-    void accept(AST_visitor &v) override;
+    UnitExpr() : Expr_Node(NodeKind::UnitExpr) {}
 };
 struct RepeatArrayExpr : public Expr_Node {
     Expr_ptr element;
     Expr_ptr size; // 数组大小必须是一个常量 但是也可以是常量表达式
-    RepeatArrayExpr(Expr_ptr element_, Expr_ptr size_) : element(std::move(element_)), size(std::move(size_)) {}
-    void accept(AST_visitor &v) override;
+    RepeatArrayExpr(Expr_ptr element_, Expr_ptr size_) : Expr_Node(NodeKind::RepeatArrayExpr), element(std::move(element_)), size(std::move(size_)) {}
 };
 struct ArrayExpr : public Expr_Node {
     vector<Expr_ptr> elements;
-    ArrayExpr(vector<Expr_ptr> elements_) : elements(std::move(elements_)) {}
-    void accept(AST_visitor &v) override;
+    ArrayExpr(vector<Expr_ptr> elements_) : Expr_Node(NodeKind::ArrayExpr), elements(std::move(elements_)) {}
 };
 
 enum class fn_reciever_type {
@@ -349,29 +359,25 @@ struct FnItem : public Item_Node {
     Type_ptr return_type; // 返回类型，若是 nullptr 则说明返回 ()
     Expr_ptr body;
     FnItem(const string &function_name_, fn_reciever_type receiver_type_, vector<pair<Pattern_ptr, Type_ptr>> parameters_, Type_ptr return_type_, Expr_ptr body_)
-        : function_name(function_name_), receiver_type(receiver_type_), parameters(std::move(parameters_)), return_type(std::move(return_type_)), body(std::move(body_)) {}
-    void accept(AST_visitor &v) override;
+        : Item_Node(NodeKind::FnItem), function_name(function_name_), receiver_type(receiver_type_), parameters(std::move(parameters_)), return_type(std::move(return_type_)), body(std::move(body_)) {}
 };
 struct StructItem : public Item_Node {
     string struct_name;
     vector<pair<string, Type_ptr>> fields; // 字段名和字段类型
     StructItem(const string &name, vector<pair<string, Type_ptr>> flds)
-        : struct_name(name), fields(std::move(flds)) {}
-    void accept(AST_visitor &v) override;
+        : Item_Node(NodeKind::StructItem), struct_name(name), fields(std::move(flds)) {}
 };
 struct EnumItem : public Item_Node {
     string enum_name;
     vector<string> variants; // 只考虑简单的常量枚举
     EnumItem(const string &enum_name_, vector<string> variants_)
-        : enum_name(enum_name_), variants(std::move(variants_)) {}
-    void accept(AST_visitor &v) override;
+        : Item_Node(NodeKind::EnumItem), enum_name(enum_name_), variants(std::move(variants_)) {}
 };
 struct ImplItem : public Item_Node {
     string struct_name; // impl 后面的结构体名
     vector<Item_ptr> methods; // 只考虑方法
     ImplItem(const string &struct_name_, vector<Item_ptr> methods_)
-        : struct_name(struct_name_), methods(std::move(methods_)) {}
-    void accept(AST_visitor &v) override;
+        : Item_Node(NodeKind::ImplItem), struct_name(struct_name_), methods(std::move(methods_)) {}
 };
 struct ConstItem : public Item_Node {
     string const_name;
@@ -380,8 +386,7 @@ struct ConstItem : public Item_Node {
     Type_ptr const_type;
     Expr_ptr value;
     ConstItem(const string &const_name_, Type_ptr const_type_, Expr_ptr value_)
-        : const_name(const_name_), const_type(std::move(const_type_)), value(std::move(value_)) {}
-    void accept(AST_visitor &v) override;
+        : Item_Node(NodeKind::ConstItem), const_name(const_name_), const_type(std::move(const_type_)), value(std::move(value_)) {}
 };
 
 struct LetStmt : public Stmt_Node {
@@ -390,51 +395,43 @@ struct LetStmt : public Stmt_Node {
     Expr_ptr initializer;
     // 不知道是否支持没有 initializer 的情况，先假设支持，如果没有 initializer 则为 nullptr
     LetStmt(Pattern_ptr pattern_, Type_ptr type_, Expr_ptr initializer_)
-        : pattern(std::move(pattern_)), type(std::move(type_)), initializer(std::move(initializer_)) {}
-    void accept(AST_visitor &v) override;
+        : Stmt_Node(NodeKind::LetStmt), pattern(std::move(pattern_)), type(std::move(type_)), initializer(std::move(initializer_)) {}
 };
 struct ExprStmt : public Stmt_Node {
     Expr_ptr expr;
     bool is_semi; // 是否以分号结尾
-    ExprStmt(Expr_ptr expr_, bool is_semi_ = false) : expr(std::move(expr_)), is_semi(is_semi_) {}
-    void accept(AST_visitor &v) override;
+    ExprStmt(Expr_ptr expr_, bool is_semi_ = false) : Stmt_Node(NodeKind::ExprStmt), expr(std::move(expr_)), is_semi(is_semi_) {}
 };
 struct ItemStmt : public Stmt_Node {
     Item_ptr item;
-    ItemStmt(Item_ptr item_) : item(std::move(item_)) {}
-    void accept(AST_visitor &v) override;
+    ItemStmt(Item_ptr item_) : Stmt_Node(NodeKind::ItemStmt), item(std::move(item_)) {}
 };
 
 struct PathType : public Type_Node {
     string name;
     PathType(const string &name_, ReferenceType ref_type_) :
-        Type_Node(ref_type_), name(name_) {}
-    void accept(AST_visitor &v) override;
+        Type_Node(NodeKind::PathType, ref_type_), name(name_) {}
 };
 struct ArrayType : public Type_Node {
     Type_ptr element_type;
     Expr_ptr size_expr; // 数组大小必须是一个常量 但是也可以是常量表达式
     ArrayType(Type_ptr element_type_, Expr_ptr size_expr_, ReferenceType ref_type_)
-        : Type_Node(ref_type_),
+        : Type_Node(NodeKind::ArrayType, ref_type_),
         element_type(std::move(element_type_)),
         size_expr(std::move(size_expr_)) {}
-    void accept(AST_visitor &v) override;
 };
 struct UnitType : public Type_Node {
-    UnitType(ReferenceType ref_type_) : Type_Node(ref_type_) {}
-    void accept(AST_visitor &v) override;
+    UnitType(ReferenceType ref_type_) : Type_Node(NodeKind::UnitType, ref_type_) {}
 };
 struct SelfType : public Type_Node {
-    SelfType(ReferenceType ref_type_) : Type_Node(ref_type_) {}
-    void accept(AST_visitor &v) override;
+    SelfType(ReferenceType ref_type_) : Type_Node(NodeKind::SelfType, ref_type_) {}
 };
 
 struct IdentifierPattern : public Pattern_Node {
     string name;
     Mutibility is_mut;
     ReferenceType is_ref;
-    IdentifierPattern(const string &name_, Mutibility is_mut_, ReferenceType is_ref_) : name(name_), is_mut(is_mut_), is_ref(is_ref_) {}
-    void accept(AST_visitor &v) override;
+    IdentifierPattern(const string &name_, Mutibility is_mut_, ReferenceType is_ref_) : Pattern_Node(NodeKind::IdentifierPattern), name(name_), is_mut(is_mut_), is_ref(is_ref_) {}
 };
 
 #endif // AST_H
\ No newline at end of file
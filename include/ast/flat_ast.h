@@ -0,0 +1,118 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast/arena.h"
+#include "ast/ast.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+另一种 AST 的存储方式：所有节点按先序排成一列，用 32 位下标互相引用
+每个节点的各项属性分别放在平行的数组里（struct of arrays），一个节点只占一小段固定大小的记录
+- 一棵子树是连续的一段 [i, subtree_end[i])，遍历某个函数里的所有表达式就是顺序扫一遍这一段
+- 子节点的下标连续地放在 children[first_child[i], first_child[i] + child_count[i]) 中
+  可选的子节点不存在时为 NO_NODE，所以每种节点的子节点位置是固定的：
+    BinaryExpr      : left, right
+    UnaryExpr       : right
+    CallExpr        : callee, arguments...
+    FieldExpr       : base
+    StructExpr      : struct_name, 字段的值...（字段名在 name_list 中）
+    IndexExpr       : base, index
+    BlockExpr       : statements..., tail_statement?
+    IfExpr          : condition, then_branch, else_branch?
+    WhileExpr       : condition, body
+    LoopExpr        : body
+    ReturnExpr      : return_value?
+    BreakExpr       : break_value?
+    CastExpr        : expr, target_type
+    PathExpr        : base
+    ArrayExpr       : elements...
+    RepeatArrayExpr : element, size
+    FnItem          : (pattern, type)..., return_type?, body
+    StructItem      : 字段的类型...（字段名在 name_list 中）
+    ImplItem        : methods...
+    ConstItem       : const_type, value
+    LetStmt         : pattern, type, initializer?
+    ExprStmt        : expr
+    ItemStmt        : item
+    ArrayType       : element_type, size_expr
+- name 是节点自己的名字（标识符、字段名、函数名……，LiteralExpr 是字面量的原文），在 strings 中的下标
+- name_list 只有 StructExpr / StructItem 的字段名和 EnumItem 的成员用到
+- flags 放一个小枚举：运算符、字面量类型、引用类型、receiver 类型，
+  IdentifierPattern 是 is_ref | is_mut << 2，BlockExpr / IfExpr / LoopExpr 是 must_return_unit，ExprStmt 是 is_semi
+由指针形式的 AST 一次性转换得到，转换之后和原来的树互不依赖
+也可以序列化成一段紧凑的二进制（AST 缓存用），再用 to_ast 重建出指针形式的 AST，NodeId 保持不变
+*/
+
+// 节点种类就是 AST 的 NodeKind，表达式排在最前面
+using FlatKind = NodeKind;
+string flat_kind_to_string(FlatKind kind);
+
+struct FlatAST {
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+    static constexpr uint32_t NO_NAME = UINT32_MAX;
+
+    // 每个节点一项
+    vector<FlatKind> kind;
+    vector<uint8_t> flags;
+    vector<uint32_t> node_id;     // 原来 AST 中的 NodeId，side table 可以继续用
+    vector<uint32_t> subtree_end;
+    vector<uint32_t> first_child;
+    vector<uint32_t> child_count;
+    vector<uint32_t> name;        // strings 中的下标，没有名字为 NO_NAME
+    vector<uint32_t> name_list;   // name_lists 中的起点，没有为 NO_NAME
+
+    vector<uint32_t> children;
+    // 每个列表是 [个数, 名字在 strings 中的下标...]
+    vector<uint32_t> name_lists;
+    // 去重之后的名字
+    vector<string> strings;
+    // 顶层 item 的下标
+    vector<uint32_t> roots;
+
+    // 把指针形式的 AST 转换过来
+    static FlatAST build(const vector<Item_ptr> &items);
+    // 在 arena 中重建指针形式的 AST，每个节点的 NodeId 就是 node_id 中记录的值
+    // 结构不对（子节点个数、子节点种类）时 throw Error
+    vector<Item_ptr> to_ast(ASTArena &arena) const;
+
+    // 二进制序列化：依次是每个数组 [u64 个数][元素...]，strings 是 [u64 个数][u32 长度...][字节...]
+    // 按本机字节序直接写，只给同一台机器上的缓存用
+    string serialize() const;
+    // 反序列化并检查下标都不越界、子节点都在自己的子树里、node_id 是 [0, size()) 的排列
+    // 数据不合法时返回 false
+    static bool deserialize(std::string_view data, FlatAST &flat);
+
+    size_t size() const { return kind.size(); }
+    uint32_t child(uint32_t node, size_t k) const { return children[first_child[node] + k]; }
+    std::span<const uint32_t> child_list(uint32_t node) const {
+        return std::span<const uint32_t>(children.data() + first_child[node], child_count[node]);
+    }
+    std::string_view name_of(uint32_t node) const {
+        return name[node] == NO_NAME ? std::string_view() : std::string_view(strings[name[node]]);
+    }
+    // name_list 中第 k 个名字
+    size_t name_list_size(uint32_t node) const {
+        return name_list[node] == NO_NAME ? 0 : name_lists[name_list[node]];
+    }
+    std::string_view name_list_at(uint32_t node, size_t k) const {
+        return strings[name_lists[name_list[node] + 1 + k]];
+    }
+    static bool is_expr(FlatKind k) { return k <= FlatKind::RepeatArrayExpr; }
+    static bool is_item(FlatKind k) { return k >= FlatKind::FnItem && k <= FlatKind::ConstItem; }
+    static bool is_stmt(FlatKind k) { return k >= FlatKind::LetStmt && k <= FlatKind::ItemStmt; }
+    static bool is_type(FlatKind k) { return k >= FlatKind::PathType && k <= FlatKind::SelfType; }
+    // 顺序扫一遍 root 的子树（包括 root），对其中的每个表达式调用 f(下标)
+    template <class F>
+    void for_each_expr(uint32_t root, F &&f) const {
+        for (uint32_t i = root; i < subtree_end[root]; i++) {
+            if (is_expr(kind[i])) f(i);
+        }
+    }
+};
+
+#endif // FLAT_AST_H
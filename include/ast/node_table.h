@@ -0,0 +1,84 @@
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+以 NodeId 为下标的 side table，代替 map<size_t, T>
+NodeId 是稠密的 [0, 节点个数)，所以直接按下标存，另外用一个 bitmap 记录哪些 id 有值
+- operator[] 和 map 一样：没有值的时候先放一个默认值
+- const 的 operator[] 和 get 不会插入，没有值分别返回默认值和 nullptr，多个线程同时读没有问题
+- 按页分配，扩容时已有的元素不会移动，拿到的引用 / 指针和 map 一样一直有效
+构造时给出节点个数就一次分配好；没有预先分配的页第一次写的时候才分配，只写了一小段 id 的表很省内存
+*/
+template <class T>
+class NodeTable {
+    static constexpr size_t PAGE_BITS = 10;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+    std::vector<std::unique_ptr<T[]>> pages;
+    std::vector<uint64_t> present;
+public:
+    NodeTable() = default;
+    explicit NodeTable(size_t node_count) { reserve(node_count); }
+    // 按节点个数预先分配
+    void reserve(size_t node_count) {
+        size_t page_count = (node_count + PAGE_SIZE - 1) >> PAGE_BITS;
+        grow(page_count);
+        for (size_t page = 0; page < page_count; page++) {
+            if (pages[page] == nullptr) {
+                pages[page] = std::make_unique<T[]>(PAGE_SIZE);
+            }
+        }
+    }
+    bool contains(size_t id) const {
+        return id < present.size() * 64 && (present[id / 64] >> (id % 64) & 1);
+    }
+    T &operator[](size_t id) {
+        size_t page = id >> PAGE_BITS;
+        if (page >= pages.size()) {
+            grow(page + 1);
+        }
+        if (pages[page] == nullptr) {
+            pages[page] = std::make_unique<T[]>(PAGE_SIZE);
+        }
+        present[id / 64] |= uint64_t(1) << (id % 64);
+        return pages[page][id & (PAGE_SIZE - 1)];
+    }
+    const T &operator[](size_t id) const {
+        static const T empty{};
+        const T *value = get(id);
+        return value == nullptr ? empty : *value;
+    }
+    T *get(size_t id) {
+        return contains(id) ? &pages[id >> PAGE_BITS][id & (PAGE_SIZE - 1)] : nullptr;
+    }
+    const T *get(size_t id) const {
+        return contains(id) ? &pages[id >> PAGE_BITS][id & (PAGE_SIZE - 1)] : nullptr;
+    }
+    // 把 other 里有值的元素都移过来，覆盖这里原有的值
+    // 用来合并几个线程各自写的表，代价和 other 的 id 范围成正比
+    void merge_from(NodeTable &&other) {
+        for (size_t word = 0; word < other.present.size(); word++) {
+            for (uint64_t bits = other.present[word]; bits != 0; bits &= bits - 1) {
+                size_t id = word * 64 + std::countr_zero(bits);
+                (*this)[id] = std::move(other.pages[id >> PAGE_BITS][id & (PAGE_SIZE - 1)]);
+            }
+        }
+        other.pages.clear();
+        other.present.clear();
+    }
+private:
+    // 页表扩到 page_count 页，新的页先不分配
+    void grow(size_t page_count) {
+        if (pages.size() < page_count) {
+            pages.resize(page_count);
+            present.resize(page_count * PAGE_SIZE / 64, 0);
+        }
+    }
+};
+
+#endif // NODE_TABLE_H
@@ -3,97 +3,214 @@
 
 #include "ast/ast.h"
 #include <cstddef>
+#include <tuple>
 
 /*
 
-定义 visitor 模式的基类 AST_visitor
-以及一些子类：递归遍历 AST 的 AST_Walker
+定义 visitor 模式的基类 AST_Walker<Derived>
+以及一个子类：打印 AST 的 AST_Printer
 
-*/
+AST_Walker 是 CRTP 基类，不用虚函数：
+- dispatch(node) 按 node->kind switch，直接调用 Derived::visit，编译器可以内联
+- 每个 visit 的默认实现是递归遍历子节点，子类只需要写自己关心的节点
+  子类里写 using AST_Walker::visit; 把没写的默认实现引进来（否则会被同名的 visit 隐藏）
+- 子类在自己的 visit 里调用 AST_Walker::visit(node) 就是接着遍历子节点
 
+*/
 
-struct AST_visitor {
+template <class Derived>
+struct AST_Walker {
 public:
-    virtual ~AST_visitor() = default;
-    virtual void visit(LiteralExpr &node) = 0;
-    virtual void visit(IdentifierExpr &node) = 0;
-    virtual void visit(BinaryExpr &node) = 0;
-    virtual void visit(UnaryExpr &node) = 0;
-    virtual void visit(CallExpr &node) = 0;
-    virtual void visit(FieldExpr &node) = 0;
-    virtual void visit(StructExpr &node) = 0;
-    virtual void visit(IndexExpr &node) = 0;
-    virtual void visit(BlockExpr &node) = 0;
-    virtual void visit(IfExpr &node) = 0;
-    virtual void visit(WhileExpr &node) = 0;
-    virtual void visit(LoopExpr &node) = 0;
-    virtual void visit(ReturnExpr &node) = 0;
-    virtual void visit(BreakExpr &node) = 0;
-    virtual void visit(ContinueExpr &node) = 0;
-    virtual void visit(CastExpr &node) = 0;
-    virtual void visit(PathExpr &node) = 0;
-    virtual void visit(SelfExpr &node) = 0;
-    virtual void visit(UnitExpr &node) = 0;
-    virtual void visit(ArrayExpr &node) = 0;
-    virtual void visit(RepeatArrayExpr &node) = 0;
-    virtual void visit(FnItem &node) = 0;
-    virtual void visit(StructItem &node) = 0;
-    virtual void visit(EnumItem &node) = 0;
-    virtual void visit(ImplItem &node) = 0;
-    virtual void visit(ConstItem &node) = 0;
-    virtual void visit(LetStmt &node) = 0;
-    virtual void visit(ExprStmt &node) = 0;
-    virtual void visit(ItemStmt &node) = 0;
-    virtual void visit(PathType &node) = 0;
-    virtual void visit(ArrayType &node) = 0;
-    virtual void visit(UnitType &node) = 0;
-    virtual void visit(SelfType &node) = 0;
-    virtual void visit(IdentifierPattern &node) = 0;
+    // 按节点的 kind 分发到 Derived 对应的 visit
+    void dispatch(AST_Node *node) {
+        Derived &self = static_cast<Derived &>(*this);
+        switch (node->kind) {
+            case NodeKind::LiteralExpr: self.visit(static_cast<LiteralExpr &>(*node)); return;
+            case NodeKind::IdentifierExpr: self.visit(static_cast<IdentifierExpr &>(*node)); return;
+            case NodeKind::BinaryExpr: self.visit(static_cast<BinaryExpr &>(*node)); return;
+            case NodeKind::UnaryExpr: self.visit(static_cast<UnaryExpr &>(*node)); return;
+            case NodeKind::CallExpr: self.visit(static_cast<CallExpr &>(*node)); return;
+            case NodeKind::FieldExpr: self.visit(static_cast<FieldExpr &>(*node)); return;
+            case NodeKind::StructExpr: self.visit(static_cast<StructExpr &>(*node)); return;
+            case NodeKind::IndexExpr: self.visit(static_cast<IndexExpr &>(*node)); return;
+            case NodeKind::BlockExpr: self.visit(static_cast<BlockExpr &>(*node)); return;
+            case NodeKind::IfExpr: self.visit(static_cast<IfExpr &>(*node)); return;
+            case NodeKind::WhileExpr: self.visit(static_cast<WhileExpr &>(*node)); return;
+            case NodeKind::LoopExpr: self.visit(static_cast<LoopExpr &>(*node)); return;
+            case NodeKind::ReturnExpr: self.visit(static_cast<ReturnExpr &>(*node)); return;
+            case NodeKind::BreakExpr: self.visit(static_cast<BreakExpr &>(*node)); return;
+            case NodeKind::ContinueExpr: self.visit(static_cast<ContinueExpr &>(*node)); return;
+            case NodeKind::CastExpr: self.visit(static_cast<CastExpr &>(*node)); return;
+            case NodeKind::PathExpr: self.visit(static_cast<PathExpr &>(*node)); return;
+            case NodeKind::SelfExpr: self.visit(static_cast<SelfExpr &>(*node)); return;
+            case NodeKind::UnitExpr: self.visit(static_cast<UnitExpr &>(*node)); return;
+            case NodeKind::ArrayExpr: self.visit(static_cast<ArrayExpr &>(*node)); return;
+            case NodeKind::RepeatArrayExpr: self.visit(static_cast<RepeatArrayExpr &>(*node)); return;
+            case NodeKind::FnItem: self.visit(static_cast<FnItem &>(*node)); return;
+            case NodeKind::StructItem: self.visit(static_cast<StructItem &>(*node)); return;
+            case NodeKind::EnumItem: self.visit(static_cast<EnumItem &>(*node)); return;
+            case NodeKind::ImplItem: self.visit(static_cast<ImplItem &>(*node)); return;
+            case NodeKind::ConstItem: self.visit(static_cast<ConstItem &>(*node)); return;
+            case NodeKind::LetStmt: self.visit(static_cast<LetStmt &>(*node)); return;
+            case NodeKind::ExprStmt: self.visit(static_cast<ExprStmt &>(*node)); return;
+            case NodeKind::ItemStmt: self.visit(static_cast<ItemStmt &>(*node)); return;
+            case NodeKind::PathType: self.visit(static_cast<PathType &>(*node)); return;
+            case NodeKind::ArrayType: self.visit(static_cast<ArrayType &>(*node)); return;
+            case NodeKind::UnitType: self.visit(static_cast<UnitType &>(*node)); return;
+            case NodeKind::SelfType: self.visit(static_cast<SelfType &>(*node)); return;
+            case NodeKind::IdentifierPattern: self.visit(static_cast<IdentifierPattern &>(*node)); return;
+        }
+    }
+
+    // LiteralExpr 和 IdentifierExpr 没有子节点
+    void visit([[maybe_unused]] LiteralExpr &node) {}
+    void visit([[maybe_unused]] IdentifierExpr &node) {}
+    void visit(BinaryExpr &node) {
+        dispatch(node.left);
+        dispatch(node.right);
+    }
+    void visit(UnaryExpr &node) { dispatch(node.right); }
+    void visit(CallExpr &node) {
+        dispatch(node.callee);
+        for (auto &arg : node.arguments) {
+            dispatch(arg);
+        }
+    }
+    void visit(FieldExpr &node) { dispatch(node.base); }
+    void visit(StructExpr &node) {
+        dispatch(node.struct_name);
+        for (auto &[name, expr] : node.fields) {
+            dispatch(expr);
+        }
+    }
+    void visit(IndexExpr &node) {
+        dispatch(node.base);
+        dispatch(node.index);
+    }
+    void visit(BlockExpr &node) {
+        for (auto &stmt : node.statements) {
+            dispatch(stmt);
+        }
+        if (node.tail_statement) {
+            dispatch(node.tail_statement);
+        }
+    }
+    void visit(IfExpr &node) {
+        dispatch(node.condition);
+        dispatch(node.then_branch);
+        if (node.else_branch) {
+            dispatch(node.else_branch);
+        }
+    }
+    void visit(WhileExpr &node) {
+        dispatch(node.condition);
+        dispatch(node.body);
+    }
+    void visit(LoopExpr &node) { dispatch(node.body); }
+    void visit(ReturnExpr &node) {
+        if (node.return_value) {
+            dispatch(node.return_value);
+        }
+    }
+    void visit(BreakExpr &node) {
+        if (node.break_value) {
+            dispatch(node.break_value);
+        }
+    }
+    void visit([[maybe_unused]] ContinueExpr &node) {}
+    void visit(CastExpr &node) {
+        dispatch(node.expr);
+        dispatch(node.target_type);
+    }
+    void visit(PathExpr &node) { dispatch(node.base); }
+    void visit([[maybe_unused]] SelfExpr &node) {}
+    void visit([[maybe_unused]] UnitExpr &node) {}
+    void visit(ArrayExpr &node) {
+        for (auto &elem : node.elements) {
+            dispatch(elem);
+        }
+    }
+    void visit(RepeatArrayExpr &node) {
+        dispatch(node.element);
+        dispatch(node.size);
+    }
+
+    void visit(FnItem &node) {
+        for (auto &[name, type] : node.parameters) {
+            dispatch(name);
+            dispatch(type);
+        }
+        if (node.return_type) {
+            dispatch(node.return_type);
+        }
+        dispatch(node.body);
+    }
+    void visit(StructItem &node) {
+        for (auto &[name, type] : node.fields) {
+            dispatch(type);
+        }
+    }
+    void visit([[maybe_unused]] EnumItem &node) {}
+    void visit(ImplItem &node) {
+        for (auto &item : node.methods) {
+            dispatch(item);
+        }
+    }
+    void visit(ConstItem &node) {
+        dispatch(node.const_type);
+        dispatch(node.value);
+    }
+    void visit(LetStmt &node) {
+        dispatch(node.pattern);
+        dispatch(node.type);
+        if (node.initializer) {
+            dispatch(node.initializer);
+        }
+    }
+    void visit(ExprStmt &node) { dispatch(node.expr); }
+    void visit(ItemStmt &node) { dispatch(node.item); }
+    void visit([[maybe_unused]] PathType &node) {}
+    void visit(ArrayType &node) {
+        dispatch(node.element_type);
+        dispatch(node.size_expr);
+    }
+    void visit([[maybe_unused]] UnitType &node) {}
+    void visit([[maybe_unused]] SelfType &node) {}
+    void visit([[maybe_unused]] IdentifierPattern &node) {}
 };
 
+/*
+把几个 pass 合在一次遍历里跑
+FusablePass：只在节点上挂 enter / leave 回调，不自己控制遍历
+- enter 在遍历子节点之前调用，leave 在子节点都遍历完之后调用
+- 子类只写关心的节点，写 using FusablePass::enter; / using FusablePass::leave; 引入默认的空实现
+FusedWalker<Passes...>：按 AST_Walker 默认的顺序遍历一次 AST
+每个节点先按顺序调用所有 pass 的 enter，再遍历子节点，最后按顺序调用所有 pass 的 leave
+只有互不依赖的 pass 才能合在一起：一个 pass 在某个节点上用到的信息，
+不能是同一次遍历中别的 pass 在这个节点之后才算出来的
+单独跑一个 pass 就是 FusedWalker<Pass>
+*/
+struct FusablePass {
+    template <class T>
+    void enter([[maybe_unused]] T &node) {}
+    template <class T>
+    void leave([[maybe_unused]] T &node) {}
+};
 
-// AST_Walker: 遍历 AST 的基类
-struct AST_Walker : public AST_visitor {
-public:
-    ~AST_Walker() override = default;
-    virtual void visit(LiteralExpr &node) override;
-    virtual void visit(IdentifierExpr &node) override;
-    virtual void visit(BinaryExpr &node) override;
-    virtual void visit(UnaryExpr &node) override;
-    virtual void visit(CallExpr &node) override;
-    virtual void visit(FieldExpr &node) override;
-    virtual void visit(StructExpr &node) override;
-    virtual void visit(IndexExpr &node) override;
-    virtual void visit(BlockExpr &node) override;
-    virtual void visit(IfExpr &node) override;
-    virtual void visit(WhileExpr &node) override;
-    virtual void visit(LoopExpr &node) override;
-    virtual void visit(ReturnExpr &node) override;
-    virtual void visit(BreakExpr &node) override;
-    virtual void visit(ContinueExpr &node) override;
-    virtual void visit(CastExpr &node) override;
-    virtual void visit(PathExpr &node) override;
-    virtual void visit(SelfExpr &node) override;
-    virtual void visit(UnitExpr &node) override;
-    virtual void visit(ArrayExpr &node) override;
-    virtual void visit(RepeatArrayExpr &node) override;
-    virtual void visit(FnItem &node) override;
-    virtual void visit(StructItem &node) override;
-    virtual void visit(EnumItem &node) override;
-    virtual void visit(ImplItem &node) override;
-    virtual void visit(ConstItem &node) override;
-    virtual void visit(LetStmt &node) override;
-    virtual void visit(ExprStmt &node) override;
-    virtual void visit(ItemStmt &node) override;
-    virtual void visit(PathType &node) override;
-    virtual void visit(ArrayType &node) override;
-    virtual void visit(UnitType &node) override;
-    virtual void visit(SelfType &node) override;
-    virtual void visit(IdentifierPattern &node) override;
+template <class... Passes>
+struct FusedWalker : public AST_Walker<FusedWalker<Passes...>> {
+    std::tuple<Passes &...> passes;
+    FusedWalker(Passes &...passes_) : passes(passes_...) {}
+    template <class T>
+    void visit(T &node) {
+        std::apply([&](auto &...pass) { (pass.enter(node), ...); }, passes);
+        AST_Walker<FusedWalker>::visit(node);
+        std::apply([&](auto &...pass) { (pass.leave(node), ...); }, passes);
+    }
 };
 
 // AST_Printer: 打印 AST 树的结构
-struct AST_Printer : public AST_Walker {
+struct AST_Printer : public AST_Walker<AST_Printer> {
 private:
     size_t depth = 0;
     string tab() const {
@@ -101,81 +218,40 @@ private:
     }
 public:
     AST_Printer() : depth(0) {}
-    ~AST_Printer() override = default;
-    virtual void visit(LiteralExpr &node) override;
-    virtual void visit(IdentifierExpr &node) override;
-    virtual void visit(BinaryExpr &node) override;
-    virtual void visit(UnaryExpr &node) override;
-    virtual void visit(CallExpr &node) override;
-    virtual void visit(FieldExpr &node) override;
-    virtual void visit(StructExpr &node) override;
-    virtual void visit(IndexExpr &node) override;
-    virtual void visit(BlockExpr &node) override;
-    virtual void visit(IfExpr &node) override;
-    virtual void visit(WhileExpr &node) override;
-    virtual void visit(LoopExpr &node) override;
-    virtual void visit(ReturnExpr &node) override;
-    virtual void visit(BreakExpr &node) override;
-    virtual void visit(ContinueExpr &node) override;
-    virtual void visit(CastExpr &node) override;
-    virtual void visit(PathExpr &node) override;
-    virtual void visit(SelfExpr &node) override;
-    virtual void visit(UnitExpr &node) override;
-    virtual void visit(ArrayExpr &node) override;
-    virtual void visit(RepeatArrayExpr &node) override;
-    virtual void visit(FnItem &node) override;
-    virtual void visit(StructItem &node) override;
-    virtual void visit(EnumItem &node) override;
-    virtual void visit(ImplItem &node) override;
-    virtual void visit(ConstItem &node) override;
-    virtual void visit(LetStmt &node) override;
-    virtual void visit(ExprStmt &node) override;
-    virtual void visit(ItemStmt &node) override;
-    virtual void visit(PathType &node) override;
-    virtual void visit(ArrayType &node) override;
-    virtual void visit(UnitType &node) override;
-    virtual void visit(SelfType &node) override;
-    virtual void visit(IdentifierPattern &node) override;
-};
-
-struct ASTIdGenerator : public AST_Walker {
-    size_t current_id = 0;
-    ASTIdGenerator() : current_id(0) {}
-    virtual ~ASTIdGenerator() = default;
-    virtual void visit(LiteralExpr &node) override;
-    virtual void visit(IdentifierExpr &node) override;
-    virtual void visit(BinaryExpr &node) override;
-    virtual void visit(UnaryExpr &node) override;
-    virtual void visit(CallExpr &node) override;
-    virtual void visit(FieldExpr &node) override;
-    virtual void visit(StructExpr &node) override;
-    virtual void visit(IndexExpr &node) override;
-    virtual void visit(BlockExpr &node) override;
-    virtual void visit(IfExpr &node) override;
-    virtual void visit(WhileExpr &node) override;
-    virtual void visit(LoopExpr &node) override;
-    virtual void visit(ReturnExpr &node) override;
-    virtual void visit(BreakExpr &node) override;
-    virtual void visit(ContinueExpr &node) override;
-    virtual void visit(CastExpr &node) override;
-    virtual void visit(PathExpr &node) override;
-    virtual void visit(SelfExpr &node) override;
-    virtual void visit(UnitExpr &node) override;
-    virtual void visit(ArrayExpr &node) override;
-    virtual void visit(RepeatArrayExpr &node) override;
-    virtual void visit(FnItem &node) override;
-    virtual void visit(StructItem &node) override;
-    virtual void visit(EnumItem &node) override;
-    virtual void visit(ImplItem &node) override;
-    virtual void visit(ConstItem &node) override;
-    virtual void visit(LetStmt &node) override;
-    virtual void visit(ExprStmt &node) override;
-    virtual void visit(ItemStmt &node) override;
-    virtual void visit(PathType &node) override;
-    virtual void visit(ArrayType &node) override;
-    virtual void visit(UnitType &node) override;
-    virtual void visit(SelfType &node) override;
-    virtual void visit(IdentifierPattern &node) override;
+    void visit(LiteralExpr &node);
+    void visit(IdentifierExpr &node);
+    void visit(BinaryExpr &node);
+    void visit(UnaryExpr &node);
+    void visit(CallExpr &node);
+    void visit(FieldExpr &node);
+    void visit(StructExpr &node);
+    void visit(IndexExpr &node);
+    void visit(BlockExpr &node);
+    void visit(IfExpr &node);
+    void visit(WhileExpr &node);
+    void visit(LoopExpr &node);
+    void visit(ReturnExpr &node);
+    void visit(BreakExpr &node);
+    void visit(ContinueExpr &node);
+    void visit(CastExpr &node);
+    void visit(PathExpr &node);
+    void visit(SelfExpr &node);
+    void visit(UnitExpr &node);
+    void visit(ArrayExpr &node);
+    void visit(RepeatArrayExpr &node);
+    void visit(FnItem &node);
+    void visit(StructItem &node);
+    void visit(EnumItem &node);
+    void visit(ImplItem &node);
+    void visit(ConstItem &node);
+    void visit(LetStmt &node);
+    void visit(ExprStmt &node);
+    void visit(ItemStmt &node);
+    void visit(PathType &node);
+    void visit(ArrayType &node);
+    void visit(UnitType &node);
+    void visit(SelfType &node);
+    void visit(IdentifierPattern &node);
 };
 
 #endif // VISITOR_H
\ No newline at end of file
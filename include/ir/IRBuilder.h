@@ -444,6 +444,12 @@ class IRModule : public std::enable_shared_from_this<IRModule> {
                                   const std::string &init_text,
                                   bool is_const = true,
                                   const std::string &linkage = "private");
+    // 按内容查找已经创建过的字符串字面量全局，没有返回 nullptr。
+    GlobalValue_ptr find_string_literal(const std::string &text) const;
+    // 记录字符串字面量全局，同样内容的字面量之后复用它。
+    void register_string_literal(const std::string &text, GlobalValue_ptr global);
+    // 已经创建的字符串字面量个数。
+    std::size_t string_literal_count() const;
     // 声明函数（无函数体）。
     IRFunction_ptr declare_function(const std::string &name, IRType_ptr fn_type,
                                     bool is_builtin = false);
@@ -468,6 +474,7 @@ class IRModule : public std::enable_shared_from_this<IRModule> {
     std::vector<std::string> module_comments_;
     std::vector<GlobalValue_ptr> globals_;
     std::vector<IRFunction_ptr> functions_;
+    std::unordered_map<std::string, GlobalValue_ptr> string_literals_;
 };
 
 class IRSerializer {
@@ -582,7 +589,7 @@ class IRBuilder {
     void create_memset(IRValue_ptr dst, IRValue_ptr value, IRValue_ptr length,
                        bool is_volatile = false);
 
-    // 创建字符串字面量全局并返回其引用。
+    // 创建字符串字面量全局并返回其引用，同样内容的字面量只创建一次。
     GlobalValue_ptr create_string_literal(const std::string &text);
     // 创建 i32 常量。
     IRValue_ptr create_i32_constant(int64_t value);
@@ -1,6 +1,7 @@
 #ifndef SIMPLE_RUST_COMPILER_IR_IRGEN_H
 #define SIMPLE_RUST_COMPILER_IR_IRGEN_H
 
+#include "ast/node_table.h"
 #include "ast/visitor.h"
 #include "ir/IRBuilder.h"
 #include "semantic/consteval.h"
@@ -39,50 +40,50 @@ struct FunctionContext {
     std::vector<LoopContext> loop_stack;
 };
 
-class IRGenVisitor : public AST_Walker {
+class IRGenVisitor : public AST_Walker<IRGenVisitor> {
   public:
     IRGenVisitor(IRModule &module, IRBuilder &builder,
                  TypeLowering &type_lowering,
-                 std::map<size_t, Scope_ptr> &node_scope_map,
-                 std::map<size_t, RealType_ptr> &type_map,
-                 std::map<size_t, std::pair<RealType_ptr, PlaceKind>>
+                 NodeTable<Scope_ptr> &node_scope_map,
+                 NodeTable<RealType_ptr> &type_map,
+                 NodeTable<std::pair<RealType_ptr, PlaceKind>>
                      &node_type_and_place_kind_map,
-                 std::map<size_t, OutcomeState> &node_outcome_state_map,
-                 std::map<size_t, FnDecl_ptr> &call_expr_to_decl_map,
+                 NodeTable<OutcomeState> &node_outcome_state_map,
+                 NodeTable<FnDecl_ptr> &call_expr_to_decl_map,
                  std::map<ConstDecl_ptr, ConstValue_ptr> &const_value_map,
-                 std::map<size_t, FnDecl_ptr> &fn_item_to_decl_map,
-                 std::map<size_t, ValueDecl_ptr> &identifier_expr_to_decl_map,
-                 std::map<size_t, LetDecl_ptr> &let_stmt_to_decl_map);
+                 NodeTable<FnDecl_ptr> &fn_item_to_decl_map,
+                 NodeTable<ValueDecl_ptr> &identifier_expr_to_decl_map,
+                 NodeTable<LetDecl_ptr> &let_stmt_to_decl_map);
 
-    void visit(FnItem &node) override;
-    void visit(StructItem &node) override;
-    void visit(EnumItem &node) override;
-    void visit(ImplItem &node) override;
-    void visit(ConstItem &node) override;
-    void visit(ItemStmt &node) override;
-    void visit(LetStmt &node) override;
-    void visit(ExprStmt &node) override;
-    void visit(ReturnExpr &node) override;
-    void visit(BreakExpr &node) override;
-    void visit(ContinueExpr &node) override;
-    void visit(BinaryExpr &node) override;
-    void visit(UnaryExpr &node) override;
-    void visit(CallExpr &node) override;
-    void visit(IfExpr &node) override;
-    void visit(WhileExpr &node) override;
-    void visit(LoopExpr &node) override;
-    void visit(BlockExpr &node) override;
-    void visit(StructExpr &node) override;
-    void visit(ArrayExpr &node) override;
-    void visit(RepeatArrayExpr &node) override;
-    void visit(FieldExpr &node) override;
-    void visit(IndexExpr &node) override;
-    void visit(IdentifierExpr &node) override;
-    void visit(LiteralExpr &node) override;
-    void visit(CastExpr &node) override;
-    void visit(PathExpr &node) override;
-    void visit(SelfExpr &node) override;
-    void visit(UnitExpr &node) override;
+    // ImplItem / ItemStmt 只需要继续遍历内部的 item，用默认的实现
+    using AST_Walker::visit;
+    void visit(FnItem &node);
+    void visit(StructItem &node);
+    void visit(EnumItem &node);
+    void visit(ConstItem &node);
+    void visit(LetStmt &node);
+    void visit(ExprStmt &node);
+    void visit(ReturnExpr &node);
+    void visit(BreakExpr &node);
+    void visit(ContinueExpr &node);
+    void visit(BinaryExpr &node);
+    void visit(UnaryExpr &node);
+    void visit(CallExpr &node);
+    void visit(IfExpr &node);
+    void visit(WhileExpr &node);
+    void visit(LoopExpr &node);
+    void visit(BlockExpr &node);
+    void visit(StructExpr &node);
+    void visit(ArrayExpr &node);
+    void visit(RepeatArrayExpr &node);
+    void visit(FieldExpr &node);
+    void visit(IndexExpr &node);
+    void visit(IdentifierExpr &node);
+    void visit(LiteralExpr &node);
+    void visit(CastExpr &node);
+    void visit(PathExpr &node);
+    void visit(SelfExpr &node);
+    void visit(UnitExpr &node);
 
   private:
     IRValue_ptr ensure_slot_for_decl(LetDecl_ptr decl);
@@ -107,37 +108,35 @@ class IRGenVisitor : public AST_Walker {
     IRModule &module_;
     IRBuilder &builder_;
     TypeLowering &type_lowering_;
-    std::map<size_t, Scope_ptr> &node_scope_map_;
-    std::map<size_t, RealType_ptr> &type_map_;
-    std::map<size_t, std::pair<RealType_ptr, PlaceKind>>
+    NodeTable<Scope_ptr> &node_scope_map_;
+    NodeTable<RealType_ptr> &type_map_;
+    NodeTable<std::pair<RealType_ptr, PlaceKind>>
         &node_type_and_place_kind_map_;
-    std::map<size_t, OutcomeState> &node_outcome_state_map_;
-    std::map<size_t, FnDecl_ptr> &call_expr_to_decl_map_;
+    NodeTable<OutcomeState> &node_outcome_state_map_;
+    NodeTable<FnDecl_ptr> &call_expr_to_decl_map_;
     std::map<ConstDecl_ptr, ConstValue_ptr> &const_value_map_;
-    std::map<size_t, FnDecl_ptr> &fn_item_to_decl_map_;
-    std::map<size_t, ValueDecl_ptr> &identifier_expr_to_decl_map_;
-    std::map<size_t, LetDecl_ptr> &let_stmt_to_decl_map_;
+    NodeTable<FnDecl_ptr> &fn_item_to_decl_map_;
+    NodeTable<ValueDecl_ptr> &identifier_expr_to_decl_map_;
+    NodeTable<LetDecl_ptr> &let_stmt_to_decl_map_;
     std::unique_ptr<FunctionContext> fn_ctx_;
-    std::unordered_map<size_t, IRValue_ptr> expr_value_map_;
-    std::unordered_map<size_t, IRValue_ptr> expr_address_map_;
+    NodeTable<IRValue_ptr> expr_value_map_;
+    NodeTable<IRValue_ptr> expr_address_map_;
 };
 
 class IRGenerator {
   public:
     IRGenerator(IRModule &module, IRBuilder &builder,
                 TypeLowering &type_lowering,
-                std::map<size_t, Scope_ptr> &node_scope_map,
-                std::map<Scope_ptr, Local_Variable_map>
-                    &scope_local_variable_map,
-                std::map<size_t, RealType_ptr> &type_map,
-                std::map<size_t, std::pair<RealType_ptr, PlaceKind>>
+                NodeTable<Scope_ptr> &node_scope_map,
+                NodeTable<RealType_ptr> &type_map,
+                NodeTable<std::pair<RealType_ptr, PlaceKind>>
                     &node_type_and_place_kind_map,
-                std::map<size_t, OutcomeState> &node_outcome_state_map,
-                std::map<size_t, FnDecl_ptr> &call_expr_to_decl_map,
+                NodeTable<OutcomeState> &node_outcome_state_map,
+                NodeTable<FnDecl_ptr> &call_expr_to_decl_map,
                 std::map<ConstDecl_ptr, ConstValue_ptr> &const_value_map,
-                std::map<size_t, FnDecl_ptr> &fn_item_to_decl_map,
-                std::map<size_t, ValueDecl_ptr> &identifier_expr_to_decl_map,
-                std::map<size_t, LetDecl_ptr> &let_stmt_to_decl_map);
+                NodeTable<FnDecl_ptr> &fn_item_to_decl_map,
+                NodeTable<ValueDecl_ptr> &identifier_expr_to_decl_map,
+                NodeTable<LetDecl_ptr> &let_stmt_to_decl_map);
 
     void generate(const std::vector<Item_ptr> &ast_items);
 
@@ -145,17 +144,16 @@ class IRGenerator {
     IRModule &module_;
     IRBuilder &builder_;
     TypeLowering &type_lowering_;
-    std::map<size_t, Scope_ptr> &node_scope_map_;
-    std::map<Scope_ptr, Local_Variable_map> &scope_local_variable_map_;
-    std::map<size_t, RealType_ptr> &type_map_;
-    std::map<size_t, std::pair<RealType_ptr, PlaceKind>>
+    NodeTable<Scope_ptr> &node_scope_map_;
+    NodeTable<RealType_ptr> &type_map_;
+    NodeTable<std::pair<RealType_ptr, PlaceKind>>
         &node_type_and_place_kind_map_;
-    std::map<size_t, OutcomeState> &node_outcome_state_map_;
-    std::map<size_t, FnDecl_ptr> &call_expr_to_decl_map_;
+    NodeTable<OutcomeState> &node_outcome_state_map_;
+    NodeTable<FnDecl_ptr> &call_expr_to_decl_map_;
     std::map<ConstDecl_ptr, ConstValue_ptr> &const_value_map_;
-    std::map<size_t, FnDecl_ptr> &fn_item_to_decl_map_;
-    std::map<size_t, ValueDecl_ptr> &identifier_expr_to_decl_map_;
-    std::map<size_t, LetDecl_ptr> &let_stmt_to_decl_map_;
+    NodeTable<FnDecl_ptr> &fn_item_to_decl_map_;
+    NodeTable<ValueDecl_ptr> &identifier_expr_to_decl_map_;
+    NodeTable<LetDecl_ptr> &let_stmt_to_decl_map_;
 };
 
 } // namespace ir
@@ -25,6 +25,8 @@ class TypeLowering {
     void define_struct_fields(StructDecl_ptr decl);
     void declare_builtin_string_types();
     std::size_t size_in_bytes(RealType_ptr type);
+    // 降低过程中临时要用的类型（去掉引用、方法的 self）从这里拿
+    TypeContext &types() { return types_; }
 
   private:
     std::size_t size_of_struct(const std::string &name, StructDecl_ptr decl);
@@ -37,6 +39,7 @@ class TypeLowering {
     std::size_t align_to(std::size_t offset, std::size_t alignment) const;
 
     IRModule &module_;
+    TypeContext types_;
     VoidType_ptr void_type_;
     IntegerType_ptr i1_type_;
     IntegerType_ptr i8_type_;
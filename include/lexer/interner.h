@@ -0,0 +1,36 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+using std::string;
+
+/*
+一次编译共用的符号表：把标识符（以及关键字）映射成一个小整数 id
+- 相同的名字只存一份，返回的 string_view 在 interner 析构之前一直有效
+- 关键字在构造 Lexer 时最先插入，所以关键字的 id 都小于普通标识符
+*/
+class SymbolInterner {
+    // deque 追加元素不会让已有元素失效，map 的 key 可以直接指向这里
+    std::deque<string> storage;
+    std::unordered_map<std::string_view, uint32_t> symbol_ids;
+    std::vector<std::string_view> symbol_names;
+public:
+    static constexpr uint32_t NO_SYMBOL = UINT32_MAX;
+    // 返回 name 对应的 id，没有的话新建一个
+    uint32_t intern(std::string_view name);
+    // 返回 name 对应的 id，不存在返回 NO_SYMBOL
+    uint32_t find(std::string_view name) const;
+    std::string_view name(uint32_t id) const { return symbol_names[id]; }
+    size_t size() const { return symbol_names.size(); }
+};
+
+typedef std::shared_ptr<SymbolInterner> SymbolInterner_ptr;
+
+#endif // INTERNER_H
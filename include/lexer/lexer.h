@@ -1,9 +1,14 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "lexer/interner.h"
+#include "lexer/literal_pool.h"
+#include "lexer/source_buffer.h"
+#include "tools/tools.h"
 #include <cstddef>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 using std::string;
 using std::vector;
@@ -90,42 +95,148 @@ enum class Token_type {
 
 string token_type_to_string(Token_type type);
 
+/*
+token 不持有字符串，value 是一个 string_view：
+- 标识符和关键字指向 interner 中的名字，symbol_id 是它在 interner 中的 id
+- string / char 指向 literal pool 中解码后的内容，没有 symbol_id
+- 其余的指向源代码本身
+只要对应的 Lexer 还在，value 就一直有效
+*/
 struct Token {
     Token_type type;
-    string value;
+    std::string_view value;
+    uint32_t symbol_id = SymbolInterner::NO_SYMBOL;
+    // NUMBER 在分词时就解码好
+    IntegerLiteral number;
+    // 在源代码中的位置 [begin, end)，string / char 包括引号（raw string 从 r 开始）
+    size_t begin = 0;
+    size_t end = 0;
     void show_token() const;
-    Token(Token_type _type, string _value);
+    // 需要拷贝一份 string 的时候用（比如存进 AST）
+    string str() const { return string(value); }
+    Token(Token_type _type, std::string_view _value,
+          uint32_t _symbol_id = SymbolInterner::NO_SYMBOL);
 };
 
 /*
 分词的时候，只有 string 和 char 我会存真正的值（只会存内容的字符串）
 其他的都只存原来的字符串（比如 114514_i32 我也会存 value = "114514_i32"）
+
+两种用法：
+- read_and_get_tokens / tokenize：一次性分完词，结果放在 tokens 中
+- start_stream：按需分词，peek / consume 的时候才往后扫描，
+  已经扫出来但还没被消费的 token 放在一个很小的环形缓冲区里，tokens 保持为空
+一次性分完词之后可以用 relex 对源代码的修改做增量分词
+view 可以得到另一个 Lexer 的 tokens 中一段的视图，多个视图可以各自在不同线程上被 peek / consume
+Lexer 不可拷贝，Parser 直接借用
 */
 class Lexer {
-    map<string, Token_type> keywords_map;
-    map<string, Token_type> symbol_map;
+    // 分词扫描的中间状态，流式分词时每次从这里接着往后扫
+    struct LexState {
+        size_t pos = 0; // 下一个要看的字符
+        bool is_in_block_comment = false; // 是否在 /* ... */ 多行注释中
+        bool is_in_line_comment = false;  // 是否在 // 单行注释中
+        bool is_in_common_string = false; // 是否在 "" 中
+        bool is_in_raw_string = false;    // 是否在 r"" 或者 r#""# 中
+        size_t raw_string_level = 0;      // raw string 的 # 数量
+        bool is_in_char = false;          // 是否在 '' 中
+        bool is_in_number = false;        // 是否在一个数字中
+        bool is_in_identifier = false;    // 是否在一个标识符中
+        // 当前 identifier / number / string 在源代码中的起始位置
+        size_t token_start = 0;
+        // 普通字符串中出现转义时，解码结果放在 now_str 中，否则直接引用源代码
+        bool string_has_escape = false;
+        string now_str;
+        bool finished = false; // 已经扫描到末尾
+    };
+    // 流式分词的环形缓冲区大小，扫描一个字符最多产生两个 token
+    static constexpr size_t RING_SIZE = 16;
+
+    // 判断 text 是否是关键字，是的话返回它在 interner 中的 id，否则返回 -1
+    int keyword_index(std::string_view text) const;
+    // 从 ch 开始按最长匹配识别一个符号，返回符号长度，不是符号返回 0
+    size_t match_symbol(char ch, char next_ch, char next_next_ch, Token_type &type) const;
     // 获得 / + ch 的转义字符
     string get_escape_character(char ch) const;
     // 判断是否不是符号(非字母，非数字，非 _ )
     bool is_not_symbol(char ch) const;
     // 添加一个标识符（需要判断是否是关键字）
-    void add_identifier(string &now_str);
+    void add_identifier(std::string_view text);
     // 添加一个数字（需要判断是否是合法的数字）
-    void add_number(string &now_str);
+    void add_number(std::string_view text);
+    // 产生一个源代码中 [begin, end) 处的 token：流式时放进环形缓冲区，否则放进 tokens
+    void emit(Token token, size_t begin, size_t end);
+    // 产生一个 string / char token，内容先放进 literal pool
+    void emit_literal(Token_type type, std::string_view bytes, size_t begin, size_t end);
+    // 重新开始扫描 source_
+    void reset(SourceBuffer_ptr source_, bool streaming_);
+    // 接着往后扫描：流式时产生至少一个 token 就停下，否则一直扫到末尾
+    void lex_more();
+    // 流式时保证环形缓冲区非空（除非已经没有 token 了）
+    void fill_ring();
+    // 并行分词前的预扫描：只跟踪注释 / 字符串 / 字符的状态，
+    // 在不处于这些状态的行首切分，返回每一块的起点（第一个是 0，最后一个是 text.size()）
+    // 预扫描发现代码不合法时返回空，交给顺序分词去报错
+    vector<size_t> find_chunk_borders(std::string_view text, size_t chunk_count) const;
     size_t current_token_index = 0; // 当前正在处理的 token 的下标
+    // 视图：token 来自 view_parent->tokens 的 [current_token_index, view_end)，不拷贝
+    const Lexer *view_parent = nullptr;
+    size_t view_end = 0;
+    const vector<Token> &token_list() const { return view_parent ? view_parent->tokens : tokens; }
+    size_t token_limit() const { return view_parent ? view_end : tokens.size(); }
+    // 源代码，tokenize 之后仍然持有，token 的 value 可能指向这里
+    SourceBuffer_ptr source;
+    // 多个 Lexer 可以共享同一个 interner，只要 interner 在，token 的 value 就不会失效
+    SymbolInterner_ptr interner;
+    LiteralPool_ptr literals;
+    LexState state;
+    bool streaming = false;
+    vector<Token> ring;
+    size_t ring_head = 0;
+    size_t ring_count = 0;
 public:
-    // 初始化 keywords_map
+    // 把关键字插入 interner
     Lexer();
+    Lexer(const Lexer &) = delete;
+    Lexer &operator=(const Lexer &) = delete;
+    Lexer(Lexer &&) = default;
+    Lexer &operator=(Lexer &&) = default;
     vector<Token> tokens;
+    // 从 stdin 读入全部代码并分词
     void read_and_get_tokens();
+    // mmap 源文件 path 并分词
+    void read_and_get_tokens(const string &path);
+    // 直接在 source_ 上分词
+    void tokenize(SourceBuffer_ptr source_);
+    // 流式分词：之后的 peek / consume 按需扫描
+    void start_stream(SourceBuffer_ptr source_);
+    // 并行分词时每一块的最小大小，代码太短时直接顺序分词
+    static constexpr size_t PARALLEL_MIN_CHUNK = 4 << 20;
+    // 把代码切成若干块，用 thread_count 个线程分别分词再按顺序拼起来，结果和 tokenize 完全一样
+    // thread_count = 0 时使用硬件线程数
+    void tokenize_parallel(SourceBuffer_ptr source_, size_t thread_count = 0,
+                           size_t min_chunk_size = PARALLEL_MIN_CHUNK);
+    // 增量分词（watch 模式）：源代码中 [offset, offset + removed_length) 被替换成 inserted_text
+    // 只重新扫描受影响的一段，拼进已有的 tokens，结果和对新代码重新 tokenize 一样
+    // 需要先用 tokenize 一次性分过词；新代码有词法错误时抛出异常，tokens 保持不变
+    void relex(size_t offset, size_t removed_length, std::string_view inserted_text);
+    // parent 的 tokens 中 [begin, end) 这一段的视图，共享 interner / literal pool，只能 peek / consume
+    // parent 需要一次性分过词，视图用完之前 parent 不能再修改 tokens
+    static Lexer view(const Lexer &parent, size_t begin, size_t end);
+    bool is_streaming() const { return streaming; }
+    // 一次性分词时当前 token 的下标，seek_token 直接跳到下标 index
+    size_t token_index() const { return current_token_index; }
+    void seek_token(size_t index);
     // 看当前的第一个 token
-    Token peek_token() const;
+    // 流式时返回的引用只保证在下一次 consume 之前有效
+    const Token &peek_token();
     // 消费掉当前的第一个 token
     Token consume_token();
     // 判断是否还有 token
-    bool has_more_tokens() const;
+    bool has_more_tokens();
     // 消费一个期望是 type 的 token，否则报错
     Token consume_expect_token(Token_type type);
+    const SymbolInterner &symbols() const { return *interner; }
 };
 
-#endif // LEXER_H
\ No newline at end of file
+#endif // LEXER_H
@@ -0,0 +1,32 @@
+#ifndef LITERAL_POOL_H
+#define LITERAL_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/*
+一次编译共用的字面量池：存放 string / char 字面量解码之后的内容
+- 内容按块分配在 arena 里，不会因为之后的插入而移动，返回的 string_view 一直有效
+- 相同的内容只存一份，返回同一个 string_view
+- 这里只负责存储；生成 IR 时同样内容的字符串只生成一个全局常量，由 IRModule 按内容去重
+*/
+class LiteralPool {
+    // 每块 arena 的大小，超过这个大小的字面量单独分配一块
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<std::unique_ptr<char[]>> large_blocks;
+    size_t block_used = BLOCK_SIZE; // 当前块已经用掉的大小
+    std::unordered_set<std::string_view> literals;
+    // 在 arena 中拷贝一份 bytes
+    std::string_view allocate(std::string_view bytes);
+public:
+    // 返回 arena 中和 bytes 内容相同的那一份，没有的话拷贝进去
+    std::string_view intern(std::string_view bytes);
+};
+
+typedef std::shared_ptr<LiteralPool> LiteralPool_ptr;
+
+#endif // LITERAL_POOL_H
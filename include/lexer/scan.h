@@ -0,0 +1,37 @@
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+#include <cstddef>
+#include <string_view>
+
+/*
+词法分析中的批量扫描：一次处理 16 / 32 个字节
+运行时检测 CPU，AVX2 > SSE2 > 逐字节，三种实现结果完全一致
+所有函数都从 pos 开始找，返回第一个满足条件的位置，找不到返回 text.size()
+pos >= text.size() 时直接返回 pos
+*/
+namespace scan {
+
+enum class ScanLevel {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+// 当前使用的实现
+ScanLevel scan_level();
+// 强制使用某一种实现（测试用），超出 CPU 支持的级别会被降级
+void set_scan_level(ScanLevel level);
+
+// 跳过空白字符（' ' '\t' '\r' '\n'）
+size_t skip_whitespace(std::string_view text, size_t pos);
+// 跳过标识符 / 数字中的字符（字母、数字、_）
+size_t skip_identifier(std::string_view text, size_t pos);
+// 找到第一个 ch
+size_t find_byte(std::string_view text, size_t pos, char ch);
+// 找到第一个 ch1 或 ch2
+size_t find_either(std::string_view text, size_t pos, char ch1, char ch2);
+
+} // namespace scan
+
+#endif // LEXER_SCAN_H
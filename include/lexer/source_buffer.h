@@ -0,0 +1,55 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+using std::string;
+
+/*
+源代码缓冲区：词法分析直接在这块连续内存上进行，不再逐行 getline 拼接
+- 普通文件（包括被重定向到 stdin 的文件）直接 mmap，只读、零拷贝
+- 管道等无法 mmap 的输入，一次性整块读入一个预先分配好的 string
+不可拷贝，Lexer 通过 shared_ptr 持有
+*/
+class SourceBuffer {
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    // mmap 得到的区域，析构时需要 munmap
+    void *mapped_ = nullptr;
+    size_t mapped_size_ = 0;
+    // 无法 mmap 时的存储
+    string owned_;
+    // slice 出来的缓冲区引用 parent 的内存
+    std::shared_ptr<SourceBuffer> parent_;
+    SourceBuffer() = default;
+    // 尝试 mmap fd，成功返回 true
+    bool map_fd(int fd);
+    // 整块读入 fd 的全部内容，size_hint 用于预分配
+    void read_fd(int fd, size_t size_hint);
+public:
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    // mmap 一个源文件
+    static std::shared_ptr<SourceBuffer> from_file(const string &path);
+    // 读入 stdin 的全部内容（stdin 是普通文件时同样 mmap）
+    static std::shared_ptr<SourceBuffer> from_stdin();
+    // 直接使用一段字符串（测试用）
+    static std::shared_ptr<SourceBuffer> from_string(string code);
+    // parent 中 [offset, offset + length) 这一段，不拷贝
+    static std::shared_ptr<SourceBuffer> slice(std::shared_ptr<SourceBuffer> parent,
+                                               size_t offset, size_t length);
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+    // 越界时返回 ' '，相当于在末尾补了若干空白，方便词法分析向前看
+    char at(size_t pos) const { return pos < size_ ? data_[pos] : ' '; }
+};
+
+typedef std::shared_ptr<SourceBuffer> SourceBuffer_ptr;
+
+#endif // SOURCE_BUFFER_H
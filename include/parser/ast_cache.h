@@ -0,0 +1,51 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include "ast/arena.h"
+#include "ast/ast.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/*
+解析结果的二进制缓存：同一份源代码第二次编译时不再分词、解析
+- 缓存文件是 <dir>/<源代码哈希>.ast，内容是 [Header][FlatAST::serialize 的结果]
+- 命中时 mmap 缓存文件，反序列化成 FlatAST 再重建指针形式的 AST，NodeId 和解析出来的完全一样
+- 文件头里记录源代码的大小和整段数据的哈希，对不上、或者数据不合法时当作没有命中
+- 写缓存时先写临时文件再 rename，多个进程同时编译同一份代码也不会读到写了一半的文件
+缓存只是加速，读写失败都不报错
+*/
+
+// 一次解析的结果：AST 和持有它的 arena
+struct ParsedAST {
+    ASTArena arena;
+    vector<Item_ptr> items;
+    size_t node_count = 0; // NodeId 是稠密的 [0, node_count)
+};
+
+class ASTCache {
+public:
+    // AST 的结构（节点种类、FlatAST 的布局）变了就要改 FORMAT_VERSION，旧的缓存自然失效
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    // 缓存目录从这个环境变量读，没有设置时不用缓存
+    static constexpr const char *DIR_ENV = "RCOMPILER_AST_CACHE";
+
+    // dir 为空表示不用缓存
+    explicit ASTCache(string dir_) : dir(std::move(dir_)) {}
+    static ASTCache from_env();
+    bool enabled() const { return !dir.empty(); }
+
+    // 64 位 FNV-1a
+    static uint64_t hash(std::string_view data);
+    string path_for(uint64_t source_hash) const;
+    // 命中时返回重建好的 AST，否则返回 nullptr
+    std::unique_ptr<ParsedAST> load(std::string_view source) const;
+    // 把 ast 写进缓存
+    void store(std::string_view source, const ParsedAST &ast) const;
+private:
+    string dir;
+};
+
+#endif // AST_CACHE_H
@@ -2,16 +2,44 @@
 #define PARSER_H
 
 #include "lexer/lexer.h"
+#include "ast/arena.h"
 #include "ast/ast.h"
 
 class Parser {
 public:
-    // 将分词后的结果传给 Parser
-    Parser(Lexer lexer_) : lexer(lexer_) {}
+    // 借用 lexer，不拷贝；lexer 可以是分好词的，也可以是流式的
+    Parser(Lexer &lexer_) : lexer(lexer_) {}
     ~Parser() = default;
+    // 返回的节点都归这个 Parser 的 arena 所有，Parser 析构时整棵树一起释放
     vector<Item_ptr> parse();
+    // 并行解析：先按括号匹配预扫描出每个顶层 item 的 token 区间，再把相邻的 item 分成若干段，
+    // 每段用一个 Lexer 视图和自己的 Parser 在不同线程上解析，最后按源代码顺序拼起来
+    // 需要 lexer 已经一次性分完词，结果（包括 NodeId）和 parse() 完全一样
+    // token 太少、预扫描失败或者某一段解析出错时退化为 parse()，保证报出来的是第一个错误
+    // thread_count = 0 时使用硬件线程数
+    static constexpr size_t PARALLEL_MIN_CHUNK_TOKENS = 1 << 15;
+    // 源代码至少这么大时才值得先一次性分完词再并行解析
+    static constexpr size_t PARALLEL_MIN_SOURCE = 1 << 20;
+    vector<Item_ptr> parse_parallel(size_t thread_count = 0, size_t min_chunk_tokens = PARALLEL_MIN_CHUNK_TOKENS);
+    ASTArena &node_arena() { return arena; }
+    // 建树时按构造顺序给节点分配 NodeId，id 是稠密的 [0, node_count())
+    // 之后的 pass 可以按这个大小直接开 side table
+    size_t node_count() const { return next_node_id; }
 private:
-    Lexer lexer;
+    Lexer &lexer;
+    ASTArena arena;
+    size_t next_node_id = 0;
+    // 在 arena 中构造一个节点，并分配下一个 NodeId
+    template <class T, class... Args>
+    T *make(Args &&...args) {
+        T *node = arena.make<T>(std::forward<Args>(args)...);
+        node->NodeId = next_node_id++;
+        return node;
+    }
+    // 预扫描 tokens 中从 begin 开始的顶层 item，返回每个 item 的起点，最后一个是 tokens.size()
+    // const 在深度为 0 的 ; 处结束，其余的 item 在深度回到 0 的 } 处结束
+    // 遇到不是 item 开头的 token 或者括号不匹配时返回空，交给 parse() 去报错
+    static vector<size_t> find_item_borders(const vector<Token> &tokens, size_t begin);
     Item_ptr parse_item();
     FnItem_ptr parse_fn_item();
     StructItem_ptr parse_struct_item();
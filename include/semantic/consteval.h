@@ -3,8 +3,10 @@
 
 #include "lexer/lexer.h"
 #include "ast/ast.h"
+#include "ast/node_table.h"
 #include "ast/visitor.h"
 #include "semantic/decl.h"
+#include <unordered_map>
 
 struct ConstValue;
 
@@ -97,9 +99,11 @@ struct Array_ConstValue : public ConstValue {
 // 之后对于所有的 const expr queue 里面的内容 (数组大小，repeat array 的 size)
 // 每个用这个 Visitor 去 visitor 那个节点的子树即可。
 // 这样就能把数组大小，repeat array 的 size 求出来
-struct ConstItemVisitor : public AST_Walker {
+struct ConstItemVisitor : public AST_Walker<ConstItemVisitor> {
     // 将字面量转化为 ConstValue
     ConstValue_ptr parse_literal_token_to_const_value(LiteralType type, string value);
+    // number 是已经解码好的数字（只有 NUMBER 用到）
+    ConstValue_ptr parse_literal_token_to_const_value(LiteralType type, const string &value, const IntegerLiteral &number);
     // 求 一元表达式的值
     ConstValue_ptr calc_const_unary_expr(Unary_Operator OP, ConstValue_ptr right);
     // 求 二元表达式的值
@@ -120,61 +124,117 @@ struct ConstItemVisitor : public AST_Walker {
     ConstValue_ptr const_value;
 
     // 需要存 node_scope_map 来找 const_decl
-    map<size_t, Scope_ptr> &node_scope_map;
+    NodeTable<Scope_ptr> &node_scope_map;
     
     // 需要存 const_value_map 来找 const 的值
     map<ConstDecl_ptr, ConstValue_ptr> &const_value_map;
 
-    map<size_t, RealType_ptr> &type_map;
-    map<size_t, size_t> &const_expr_to_size_map;
+    NodeTable<RealType_ptr> &type_map;
+    NodeTable<size_t> &const_expr_to_size_map;
+
+    // 常量表达式里的 IdentifierExpr 绑定到的 ConstDecl
+    // 第一次用到时沿作用域查一次名字，之后直接用这里的指针
+    NodeTable<ConstDecl_ptr> const_refs;
+    ConstDecl_ptr bound_const(IdentifierExpr &node);
+    // 正在求值的 const，按嵌套的顺序，用来发现循环依赖
+    vector<ConstDecl_ptr> evaluating;
+    // 按需求 const 的值：求过的直接从 const_value_map 里取，
+    // 没求过的现在求（先递归求它用到的 const，不管定义在前面还是后面），结果记进 const_value_map
+    // 循环依赖时 CE
+    ConstValue_ptr evaluate_const(const ConstDecl_ptr &const_decl);
 
     ConstItemVisitor(bool is_need_to_calculate_,
-            map<size_t, Scope_ptr> &node_scope_map_,
+            NodeTable<Scope_ptr> &node_scope_map_,
             map<ConstDecl_ptr, ConstValue_ptr> &const_value_map_,
-            map<size_t, RealType_ptr> &type_map_,
-            map<size_t, size_t> &const_expr_to_size_map_) :
+            NodeTable<RealType_ptr> &type_map_,
+            NodeTable<size_t> &const_expr_to_size_map_) :
             is_need_to_calculate(is_need_to_calculate_),
             node_scope_map(node_scope_map_),
             const_value_map(const_value_map_),
             type_map(type_map_),
             const_expr_to_size_map(const_expr_to_size_map_) {}
-    virtual ~ConstItemVisitor() = default;
-    virtual void visit(LiteralExpr &node) override;
-    virtual void visit(IdentifierExpr &node) override;
-    virtual void visit(BinaryExpr &node) override;
-    virtual void visit(UnaryExpr &node) override;
-    virtual void visit(CallExpr &node) override;
-    virtual void visit(FieldExpr &node) override;
-    virtual void visit(StructExpr &node) override;
-    virtual void visit(IndexExpr &node) override;
-    virtual void visit(BlockExpr &node) override;
-    virtual void visit(IfExpr &node) override;
-    virtual void visit(WhileExpr &node) override;
-    virtual void visit(LoopExpr &node) override;
-    virtual void visit(ReturnExpr &node) override;
-    virtual void visit(BreakExpr &node) override;
-    virtual void visit(ContinueExpr &node) override;
-    virtual void visit(CastExpr &node) override;
-    virtual void visit(PathExpr &node) override;
-    virtual void visit(SelfExpr &node) override;
-    virtual void visit(UnitExpr &node) override;
-    virtual void visit(ArrayExpr &node) override;
-    virtual void visit(RepeatArrayExpr &node) override;
-    virtual void visit(FnItem &node) override;
-    virtual void visit(StructItem &node) override;
-    virtual void visit(EnumItem &node) override;
-    virtual void visit(ImplItem &node) override;
-    virtual void visit(ConstItem &node) override;
-    virtual void visit(LetStmt &node) override;
-    virtual void visit(ExprStmt &node) override;
-    virtual void visit(ItemStmt &node) override;
-    virtual void visit(PathType &node) override;
-    virtual void visit(ArrayType &node) override;
-    virtual void visit(UnitType &node) override;
-    virtual void visit(SelfType &node) override;
-    virtual void visit(IdentifierPattern &node) override;
+    void visit(LiteralExpr &node);
+    void visit(IdentifierExpr &node);
+    void visit(BinaryExpr &node);
+    void visit(UnaryExpr &node);
+    void visit(CallExpr &node);
+    void visit(FieldExpr &node);
+    void visit(StructExpr &node);
+    void visit(IndexExpr &node);
+    void visit(BlockExpr &node);
+    void visit(IfExpr &node);
+    void visit(WhileExpr &node);
+    void visit(LoopExpr &node);
+    void visit(ReturnExpr &node);
+    void visit(BreakExpr &node);
+    void visit(ContinueExpr &node);
+    void visit(CastExpr &node);
+    void visit(PathExpr &node);
+    void visit(SelfExpr &node);
+    void visit(UnitExpr &node);
+    void visit(ArrayExpr &node);
+    void visit(RepeatArrayExpr &node);
+    void visit(FnItem &node);
+    void visit(StructItem &node);
+    void visit(EnumItem &node);
+    void visit(ImplItem &node);
+    void visit(ConstItem &node);
+    void visit(LetStmt &node);
+    void visit(ExprStmt &node);
+    void visit(ItemStmt &node);
+    void visit(PathType &node);
+    void visit(ArrayType &node);
+    void visit(UnitType &node);
+    void visit(SelfType &node);
+    void visit(IdentifierPattern &node);
 };
 // 先 visit 整个 ast 树求出 const item
 // 然后对于数组里面要用到的常量表达式，每个用这个 Visitor 去 visitor 那个节点的子树即可。
 
+// 数组大小的常量表达式按结构去重（hash-consing），同样的 N * 2 只求一次值
+// 两个表达式"结构相同"：节点种类、运算符、字面量原文都一样，
+// 标识符解析到同一个 ConstDecl，as 的目标是同一种标量类型
+// 只有 ConstItemVisitor 能求值的那几种表达式参与去重，其余的（调用、块……）一律单独求值，报错和原来一样
+struct ConstExprTable {
+    // 标识符用求值的 visitor 绑定好的 ConstDecl
+    ConstItemVisitor &evaluator;
+    NodeTable<RealType_ptr> &type_map;
+    // 哈希值相同的放在同一个桶里，桶里再逐个比较结构：(代表的表达式, 求出来的大小)
+    std::unordered_map<size_t, vector<pair<Expr_ptr, size_t>>> buckets;
+    ConstExprTable(ConstItemVisitor &evaluator_, NodeTable<RealType_ptr> &type_map_)
+        : evaluator(evaluator_), type_map(type_map_) {}
+    // 结构哈希，不能参与去重时返回 false
+    bool hash(Expr_ptr expr, size_t &h);
+    bool equal(Expr_ptr a, Expr_ptr b);
+    // 找一个结构相同、已经求过的表达式，找到了返回它的大小，否则返回 nullptr
+    const size_t *find(Expr_ptr expr, size_t h);
+    void insert(Expr_ptr expr, size_t h, size_t size) { buckets[h].emplace_back(expr, size); }
+private:
+    ConstDecl_ptr resolve(IdentifierExpr &node);
+    // as 的目标类型，只接受标量类型，返回 nullptr 表示不能参与去重
+    RealType_ptr scalar_target(CastExpr &node);
+};
+
+// 放在 FusedWalker 里求 const item 的 pass
+// 遍历时只记下所有的 ConstItem，遍历结束后 evaluate_all 按 AST 顺序按需求值：
+// 这时所有 as 的目标类型都已经被同一次遍历里的 OtherTypeAndRepeatArrayVisitor 解析好了，
+// 一个 const 用到后面定义的 const 也没有问题
+// evaluator 之后接着用来求 const_expr_queue 里的表达式
+struct ConstItemPass : public FusablePass {
+    ConstItemVisitor evaluator;
+    vector<ConstItem *> const_items;
+    ConstItemPass(NodeTable<Scope_ptr> &node_scope_map_,
+            map<ConstDecl_ptr, ConstValue_ptr> &const_value_map_,
+            NodeTable<RealType_ptr> &type_map_,
+            NodeTable<size_t> &const_expr_to_size_map_) :
+            evaluator(false, node_scope_map_, const_value_map_, type_map_, const_expr_to_size_map_) {}
+    using FusablePass::leave;
+    void leave(ConstItem &node) { const_items.push_back(&node); }
+    void evaluate_all() {
+        for (ConstItem *node : const_items) {
+            evaluator.visit(*node);
+        }
+    }
+};
+
 #endif // CONSTEVAL_H
\ No newline at end of file
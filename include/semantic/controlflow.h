@@ -3,6 +3,7 @@
 
 #include <bitset>
 #include "ast/ast.h"
+#include "ast/node_table.h"
 #include "ast/visitor.h"
 
 // 控制流分析
@@ -33,49 +34,57 @@ OutcomeState while_outcome_state(const OutcomeState &Condition, const OutcomeSta
 // loop 的 OutcomeState
 OutcomeState loop_outcome_state(const OutcomeState &body);
 
-struct ControlFlowVisitor : public AST_Walker {
+struct ControlFlowVisitor : public FusablePass {
     // 这个 visitor 用来做控制流分析
     // 主要是分析 if while loop 的分支是否都返回
     // 以及 return break continue 的 diverge 情况
+    // 每个节点的结果都在 leave 的时候由子节点的结果算出来，可以和别的 pass 放在同一次遍历里
     size_t loop_depth;
-    map<size_t, OutcomeState> &node_outcome_state_map;
-    ControlFlowVisitor(map<size_t, OutcomeState> &node_outcome_state_map_) :
+    // 进入 fn 的时候 loop_depth 归零，这里存外面的 loop_depth
+    vector<size_t> outer_loop_depth;
+    NodeTable<OutcomeState> &node_outcome_state_map;
+    ControlFlowVisitor(NodeTable<OutcomeState> &node_outcome_state_map_) :
         loop_depth(0), node_outcome_state_map(node_outcome_state_map_) {}
-    virtual ~ControlFlowVisitor() = default;
-    virtual void visit(LiteralExpr &node) override;
-    virtual void visit(IdentifierExpr &node) override;
-    virtual void visit(BinaryExpr &node) override;
-    virtual void visit(UnaryExpr &node) override;
-    virtual void visit(CallExpr &node) override;
-    virtual void visit(FieldExpr &node) override;
-    virtual void visit(StructExpr &node) override;
-    virtual void visit(IndexExpr &node) override;
-    virtual void visit(BlockExpr &node) override;
-    virtual void visit(IfExpr &node) override;
-    virtual void visit(WhileExpr &node) override;
-    virtual void visit(LoopExpr &node) override;
-    virtual void visit(ReturnExpr &node) override;
-    virtual void visit(BreakExpr &node) override;
-    virtual void visit(ContinueExpr &node) override;
-    virtual void visit(CastExpr &node) override;
-    virtual void visit(PathExpr &node) override;
-    virtual void visit(SelfExpr &node) override;
-    virtual void visit(UnitExpr &node) override;
-    virtual void visit(ArrayExpr &node) override;
-    virtual void visit(RepeatArrayExpr &node) override;
-    virtual void visit(FnItem &node) override;
-    virtual void visit(StructItem &node) override;
-    virtual void visit(EnumItem &node) override;
-    virtual void visit(ImplItem &node) override;
-    virtual void visit(ConstItem &node) override;
-    virtual void visit(LetStmt &node) override;
-    virtual void visit(ExprStmt &node) override;
-    virtual void visit(ItemStmt &node) override;
-    virtual void visit(PathType &node) override;
-    virtual void visit(ArrayType &node) override;
-    virtual void visit(UnitType &node) override;
-    virtual void visit(SelfType &node) override;
-    virtual void visit(IdentifierPattern &node) override;
+    using FusablePass::enter;
+    void enter(WhileExpr &node);
+    void enter(LoopExpr &node);
+    void enter(BreakExpr &node);
+    void enter(ContinueExpr &node);
+    void enter(FnItem &node);
+    void leave(LiteralExpr &node);
+    void leave(IdentifierExpr &node);
+    void leave(BinaryExpr &node);
+    void leave(UnaryExpr &node);
+    void leave(CallExpr &node);
+    void leave(FieldExpr &node);
+    void leave(StructExpr &node);
+    void leave(IndexExpr &node);
+    void leave(BlockExpr &node);
+    void leave(IfExpr &node);
+    void leave(WhileExpr &node);
+    void leave(LoopExpr &node);
+    void leave(ReturnExpr &node);
+    void leave(BreakExpr &node);
+    void leave(ContinueExpr &node);
+    void leave(CastExpr &node);
+    void leave(PathExpr &node);
+    void leave(SelfExpr &node);
+    void leave(UnitExpr &node);
+    void leave(ArrayExpr &node);
+    void leave(RepeatArrayExpr &node);
+    void leave(FnItem &node);
+    void leave(StructItem &node);
+    void leave(EnumItem &node);
+    void leave(ImplItem &node);
+    void leave(ConstItem &node);
+    void leave(LetStmt &node);
+    void leave(ExprStmt &node);
+    void leave(ItemStmt &node);
+    void leave(PathType &node);
+    void leave(ArrayType &node);
+    void leave(UnitType &node);
+    void leave(SelfType &node);
+    void leave(IdentifierPattern &node);
 };
 
 #endif // CONTROLFLOW_H
\ No newline at end of file
@@ -124,6 +124,6 @@ struct LetDecl : public ValueDecl {
 
 // 找到 scope 里面的 const_decl
 // 找不到返回 nullptr
-ConstDecl_ptr find_const_decl(Scope_ptr NowScope, string name);
+ConstDecl_ptr find_const_decl(Scope_ptr NowScope, const string &name);
 
 #endif // DECL_H
@@ -0,0 +1,61 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "ast/ast.h"
+#include "ast/flat_ast.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/*
+增量语义检查：每个顶层 item 一个指纹，指纹没变的 item 之前检查通过过，这次可以不再检查
+- 一个 item 第四步的检查只看自己的代码和它用到的顶层声明的"接口"：
+    fn     : 签名（receiver、参数的 pattern 和类型、返回类型），不包括函数体
+    struct : 整个 struct 定义，加上所有 impl 里的方法签名和关联常量
+    enum   : 整个 enum 定义
+    const  : 整个 const 定义（类型和值）
+- item 的依赖：它的子树里出现过的所有名字中，是顶层声明的那些；
+  接口里又出现了别的顶层声明（比如签名里的结构体、常量表达式里的常量）也算，一直取到闭包
+  名字相同就算依赖，不区分局部变量、字段名，多算只会多检查，不会漏
+- 指纹 = hash(item 自己的结构) + 每个依赖的 (名字, 接口的 hash)，按名字排序
+  结构的 hash 不包括 NodeId，前面的 item 变了也不影响后面 item 的指纹
+  某个名字从不是顶层声明变成了顶层声明，依赖的集合变了，指纹也会变
+*/
+
+struct ItemDependencies {
+    // 和 items 一一对应
+    vector<uint64_t> fingerprints;
+    // 每个 item 依赖的顶层声明的名字（闭包），按名字排序
+    vector<vector<string>> dependencies;
+
+    static ItemDependencies compute(const vector<Item_ptr> &items);
+};
+
+/*
+检查通过的 item 的指纹，存在磁盘上，下一次编译时读回来
+- 文件是 <dir>/checked_items，内容是 [Header][排好序的 u64 指纹...]
+- 和 ASTCache 一样：头部对不上、数据不完整时当作空的；先写临时文件再 rename；读写失败都不报错
+*/
+class CheckedItemCache {
+public:
+    // 检查的规则变了（新的 CE、接口的定义变了）就要改 FORMAT_VERSION，旧的记录自然失效
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    // 目录从这个环境变量读，没有设置时不用缓存
+    static constexpr const char *DIR_ENV = "RCOMPILER_CHECK_CACHE";
+
+    // dir 为空表示不用缓存
+    explicit CheckedItemCache(string dir_) : dir(std::move(dir_)) {}
+    static CheckedItemCache from_env();
+    bool enabled() const { return !dir.empty(); }
+
+    std::unordered_set<uint64_t> load() const;
+    // 用这一次检查通过的 item 覆盖原来的记录
+    void store(const vector<uint64_t> &fingerprints) const;
+private:
+    string dir;
+    string path() const;
+};
+
+#endif // INCREMENTAL_H
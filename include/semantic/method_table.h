@@ -0,0 +1,43 @@
+#ifndef METHOD_TABLE_H
+#define METHOD_TABLE_H
+
+#include "lexer/interner.h"
+#include "semantic/decl.h"
+#include "semantic/type.h"
+#include <cstdint>
+#include <unordered_map>
+
+/*
+方法 / 关联函数的索引：类型 -> 方法名 -> FnDecl
+- 第一层是方法所属的类型：内置类型按 RealTypeKind 区分，结构体按 StructDecl 区分
+- 第二层的方法名先用 SymbolInterner intern 成 id，查找时只 find 一次名字，不会为没见过的名字分配 id
+- 内置方法和结构体的方法走同一条查找路径，都是两次哈希
+- 同一个 (类型, 方法名) 登记多次时保留第一个（和原来线性查找找到的一样）
+*/
+
+class MethodTable {
+public:
+    explicit MethodTable(SymbolInterner &symbols_) : symbols(symbols_) {}
+    // 内置类型的方法，kind 不能是 STRUCT
+    void add(RealTypeKind kind, const string &name, FnDecl_ptr decl);
+    // 结构体的方法
+    void add(const StructDecl *owner, const string &name, FnDecl_ptr decl);
+    // base_type 的 name 方法，没有返回 nullptr（引用修饰不影响查找）
+    FnDecl_ptr find(const RealType_ptr &base_type, const string &name) const;
+private:
+    struct Owner {
+        RealTypeKind kind;
+        const StructDecl *decl; // 不是结构体时为 nullptr
+        bool operator==(const Owner &other) const { return kind == other.kind && decl == other.decl; }
+    };
+    struct OwnerHash {
+        size_t operator()(const Owner &owner) const {
+            return std::hash<const void *>()(owner.decl) * 31 + static_cast<size_t>(owner.kind);
+        }
+    };
+    SymbolInterner &symbols;
+    std::unordered_map<Owner, std::unordered_map<uint32_t, FnDecl_ptr>, OwnerHash> table;
+    void add(Owner owner, const string &name, FnDecl_ptr decl);
+};
+
+#endif // METHOD_TABLE_H
@@ -2,10 +2,14 @@
 #define SEMANTIC_CHECKER_H
 
 
+#include "ast/arena.h"
 #include "ast/ast.h"
+#include "ast/node_table.h"
 #include "semantic/decl.h"
 #include "semantic/type.h"
 #include "semantic/consteval.h"
+#include "semantic/incremental.h"
+#include "semantic/method_table.h"
 #include "semantic/typecheck.h"
 #include <cstddef>
 #include <tuple>
@@ -16,23 +20,26 @@ struct Semantic_Checker {
 
     // 记录 AST 节点对应的作用域
     // 使用 NodeId 作为 key
-    map<size_t, Scope_ptr> node_scope_map;
+    NodeTable<Scope_ptr> node_scope_map;
+
+    // 所有的 RealType 都从这里拿，相同的类型是同一个对象
+    TypeContext types;
 
     // 记录 AST 的 Type 对应的真正的类型 RealType
     // 使用 NodeId 作为 key
-    map<size_t, RealType_ptr> type_map;
+    NodeTable<RealType_ptr> type_map;
 
     // 每个 FnItem 对应的语义声明，key 为 FnItem 的 NodeId
-    map<size_t, FnDecl_ptr> fn_item_to_decl_map;
+    NodeTable<FnDecl_ptr> fn_item_to_decl_map;
 
     // 每个函数调用表达式最终绑定到的 FnDecl
-    map<size_t, FnDecl_ptr> call_expr_to_decl_map;
+    NodeTable<FnDecl_ptr> call_expr_to_decl_map;
 
     // 每个 IdentifierExpr 最终解析到的 ValueDecl
-    map<size_t, ValueDecl_ptr> identifier_expr_to_decl_map;
+    NodeTable<ValueDecl_ptr> identifier_expr_to_decl_map;
 
     // 每个 LetStmt AST 节点对应的 LetDecl
-    map<size_t, LetDecl_ptr> let_stmt_to_decl_map;
+    NodeTable<LetDecl_ptr> let_stmt_to_decl_map;
 
     // 在第二步解析类型的时候，数组大小的表达式还没有被解析
     // 第三步的时候，let 语句的数组大小表达式以及 repeat array 的 size 表达式需要被解析
@@ -42,22 +49,19 @@ struct Semantic_Checker {
     // 记录 Expr 对应的 size
     // 需要记录的数组大小只记录 ast 树上的节点
     // 在第三步解析完常量表达式之后，把 ast 树上的节点放在这里面
-    map<size_t, size_t> const_expr_to_size_map;
+    NodeTable<size_t> const_expr_to_size_map;
 
     // 记录 const_decl 对应的 const_value
     map<ConstDecl_ptr, ConstValue_ptr> const_value_map;
 
     // 记录每个 AST 树节点的 OutComeState
-    map<size_t, OutcomeState> node_outcome_state_map;
+    NodeTable<OutcomeState> node_outcome_state_map;
 
     // AST 树的所有 item 节点
     vector<Item_ptr> &items;
 
     // 每个表达式节点的 RealType 和 PlaceKind
-    map<size_t, pair<RealType_ptr, PlaceKind>> node_type_and_place_kind_map;
-
-    // 记录每个 Scope 的局部变量
-    map<Scope_ptr, Local_Variable_map> scope_local_variable_map;
+    NodeTable<pair<RealType_ptr, PlaceKind>> node_type_and_place_kind_map;
 
     // 内置方法 e.g. array.len()
     // (类型, 方法名, 方法的 FnDecl)
@@ -67,9 +71,48 @@ struct Semantic_Checker {
     // 内置关联函数 e.g. String::from()
     vector<std::tuple<RealTypeKind, string, FnDecl_ptr>> builtin_associated_funcs;
 
-    Semantic_Checker(vector<Item_ptr> &items_);
+    // 方法名 intern 在这里，第四步只读
+    SymbolInterner symbols;
+
+    // 类型 -> 方法名 -> FnDecl 的索引，内置的和结构体的都在里面
+    // 结构体的在第二步登记 impl 时加入，内置的在 add_builtin_methods_and_associated_funcs 最后加入
+    MethodTable method_table;
+    MethodTable associated_func_table;
+
+    // 内置函数参数的 pattern 不在 AST 树上，由这里持有
+    ASTArena builtin_nodes;
+
+    // 第四步最多用几个线程，0 表示硬件线程数
+    // 顶层 item 少于 step4_min_items 个时不值得开线程，顺序检查
+    static constexpr size_t STEP4_PARALLEL_MIN_ITEMS = 64;
+    size_t step4_thread_count = 0;
+    size_t step4_min_items = STEP4_PARALLEL_MIN_ITEMS;
+
+    // 增量检查，只判断能不能通过编译的时候用（见 semantic/incremental.h）
+    // 指纹在 checked_items 里的顶层 item 之前检查通过过，自己和依赖的声明都没变，第四步跳过它
+    // 跳过的 item 没有第四步的结果，之后要生成 IR 时不能设置
+    const std::unordered_set<uint64_t> *checked_items = nullptr;
+    // 设置了 checked_items 时在检查之前算出每个 item 的依赖和指纹
+    ItemDependencies item_dependencies;
+    // 第四步检查通过或者跳过的 item 的指纹，出错时是出错的 item 之前的那些
+    vector<uint64_t> passed_items;
+
+    // node_count 是 Parser::node_count()，用来一次开好所有 NodeTable，不知道的话可以不给
+    Semantic_Checker(vector<Item_ptr> &items_, size_t node_count = 0);
     // 总的 checker
-    // 分为 4 步
+    // 分为 4 步，一共只遍历 AST 三次（step1、step3、step4 各一次）
+    /*
+    各次遍历之间的依赖，也就是为什么不能再合并：
+    - step1 的 ScopeBuilder_Visitor 必须单独遍历：step2 要在完整的作用域树上解析类型
+      （类型可以在定义之前使用），step3 的所有 pass 都要用 node_scope_map 和 step2 的结果
+    - step3 的 OtherTypeAndRepeatArrayVisitor、ConstItemPass、ControlFlowVisitor、ArrayTypeVisitor 合在一次遍历：
+      * ControlFlowVisitor 只用到子节点自己的结果，和别的 pass 无关
+      * ConstItemPass 遍历时只记下 ConstItem，遍历结束、所有 as 的目标类型都解析好之后再按需求值
+      * ArrayTypeVisitor 的大小要等遍历结束、const_expr_queue 收集全并求完之后才知道，
+        所以遍历时只记下 ArrayType 节点，最后再填回去
+    - step4 的 ExprTypeAndLetStmtVisitor 必须单独遍历：它用到所有数组的大小
+      （比如在 struct 定义之前使用这个 struct 的数组字段）、所有节点的 OutcomeState
+    */
     void checker();
     // step1 : 建作用域树 + 符号初收集
     void step1_build_scopes_and_collect_symbols();
@@ -84,17 +127,23 @@ struct Semantic_Checker {
     // 处理出所有 let 的 type（除了数组大小）
     // 常量表达式（数组大小，repeat array 的 size）
     // 控制流分析
+    // 补全 ArrayType 的大小
     void step3_constant_evaluation_and_control_flow_analysis();
     // step4:
     // 求出所有表达式的 RealType
     // 以及是否可读，是否可写的性质
     // 引入 let 语句
     // 这样就完成了全部的 semantic check
+    // 到这里全局的声明、类型、常量都定下来了，各个顶层 item 互不依赖：
+    // 每个线程一个 visitor，从共享的下标里取 item 检查，结果写进自己的表，全部结束之后再合并进来
+    // 报出来的错误和顺序检查时一样，是出错的 item 里最靠前的那个
     void step4_expr_type_and_let_stmt_analysis();
     // 添加内置函数
     void add_builtin_methods_and_associated_funcs();
     // 遍历 scope
     void Scope_dfs_and_build_type(Scope_ptr scope);
+    // 第三步填好数组大小之后，把各个 Decl 里面还没定下大小的数组类型换成 TypeContext 里唯一的那个
+    void intern_scope_types(Scope_ptr scope);
 };
 // 用来记录 AST 节点对应的作用域
 
@@ -0,0 +1,45 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include "lexer/interner.h"
+#include "semantic/decl.h"
+#include "semantic/scope.h"
+#include <cstdint>
+
+/*
+第四步解析标识符用的符号表
+- 名字先用 SymbolInterner（和 Lexer 同一个）intern 成稠密的 id，之后的比较、查表都只用整数
+- ScopedSymbolTable 只记录"当前位置能看到的"值：每个 id 一个最新的绑定
+  进入作用域时绑定这个作用域的 item（fn const），let 按出现的顺序绑定，遮住外面同名的
+  离开作用域时按撤销日志把被遮住的绑定恢复回来
+  所以查一个标识符就是一次 find（一次哈希）加一次数组下标，不用沿着作用域链一层层找
+- 和原来沿作用域链查找的结果一样：同一个作用域里 let 优先于 item，内层的 item 优先于外层的 let
+*/
+
+class ScopedSymbolTable {
+public:
+    explicit ScopedSymbolTable(SymbolInterner &symbols_) : symbols(symbols_) {}
+    // 把当前作用域切换到 scope：先离开不是 scope 祖先的作用域，再依次进入到 scope 为止
+    // AST 是按顺序遍历的，离开的作用域之后不会再回来
+    void enter(Scope *scope);
+    // 在当前作用域绑定一个值，遮住之前的同名绑定
+    void bind(uint32_t symbol, ValueDecl_ptr decl);
+    // 当前能看到的 symbol 的值，没有返回 nullptr（symbol 可以是 SymbolInterner::NO_SYMBOL）
+    ValueDecl_ptr lookup(uint32_t symbol) const {
+        return symbol < bindings.size() ? bindings[symbol] : nullptr;
+    }
+    Scope *current_scope() const { return active.empty() ? nullptr : active.back().scope; }
+private:
+    struct ActiveScope {
+        Scope *scope;
+        size_t undo_mark; // 进入这个作用域时撤销日志的长度
+    };
+    SymbolInterner &symbols;
+    vector<ActiveScope> active; // active[i] 的深度就是 i
+    vector<ValueDecl_ptr> bindings; // 下标是 symbol id
+    vector<pair<uint32_t, ValueDecl_ptr>> undo_log; // (symbol, 被遮住的绑定)
+    void push(Scope *scope);
+    void pop();
+};
+
+#endif // SYMBOL_TABLE_H
@@ -2,10 +2,13 @@
 #define TYPE_H
 
 #include "ast/ast.h"
+#include "ast/node_table.h"
 #include "ast/visitor.h"
 #include "semantic/decl.h"
 #include <cstddef>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 using std::shared_ptr;
 struct RealType;
@@ -155,56 +158,71 @@ struct FunctionRealType : public RealType {
     virtual string show_real_type_info() override;
 };
 
+/*
+类型上下文：每种不同的类型 (kind, is_ref, element, size, decl) 只建一个对象
+- 从这里拿到的类型都不可变，两个类型相同当且仅当指针相同，换引用修饰用 with_ref，不再深拷贝
+- 没有内部结构的类型（UNIT NEVER BOOL 各种整数 CHAR STR STRING）和上下文无关，primitive 整个进程共用
+- 数组、结构体、枚举、函数按 (元素类型指针, 大小) 或者 decl 指针区分，存在 TypeContext 里，
+  生命周期跟着持有 decl 的 Semantic_Checker
+- 例外：第二轮从 AST 解析出来的数组类型要等常量求完才知道大小，先用 pending_array 建一个独立的对象（size_expr 非空），
+  fill_array_sizes 填好大小之后再用 intern 换成唯一的那个
+- 可以被多个线程同时使用（第四步并行检查函数体）
+*/
+class TypeContext {
+public:
+    static RealType_ptr primitive(RealTypeKind kind, ReferenceType ref = ReferenceType::NO_REF);
+    RealType_ptr array(RealType_ptr element_type, size_t size, ReferenceType ref = ReferenceType::NO_REF);
+    RealType_ptr pending_array(RealType_ptr element_type, Expr_ptr size_expr, ReferenceType ref);
+    RealType_ptr struct_type(StructDecl_ptr decl, ReferenceType ref = ReferenceType::NO_REF);
+    RealType_ptr enum_type(EnumDecl_ptr decl, ReferenceType ref = ReferenceType::NO_REF);
+    RealType_ptr function_type(FnDecl_ptr decl, ReferenceType ref = ReferenceType::NO_REF);
+    // 同一个类型换成 ref 的引用修饰
+    RealType_ptr with_ref(RealType_ptr type, ReferenceType ref);
+    // 唯一的那个对象，type 可以是 pending 的数组或者不是从这里建出来的类型
+    RealType_ptr intern(RealType_ptr type) { return with_ref(type, type->is_ref); }
+private:
+    struct Key {
+        RealTypeKind kind;
+        ReferenceType ref;
+        const void *inner; // 元素类型或者 decl
+        size_t size;
+        bool operator==(const Key &other) const = default;
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+    std::unordered_map<Key, RealType_ptr, KeyHash> composite_types;
+    // 第四步多个线程同时检查函数体，查表和插入都要加锁
+    std::mutex mutex;
+    // 找 key 对应的类型，没有的话用 make() 建一个
+    template <class Make>
+    RealType_ptr find_or_make(const Key &key, Make make);
+};
+
 // 根据 AST 的 Type 找到真正的类型 RealType，并且返回指针
 // 存放在 map 中，这样后面 let 语句遇到的时候使用这个，直接 find_real_type 即可
-RealType_ptr find_real_type(Scope_ptr current_scope, Type_ptr type_ast, map<size_t, RealType_ptr> &type_map, vector<Expr_ptr> &const_expr_queue);
+RealType_ptr find_real_type(Scope_ptr current_scope, Type_ptr type_ast, NodeTable<RealType_ptr> &type_map, vector<Expr_ptr> &const_expr_queue, TypeContext &types);
 
 
 // 遍历 AST 树，将其他类型的 type 解析出来
 // 遇到 let 语句， As 语句，PathExpr 语句，StructExpr 语句
 // 将 RealType 解析出来，并且存到 type_map 中，这样第四步直接查 type_map 即可 
 // 遇到 type 和 RepeatArray 中的常量表达式，放入 const_expr_queue
-struct OtherTypeAndRepeatArrayVisitor : public AST_Walker {
-    map<size_t, Scope_ptr> &node_scope_map;
-    map<size_t, RealType_ptr> &type_map;
+// 各个节点只看自己，不依赖别的 pass 的结果，可以放进 FusedWalker
+struct OtherTypeAndRepeatArrayVisitor : public FusablePass {
+    NodeTable<Scope_ptr> &node_scope_map;
+    NodeTable<RealType_ptr> &type_map;
     vector<Expr_ptr> &const_expr_queue;
-    OtherTypeAndRepeatArrayVisitor(map<size_t, Scope_ptr> &node_scope_map_, map<size_t, RealType_ptr> &type_map_, vector<Expr_ptr> &const_expr_queue_)
-        : node_scope_map(node_scope_map_), type_map(type_map_), const_expr_queue(const_expr_queue_) {}
-    virtual ~OtherTypeAndRepeatArrayVisitor() = default;
-    virtual void visit(LiteralExpr &node) override;
-    virtual void visit(IdentifierExpr &node) override;
-    virtual void visit(BinaryExpr &node) override;
-    virtual void visit(UnaryExpr &node) override;
-    virtual void visit(CallExpr &node) override;
-    virtual void visit(FieldExpr &node) override;
-    virtual void visit(StructExpr &node) override;
-    virtual void visit(IndexExpr &node) override;
-    virtual void visit(BlockExpr &node) override;
-    virtual void visit(IfExpr &node) override;
-    virtual void visit(WhileExpr &node) override;
-    virtual void visit(LoopExpr &node) override;
-    virtual void visit(ReturnExpr &node) override;
-    virtual void visit(BreakExpr &node) override;
-    virtual void visit(ContinueExpr &node) override;
-    virtual void visit(CastExpr &node) override;
-    virtual void visit(PathExpr &node) override;
-    virtual void visit(SelfExpr &node) override;
-    virtual void visit(UnitExpr &node) override;
-    virtual void visit(ArrayExpr &node) override;
-    virtual void visit(RepeatArrayExpr &node) override;
-    virtual void visit(FnItem &node) override;
-    virtual void visit(StructItem &node) override;
-    virtual void visit(EnumItem &node) override;
-    virtual void visit(ImplItem &node) override;
-    virtual void visit(ConstItem &node) override;
-    virtual void visit(LetStmt &node) override;
-    virtual void visit(ExprStmt &node) override;
-    virtual void visit(ItemStmt &node) override;
-    virtual void visit(PathType &node) override;
-    virtual void visit(ArrayType &node) override;
-    virtual void visit(UnitType &node) override;
-    virtual void visit(SelfType &node) override;
-    virtual void visit(IdentifierPattern &node) override;
+    TypeContext &types;
+    OtherTypeAndRepeatArrayVisitor(NodeTable<Scope_ptr> &node_scope_map_, NodeTable<RealType_ptr> &type_map_, vector<Expr_ptr> &const_expr_queue_, TypeContext &types_)
+        : node_scope_map(node_scope_map_), type_map(type_map_), const_expr_queue(const_expr_queue_), types(types_) {}
+    using FusablePass::enter;
+    using FusablePass::leave;
+    void leave(StructExpr &node);
+    void leave(CastExpr &node);
+    void leave(PathExpr &node);
+    void enter(RepeatArrayExpr &node);
+    void enter(LetStmt &node);
 };
 
 #endif // TYPE_H
\ No newline at end of file
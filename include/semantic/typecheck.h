@@ -2,9 +2,12 @@
 #define TYPECHECK_H
 
 #include "ast/ast.h"
+#include "ast/node_table.h"
 #include "ast/visitor.h"
 #include "semantic/decl.h"
 #include "semantic/scope.h"
+#include "semantic/method_table.h"
+#include "semantic/symbol_table.h"
 #include "semantic/type.h"
 #include "semantic/controlflow.h"
 #include <cstddef>
@@ -16,11 +19,6 @@ type visitor:
 不用考虑：类型的 RealType，Repeat Array 的 size
 存入 map<AST_Node_ptr, RealType_ptr> node_type_map
 */
-// 每个 Scope 应该对应一个 Local_Variable_map
-// 即 scope_local_variable_map
-// 这样在查找 identifier 的时候，先查 local 变量，再查 value_namespace
-using Local_Variable_map = map<string, LetDecl_ptr>;
-
 enum class PlaceKind {
     NotPlace, // 纯右值（字面量、算术、函数返回、结构体字面量等）
     ReadOnlyPlace, // 不可变的左值（不可变变量、字段访问、数组索引等）
@@ -34,8 +32,9 @@ Never 可以和任何类型合并，结果为另一个类型
 AnyInt 可以和任何整数类型合并，结果为另一个整数类型
 支持 &mut T 和 &T 的隐式转换，结果为 &T
 如果 是赋值操作 left = right，则 &T 不能赋值给 &mut T
+结果从 types 里拿，相同的类型直接返回
 */
-RealType_ptr type_merge(RealType_ptr left, RealType_ptr right, bool is_assignment = false);
+RealType_ptr type_merge(TypeContext &types, RealType_ptr left, RealType_ptr right, bool is_assignment = false);
 
 /*
 Anyint 可以合并的内容：
@@ -43,61 +42,36 @@ Never, Anyint, 各种 int
 */
 bool type_is_number(RealType_ptr checktype);
 
-RealType_ptr type_of_literal(LiteralType type, string value);
-
-// 深拷贝一个 RealType
-RealType_ptr copy(RealType_ptr type);
+RealType_ptr type_of_literal(const LiteralExpr &literal);
 
 // 第二轮处理出了所有 Type，但是 Array Type 只存了 ast 节点，没存真正大小
-// 遍历一遍所有的 Array Type，利用 const_expr_to_size_map 把大小填回去
-struct ArrayTypeVisitor : public AST_Walker {
+// 利用 const_expr_to_size_map 把所有 Array Type 的大小填回去
+// 大小要等常量表达式都求完才知道，而常量表达式要等 OtherTypeAndRepeatArrayVisitor 遍历完才收集全，
+// 所以遍历的时候只记下 ArrayType 节点（可以和其他 pass 放在同一次遍历里），之后再调用 fill_array_sizes
+struct ArrayTypeVisitor : public FusablePass {
     // 记录 AST 的 Type 对应的真正的类型 RealType
-    map<size_t, RealType_ptr> &type_map;
+    NodeTable<RealType_ptr> &type_map;
     // 记录 Expr 对应的 size
-    map<size_t, size_t> &const_expr_to_size_map;
+    NodeTable<size_t> &const_expr_to_size_map;
+
+    TypeContext &types;
 
-    ArrayTypeVisitor(map<size_t, RealType_ptr> &type_map_,
-            map<size_t, size_t> &const_expr_to_size_map_) :
+    ArrayTypeVisitor(NodeTable<RealType_ptr> &type_map_,
+            NodeTable<size_t> &const_expr_to_size_map_,
+            TypeContext &types_) :
             type_map(type_map_),
-            const_expr_to_size_map(const_expr_to_size_map_) {}
-    virtual ~ArrayTypeVisitor() = default;
-    virtual void visit(LiteralExpr &node) override;
-    virtual void visit(IdentifierExpr &node) override;
-    virtual void visit(BinaryExpr &node) override;
-    virtual void visit(UnaryExpr &node) override;
-    virtual void visit(CallExpr &node) override;
-    virtual void visit(FieldExpr &node) override;
-    virtual void visit(StructExpr &node) override;
-    virtual void visit(IndexExpr &node) override;
-    virtual void visit(BlockExpr &node) override;
-    virtual void visit(IfExpr &node) override;
-    virtual void visit(WhileExpr &node) override;
-    virtual void visit(LoopExpr &node) override;
-    virtual void visit(ReturnExpr &node) override;
-    virtual void visit(BreakExpr &node) override;
-    virtual void visit(ContinueExpr &node) override;
-    virtual void visit(CastExpr &node) override;
-    virtual void visit(PathExpr &node) override;
-    virtual void visit(SelfExpr &node) override;
-    virtual void visit(UnitExpr &node) override;
-    virtual void visit(ArrayExpr &node) override;
-    virtual void visit(RepeatArrayExpr &node) override;
-    virtual void visit(FnItem &node) override;
-    virtual void visit(StructItem &node) override;
-    virtual void visit(EnumItem &node) override;
-    virtual void visit(ImplItem &node) override;
-    virtual void visit(ConstItem &node) override;
-    virtual void visit(LetStmt &node) override;
-    virtual void visit(ExprStmt &node) override;
-    virtual void visit(ItemStmt &node) override;
-    virtual void visit(PathType &node) override;
-    virtual void visit(ArrayType &node) override;
-    virtual void visit(UnitType &node) override;
-    virtual void visit(SelfType &node) override;
-    virtual void visit(IdentifierPattern &node) override;
+            const_expr_to_size_map(const_expr_to_size_map_),
+            types(types_) {}
+    // 遍历时遇到的 ArrayType 节点
+    vector<ArrayType_ptr> array_types;
+
+    using FusablePass::enter;
+    void enter(ArrayType &node) { array_types.push_back(&node); }
+    // 常量表达式都求完之后调用，填好大小之后 type_map 里的数组类型换成 TypeContext 里唯一的那个
+    void fill_array_sizes();
 };
 
-struct ExprTypeAndLetStmtVisitor : public AST_Walker {
+struct ExprTypeAndLetStmtVisitor : public AST_Walker<ExprTypeAndLetStmtVisitor> {
     /*
     遇到 A::B 和 A.B 有两种可能
     A::B 可能是 enum 的 variant，也可能是 struct 的关联函数
@@ -110,25 +84,28 @@ struct ExprTypeAndLetStmtVisitor : public AST_Walker {
     有可能是 value_namespace 里面的 const fn 和 let 变量
     fn 是 require_function = true
     let 变量是 require_function = false
-    每个 scope 有一个 local，先查 local 再查 value_namespace，local 允许重名，直接覆盖
+    let 变量和 value_namespace 都放在 ScopedSymbolTable 里，按遍历顺序绑定，后面的 let 遮住前面的同名值
+    查找就是在 symbol_table 里查一次
     */
     // 是否要求是函数类型
     bool require_function;
     // 存放每个表达式节点的 RealType 和 PlaceKind
-    map<size_t, pair<RealType_ptr, PlaceKind>> &node_type_and_place_kind_map;
+    NodeTable<pair<RealType_ptr, PlaceKind>> &node_type_and_place_kind_map;
     // 记录 IdentifierExpr 解析到的 ValueDecl
-    map<size_t, ValueDecl_ptr> &identifier_expr_to_decl_map;
+    NodeTable<ValueDecl_ptr> &identifier_expr_to_decl_map;
     // 记录 LetStmt 对应的 LetDecl
-    map<size_t, LetDecl_ptr> &let_stmt_to_decl_map;
+    NodeTable<LetDecl_ptr> &let_stmt_to_decl_map;
     // 存放每个节点对应的作用域
-    map<size_t, Scope_ptr> &node_scope_map;
+    const NodeTable<Scope_ptr> &node_scope_map;
     // 存放每个 AST 的 Type 对应的 RealType，直接复制过来即可
-    map<size_t, RealType_ptr> &type_map;
-    // 记录每个 Scope 的局部变量
-    map<Scope_ptr, Local_Variable_map> &scope_local_variable_map;
+    const NodeTable<RealType_ptr> &type_map;
+    // 当前位置能看到的 let 变量和 value_namespace 里的值
+    // 每个 visitor 一份，并行检查的时候互不影响
+    SymbolInterner symbols;
+    ScopedSymbolTable symbol_table;
 
     // 遇到数组 type 的时候，将 size 从这个 map 里面取出来
-    map<size_t, size_t> &const_expr_to_size_map;
+    const NodeTable<size_t> &const_expr_to_size_map;
 
     // 对于循环，break 会返回一个值
     // 为了确定循环的返回值，需要一个栈维护当前在哪个循环，这个循环的返回值是什么
@@ -136,17 +113,19 @@ struct ExprTypeAndLetStmtVisitor : public AST_Walker {
     vector<RealType_ptr> loop_type_stack;
 
     // 记录每个 AST 树节点的 OutComeState
-    map<size_t, OutcomeState> &node_outcome_state_map;
+    const NodeTable<OutcomeState> &node_outcome_state_map;
 
     // 每个函数调用表达式对应的 FnDecl 映射
-    map<size_t, FnDecl_ptr> &call_expr_to_decl_map;
+    NodeTable<FnDecl_ptr> &call_expr_to_decl_map;
+
+    // 方法 e.g. array.len() point.len()，内置的和结构体的都在里面
+    const MethodTable &method_table;
 
-    // 内置方法 e.g. array.len()
-    // (类型, 方法名, 方法的 FnDecl)
-    vector<std::tuple<RealTypeKind, string, FnDecl_ptr>> &builtin_method_funcs;
+    // 关联函数 e.g. String::from() Point::new()
+    const MethodTable &associated_func_table;
 
-    // 内置关联函数 e.g. String::from()
-    vector<std::tuple<RealTypeKind, string, FnDecl_ptr>> &builtin_associated_funcs;
+    // 表达式的类型都从这里拿
+    TypeContext &types;
 
     // 是否在函数内，如果在存储该函数的定义
     FnDecl_ptr now_func_decl;
@@ -181,65 +160,65 @@ struct ExprTypeAndLetStmtVisitor : public AST_Walker {
     void check_cast(RealType_ptr expr_type, RealType_ptr target_type);
 
     ExprTypeAndLetStmtVisitor(bool require_function_,
-            map<size_t, pair<RealType_ptr, PlaceKind>> &node_type_and_place_kind_map_,
-            map<size_t, ValueDecl_ptr> &identifier_expr_to_decl_map_,
-            map<size_t, LetDecl_ptr> &let_stmt_to_decl_map_,
-            map<size_t, Scope_ptr> &node_scope_map_,
-            map<size_t, RealType_ptr> &type_map_,
-            map<Scope_ptr, Local_Variable_map> &scope_local_variable_map_,
-            map<size_t, size_t> &const_expr_to_size_map_,
-            map<size_t, OutcomeState> &node_outcome_state_map_,
-            map<size_t, FnDecl_ptr> &call_expr_to_decl_map_,
-            vector<std::tuple<RealTypeKind, string, FnDecl_ptr>> &builtin_method_funcs_,
-            vector<std::tuple<RealTypeKind, string, FnDecl_ptr>> &builtin_associated_funcs_) :
+            NodeTable<pair<RealType_ptr, PlaceKind>> &node_type_and_place_kind_map_,
+            NodeTable<ValueDecl_ptr> &identifier_expr_to_decl_map_,
+            NodeTable<LetDecl_ptr> &let_stmt_to_decl_map_,
+            const NodeTable<Scope_ptr> &node_scope_map_,
+            const NodeTable<RealType_ptr> &type_map_,
+            const NodeTable<size_t> &const_expr_to_size_map_,
+            const NodeTable<OutcomeState> &node_outcome_state_map_,
+            NodeTable<FnDecl_ptr> &call_expr_to_decl_map_,
+            const MethodTable &method_table_,
+            const MethodTable &associated_func_table_,
+            TypeContext &types_) :
             require_function(require_function_),
             node_type_and_place_kind_map(node_type_and_place_kind_map_),
             identifier_expr_to_decl_map(identifier_expr_to_decl_map_),
             let_stmt_to_decl_map(let_stmt_to_decl_map_),
             node_scope_map(node_scope_map_),
             type_map(type_map_),
-            scope_local_variable_map(scope_local_variable_map_),
+            symbol_table(symbols),
             const_expr_to_size_map(const_expr_to_size_map_),
             node_outcome_state_map(node_outcome_state_map_),
             call_expr_to_decl_map(call_expr_to_decl_map_),
-            builtin_method_funcs(builtin_method_funcs_),
-            builtin_associated_funcs(builtin_associated_funcs_),
+            method_table(method_table_),
+            associated_func_table(associated_func_table_),
+            types(types_),
             now_func_decl(nullptr) {}
-    virtual ~ExprTypeAndLetStmtVisitor() = default;
-    virtual void visit(LiteralExpr &node) override;
-    virtual void visit(IdentifierExpr &node) override;
-    virtual void visit(BinaryExpr &node) override;
-    virtual void visit(UnaryExpr &node) override;
-    virtual void visit(CallExpr &node) override;
-    virtual void visit(FieldExpr &node) override;
-    virtual void visit(StructExpr &node) override;
-    virtual void visit(IndexExpr &node) override;
-    virtual void visit(BlockExpr &node) override;
-    virtual void visit(IfExpr &node) override;
-    virtual void visit(WhileExpr &node) override;
-    virtual void visit(LoopExpr &node) override;
-    virtual void visit(ReturnExpr &node) override;
-    virtual void visit(BreakExpr &node) override;
-    virtual void visit(ContinueExpr &node) override;
-    virtual void visit(CastExpr &node) override;
-    virtual void visit(PathExpr &node) override;
-    virtual void visit(SelfExpr &node) override;
-    virtual void visit(UnitExpr &node) override;
-    virtual void visit(ArrayExpr &node) override;
-    virtual void visit(RepeatArrayExpr &node) override;
-    virtual void visit(FnItem &node) override;
-    virtual void visit(StructItem &node) override;
-    virtual void visit(EnumItem &node) override;
-    virtual void visit(ImplItem &node) override;
-    virtual void visit(ConstItem &node) override;
-    virtual void visit(LetStmt &node) override;
-    virtual void visit(ExprStmt &node) override;
-    virtual void visit(ItemStmt &node) override;
-    virtual void visit(PathType &node) override;
-    virtual void visit(ArrayType &node) override;
-    virtual void visit(UnitType &node) override;
-    virtual void visit(SelfType &node) override;
-    virtual void visit(IdentifierPattern &node) override;
+    using AST_Walker::visit;
+    void visit(LiteralExpr &node);
+    void visit(IdentifierExpr &node);
+    void visit(BinaryExpr &node);
+    void visit(UnaryExpr &node);
+    void visit(CallExpr &node);
+    void visit(FieldExpr &node);
+    void visit(StructExpr &node);
+    void visit(IndexExpr &node);
+    void visit(BlockExpr &node);
+    void visit(IfExpr &node);
+    void visit(WhileExpr &node);
+    void visit(LoopExpr &node);
+    void visit(ReturnExpr &node);
+    void visit(BreakExpr &node);
+    void visit(ContinueExpr &node);
+    void visit(CastExpr &node);
+    void visit(PathExpr &node);
+    void visit(SelfExpr &node);
+    void visit(UnitExpr &node);
+    void visit(ArrayExpr &node);
+    void visit(RepeatArrayExpr &node);
+    void visit(FnItem &node);
+    void visit(StructItem &node);
+    void visit(EnumItem &node);
+    void visit(ImplItem &node);
+    void visit(ConstItem &node);
+    void visit(LetStmt &node);
+    void visit(ExprStmt &node);
+    void visit(PathType &node);
+    void visit(ArrayType &node);
+    void visit(UnitType &node);
+    void visit(SelfType &node);
+    void visit(IdentifierPattern &node);
 };
 
 
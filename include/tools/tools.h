@@ -2,15 +2,51 @@
 #define TOOLS_H
 
 #include <climits>
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <string_view>
 using std::string;
 
 // 数字字符转数字
 // 不是数字字符，返回 -1
 int ch_to_digit(const char &ch);
 
-// 如果有不是字符的，或者太大的，直接 throw CE
+// 整数字面量的后缀
+enum class IntegerSuffix {
+    NONE,
+    I32,
+    U32,
+    ISIZE,
+    USIZE,
+};
+
+// 解码之后的整数字面量，lexer 里解码一次，后面直接用
+struct IntegerLiteral {
+    long long value = 0;
+    IntegerSuffix suffix = IntegerSuffix::NONE;
+    bool invalid = false;  // 有非法字符，或者没有数字
+    bool overflow = false; // 超过了后缀对应类型的范围（没有后缀时是 long long 的范围）
+};
+
+// 解码整数字面量，不会 throw，出错时设置 invalid / overflow
 // 需要考虑有后缀，需要考虑 0x 开头的情况：16 进制
+IntegerLiteral decode_integer_literal(std::string_view s);
+
+// 取出字面量的值，invalid / overflow 时 throw CE，s 是原来的文本，用来报错
+long long integer_literal_value(const IntegerLiteral &literal, std::string_view s);
+
+// 如果有不是字符的，或者太大的，直接 throw CE
+// 等价于 integer_literal_value(decode_integer_literal(s), s)
 long long safe_stoll(const string &s);
 
+// 在一个栈很大的新线程里运行 f，等它结束再返回，f 抛出的异常原样抛回调用者
+// parser 之外的 pass（语义检查、IRGen）都是递归遍历 AST 的，很深的树靠这个避免爆栈
+constexpr size_t LARGE_STACK_SIZE = size_t(1) << 30;
+void run_with_large_stack(const std::function<void()> &f, size_t stack_size = LARGE_STACK_SIZE);
+// 在 thread_count 个线程上（包括当前线程）同时运行 worker，等全部结束再返回
+// 新开的线程同样是大栈；worker 抛出的异常在全部结束之后抛回调用者（只保留第一个）
+void run_in_parallel(size_t thread_count, const std::function<void()> &worker,
+                     size_t stack_size = LARGE_STACK_SIZE);
+
 #endif // TOOLS_H
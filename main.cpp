@@ -3,20 +3,79 @@
 #include "ir/global_lowering.h"
 #include "ir/type_lowering.h"
 #include "lexer/lexer.h"
+#include "parser/ast_cache.h"
 #include "parser/parser.h"
 #include "semantic/semantic_checker.h"
+#include "tools/tools.h"
 
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_set>
 #include <fstream>
 
-std::string run_full_pipeline() {
+// 分词并解析，AST 的节点交给返回的 ParsedAST
+std::unique_ptr<ParsedAST> parse_source(SourceBuffer_ptr source) {
     Lexer lexer;
-    lexer.read_and_get_tokens();
+    // 比较大的代码一次性分完词，再按顶层 item 并行解析
+    bool parse_in_parallel = source->size() >= Parser::PARALLEL_MIN_SOURCE;
+    if (source->size() >= 2 * Lexer::PARALLEL_MIN_CHUNK) {
+        // 很大的代码先多线程分词
+        lexer.tokenize_parallel(source);
+    } else if (parse_in_parallel) {
+        lexer.tokenize(source);
+    } else {
+        // 流式分词，Parser 需要 token 的时候才往后扫描
+        lexer.start_stream(source);
+    }
     Parser parser(lexer);
-    auto items = parser.parse();
-    Semantic_Checker checker(items);
+    auto ast = std::make_unique<ParsedAST>();
+    ast->items = parse_in_parallel ? parser.parse_parallel() : parser.parse();
+    ast->node_count = parser.node_count();
+    ast->arena.adopt(parser.node_arena());
+    return ast;
+}
+
+// source_path 为空时从 stdin 读入源代码，否则直接 mmap 该文件
+// 设置了 RCOMPILER_AST_CACHE 时，同样的源代码直接从缓存重建 AST，跳过分词和解析
+std::unique_ptr<ParsedAST> load_ast(const std::string &source_path) {
+    SourceBuffer_ptr source = source_path.empty()
+                                  ? SourceBuffer::from_stdin()
+                                  : SourceBuffer::from_file(source_path);
+    ASTCache cache = ASTCache::from_env();
+    std::unique_ptr<ParsedAST> ast = cache.load(source->view());
+    if (ast == nullptr) {
+        ast = parse_source(source);
+        cache.store(source->view(), *ast);
+    }
+    return ast;
+}
+
+// --check：只做语义检查，不生成 IR
+// 设置了 RCOMPILER_CHECK_CACHE 时增量检查：上一次检查通过、自己和依赖的声明都没变的顶层 item 不再做类型检查
+void run_check_only(const std::string &source_path) {
+    std::unique_ptr<ParsedAST> ast = load_ast(source_path);
+    Semantic_Checker checker(ast->items, ast->node_count);
+    CheckedItemCache cache = CheckedItemCache::from_env();
+    std::unordered_set<uint64_t> checked_items = cache.load();
+    if (cache.enabled()) {
+        checker.checked_items = &checked_items;
+    }
+    try {
+        checker.checker();
+    } catch (...) {
+        // 出错的 item 之前的那些仍然是检查通过的
+        cache.store(checker.passed_items);
+        throw;
+    }
+    cache.store(checker.passed_items);
+}
+
+std::string run_full_pipeline(const std::string &source_path) {
+    std::unique_ptr<ParsedAST> ast = load_ast(source_path);
+    vector<Item_ptr> &items = ast->items;
+    Semantic_Checker checker(items, ast->node_count);
     checker.checker();
 
     ir::IRModule module("unknown-unknown-unknown", "");
@@ -29,7 +88,7 @@ std::string run_full_pipeline() {
 
     ir::IRGenerator generator(
         module, builder, type_lowering, checker.node_scope_map,
-        checker.scope_local_variable_map, checker.type_map,
+        checker.type_map,
         checker.node_type_and_place_kind_map, checker.node_outcome_state_map,
         checker.call_expr_to_decl_map, checker.const_value_map,
         checker.fn_item_to_decl_map, checker.identifier_expr_to_decl_map,
@@ -38,9 +97,18 @@ std::string run_full_pipeline() {
     return module.to_string();
 }
 
-int main() {
+int main(int argc, char **argv) {
+    bool check_only = argc > 1 && std::string(argv[1]) == "--check";
+    std::string source_path = argc > (check_only ? 2 : 1) ? argv[check_only ? 2 : 1] : "";
     try {
-        std::cout << run_full_pipeline();
+        if (check_only) {
+            run_with_large_stack([&] { run_check_only(source_path); });
+            return 0;
+        }
+        // 块、if、数组等的嵌套和所有 AST 上的 pass 都是递归的，放到大栈上跑
+        std::string output;
+        run_with_large_stack([&] { output = run_full_pipeline(source_path); });
+        std::cout << output;
         // 往 stderr 输出 runtime/runtime.c 的内容
         std::ifstream rt_file("runtime/builtin.c");
         if (rt_file) {
@@ -0,0 +1,29 @@
+#include "ast/arena.h"
+#include <iterator>
+
+void *ASTArena::allocate(size_t size, size_t align) {
+    size_t offset = (block_used + align - 1) & ~(align - 1);
+    if (blocks.empty() || offset + size > BLOCK_SIZE) {
+        // 节点都很小，不会超过一块的大小
+        blocks.push_back(std::make_unique<std::byte[]>(BLOCK_SIZE));
+        offset = 0;
+    }
+    block_used = offset + size;
+    return blocks.back().get() + offset;
+}
+
+void ASTArena::adopt(ASTArena &other) {
+    // 接过来的块放在前面，当前正在分配的块仍然是最后一块
+    blocks.insert(blocks.begin(), std::make_move_iterator(other.blocks.begin()),
+                  std::make_move_iterator(other.blocks.end()));
+    nodes.insert(nodes.end(), other.nodes.begin(), other.nodes.end());
+    other.blocks.clear();
+    other.nodes.clear();
+    other.block_used = BLOCK_SIZE;
+}
+
+ASTArena::~ASTArena() {
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+        (*it)->~AST_Node();
+    }
+}
@@ -1,49 +1,8 @@
 #include "ast/ast.h"
 #include "lexer/lexer.h"
-#include "ast/visitor.h"
 // #include <iostream>
 #include <cassert>
 
-void LiteralExpr::accept(AST_visitor &v) { v.visit(*this); }
-void IdentifierExpr::accept(AST_visitor &v) { v.visit(*this); }
-void BinaryExpr::accept(AST_visitor &v) { v.visit(*this); }
-void UnaryExpr::accept(AST_visitor &v) { v.visit(*this); }
-void CallExpr::accept(AST_visitor &v) { v.visit(*this); }
-void FieldExpr::accept(AST_visitor &v) { v.visit(*this); }
-void StructExpr::accept(AST_visitor &v) { v.visit(*this); }
-void IndexExpr::accept(AST_visitor &v) { v.visit(*this); }
-void BlockExpr::accept(AST_visitor &v) { v.visit(*this); }
-void IfExpr::accept(AST_visitor &v) { v.visit(*this); }
-void WhileExpr::accept(AST_visitor &v) { v.visit(*this); }
-void LoopExpr::accept(AST_visitor &v) { v.visit(*this); }
-void ReturnExpr::accept(AST_visitor &v) { v.visit(*this); }
-void BreakExpr::accept(AST_visitor &v) { v.visit(*this); }
-void ContinueExpr::accept(AST_visitor &v) { v.visit(*this); }
-void CastExpr::accept(AST_visitor &v) { v.visit(*this); }
-void PathExpr::accept(AST_visitor &v) { v.visit(*this); }
-void SelfExpr::accept(AST_visitor &v) { v.visit(*this); }
-void UnitExpr::accept(AST_visitor &v) { v.visit(*this); }
-void ArrayExpr::accept(AST_visitor &v) { v.visit(*this); }
-void RepeatArrayExpr::accept(AST_visitor &v) { v.visit(*this); }
-
-void FnItem::accept(AST_visitor &v) { v.visit(*this); }
-void StructItem::accept(AST_visitor &v) { v.visit(*this); }
-void EnumItem::accept(AST_visitor &v) { v.visit(*this); }
-void ImplItem::accept(AST_visitor &v) { v.visit(*this); }
-void ConstItem::accept(AST_visitor &v) { v.visit(*this); }
-
-void LetStmt::accept(AST_visitor &v) { v.visit(*this); }
-void ExprStmt::accept(AST_visitor &v) { v.visit(*this); }
-void ItemStmt::accept(AST_visitor &v) { v.visit(*this); }
-
-void PathType::accept(AST_visitor &v) { v.visit(*this); }
-void ArrayType::accept(AST_visitor &v) { v.visit(*this); }
-void UnitType::accept(AST_visitor &v) { v.visit(*this); }
-void SelfType::accept(AST_visitor &v) { v.visit(*this); }
-
-void IdentifierPattern::accept(AST_visitor &v) { v.visit(*this); }
-
-
 string literal_type_to_string(LiteralType type) {
     switch (type) {
         case LiteralType::NUMBER: return "number";
@@ -0,0 +1,672 @@
+#include "ast/flat_ast.h"
+#include "ast/visitor.h"
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+
+// 先序遍历指针形式的 AST，依次把节点追加到 FlatAST 的各个数组里
+struct FlatAST_Builder : public AST_Walker<FlatAST_Builder> {
+    FlatAST &flat;
+    std::unordered_map<string, uint32_t> string_ids;
+    FlatAST_Builder(FlatAST &flat_) : flat(flat_) {}
+
+    uint32_t intern(const string &text) {
+        auto it = string_ids.find(text);
+        if (it != string_ids.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(flat.strings.size());
+        flat.strings.push_back(text);
+        string_ids.emplace(text, id);
+        return id;
+    }
+    uint32_t add_name_list(const vector<const string *> &names) {
+        uint32_t start = static_cast<uint32_t>(flat.name_lists.size());
+        flat.name_lists.push_back(static_cast<uint32_t>(names.size()));
+        for (const string *name : names) {
+            flat.name_lists.push_back(intern(*name));
+        }
+        return start;
+    }
+    // 追加一个节点，并先占好 child_count 个子节点的位置
+    uint32_t open(FlatKind kind, const AST_Node &node, size_t child_count, uint8_t flags = 0,
+                  uint32_t name = FlatAST::NO_NAME) {
+        uint32_t index = static_cast<uint32_t>(flat.kind.size());
+        flat.kind.push_back(kind);
+        flat.flags.push_back(flags);
+        flat.node_id.push_back(static_cast<uint32_t>(node.NodeId));
+        flat.subtree_end.push_back(index + 1);
+        flat.first_child.push_back(static_cast<uint32_t>(flat.children.size()));
+        flat.child_count.push_back(static_cast<uint32_t>(child_count));
+        flat.name.push_back(name);
+        flat.name_list.push_back(FlatAST::NO_NAME);
+        flat.children.resize(flat.children.size() + child_count, FlatAST::NO_NODE);
+        return index;
+    }
+    // 递归转换 child，填到 index 的第 k 个子节点的位置
+    void put(uint32_t index, size_t k, AST_Node *child) {
+        if (child == nullptr) {
+            return;
+        }
+        uint32_t child_index = static_cast<uint32_t>(flat.kind.size());
+        dispatch(child);
+        flat.children[flat.first_child[index] + k] = child_index;
+    }
+    void close(uint32_t index) {
+        flat.subtree_end[index] = static_cast<uint32_t>(flat.kind.size());
+    }
+
+    void visit(LiteralExpr &node) {
+        close(open(FlatKind::LiteralExpr, node, 0, static_cast<uint8_t>(node.literal_type), intern(node.value)));
+    }
+    void visit(IdentifierExpr &node) {
+        close(open(FlatKind::IdentifierExpr, node, 0, 0, intern(node.name)));
+    }
+    void visit(BinaryExpr &node) {
+        uint32_t index = open(FlatKind::BinaryExpr, node, 2, static_cast<uint8_t>(node.op));
+        put(index, 0, node.left);
+        put(index, 1, node.right);
+        close(index);
+    }
+    void visit(UnaryExpr &node) {
+        uint32_t index = open(FlatKind::UnaryExpr, node, 1, static_cast<uint8_t>(node.op));
+        put(index, 0, node.right);
+        close(index);
+    }
+    void visit(CallExpr &node) {
+        uint32_t index = open(FlatKind::CallExpr, node, 1 + node.arguments.size());
+        put(index, 0, node.callee);
+        for (size_t k = 0; k < node.arguments.size(); k++) {
+            put(index, 1 + k, node.arguments[k]);
+        }
+        close(index);
+    }
+    void visit(FieldExpr &node) {
+        uint32_t index = open(FlatKind::FieldExpr, node, 1, 0, intern(node.field_name));
+        put(index, 0, node.base);
+        close(index);
+    }
+    void visit(StructExpr &node) {
+        uint32_t index = open(FlatKind::StructExpr, node, 1 + node.fields.size());
+        vector<const string *> names;
+        for (const auto &field : node.fields) {
+            names.push_back(&field.first);
+        }
+        flat.name_list[index] = add_name_list(names);
+        put(index, 0, node.struct_name);
+        for (size_t k = 0; k < node.fields.size(); k++) {
+            put(index, 1 + k, node.fields[k].second);
+        }
+        close(index);
+    }
+    void visit(IndexExpr &node) {
+        uint32_t index = open(FlatKind::IndexExpr, node, 2);
+        put(index, 0, node.base);
+        put(index, 1, node.index);
+        close(index);
+    }
+    void visit(BlockExpr &node) {
+        uint32_t index = open(FlatKind::BlockExpr, node, node.statements.size() + 1, node.must_return_unit);
+        for (size_t k = 0; k < node.statements.size(); k++) {
+            put(index, k, node.statements[k]);
+        }
+        put(index, node.statements.size(), node.tail_statement);
+        close(index);
+    }
+    void visit(IfExpr &node) {
+        uint32_t index = open(FlatKind::IfExpr, node, 3, node.must_return_unit);
+        put(index, 0, node.condition);
+        put(index, 1, node.then_branch);
+        put(index, 2, node.else_branch);
+        close(index);
+    }
+    void visit(WhileExpr &node) {
+        uint32_t index = open(FlatKind::WhileExpr, node, 2);
+        put(index, 0, node.condition);
+        put(index, 1, node.body);
+        close(index);
+    }
+    void visit(LoopExpr &node) {
+        uint32_t index = open(FlatKind::LoopExpr, node, 1, node.must_return_unit);
+        put(index, 0, node.body);
+        close(index);
+    }
+    void visit(ReturnExpr &node) {
+        uint32_t index = open(FlatKind::ReturnExpr, node, 1);
+        put(index, 0, node.return_value);
+        close(index);
+    }
+    void visit(BreakExpr &node) {
+        uint32_t index = open(FlatKind::BreakExpr, node, 1);
+        put(index, 0, node.break_value);
+        close(index);
+    }
+    void visit(ContinueExpr &node) {
+        close(open(FlatKind::ContinueExpr, node, 0));
+    }
+    void visit(CastExpr &node) {
+        uint32_t index = open(FlatKind::CastExpr, node, 2);
+        put(index, 0, node.expr);
+        put(index, 1, node.target_type);
+        close(index);
+    }
+    void visit(PathExpr &node) {
+        uint32_t index = open(FlatKind::PathExpr, node, 1, 0, intern(node.name));
+        put(index, 0, node.base);
+        close(index);
+    }
+    void visit(SelfExpr &node) {
+        close(open(FlatKind::SelfExpr, node, 0));
+    }
+    void visit(UnitExpr &node) {
+        close(open(FlatKind::UnitExpr, node, 0));
+    }
+    void visit(ArrayExpr &node) {
+        uint32_t index = open(FlatKind::ArrayExpr, node, node.elements.size());
+        for (size_t k = 0; k < node.elements.size(); k++) {
+            put(index, k, node.elements[k]);
+        }
+        close(index);
+    }
+    void visit(RepeatArrayExpr &node) {
+        uint32_t index = open(FlatKind::RepeatArrayExpr, node, 2);
+        put(index, 0, node.element);
+        put(index, 1, node.size);
+        close(index);
+    }
+    void visit(FnItem &node) {
+        size_t parameter_count = node.parameters.size();
+        uint32_t index = open(FlatKind::FnItem, node, 2 * parameter_count + 2,
+                              static_cast<uint8_t>(node.receiver_type), intern(node.function_name));
+        for (size_t k = 0; k < parameter_count; k++) {
+            put(index, 2 * k, node.parameters[k].first);
+            put(index, 2 * k + 1, node.parameters[k].second);
+        }
+        put(index, 2 * parameter_count, node.return_type);
+        put(index, 2 * parameter_count + 1, node.body);
+        close(index);
+    }
+    void visit(StructItem &node) {
+        uint32_t index = open(FlatKind::StructItem, node, node.fields.size(), 0, intern(node.struct_name));
+        vector<const string *> names;
+        for (const auto &field : node.fields) {
+            names.push_back(&field.first);
+        }
+        flat.name_list[index] = add_name_list(names);
+        for (size_t k = 0; k < node.fields.size(); k++) {
+            put(index, k, node.fields[k].second);
+        }
+        close(index);
+    }
+    void visit(EnumItem &node) {
+        uint32_t index = open(FlatKind::EnumItem, node, 0, 0, intern(node.enum_name));
+        vector<const string *> names;
+        for (const auto &variant : node.variants) {
+            names.push_back(&variant);
+        }
+        flat.name_list[index] = add_name_list(names);
+        close(index);
+    }
+    void visit(ImplItem &node) {
+        uint32_t index = open(FlatKind::ImplItem, node, node.methods.size(), 0, intern(node.struct_name));
+        for (size_t k = 0; k < node.methods.size(); k++) {
+            put(index, k, node.methods[k]);
+        }
+        close(index);
+    }
+    void visit(ConstItem &node) {
+        uint32_t index = open(FlatKind::ConstItem, node, 2, 0, intern(node.const_name));
+        put(index, 0, node.const_type);
+        put(index, 1, node.value);
+        close(index);
+    }
+    void visit(LetStmt &node) {
+        uint32_t index = open(FlatKind::LetStmt, node, 3);
+        put(index, 0, node.pattern);
+        put(index, 1, node.type);
+        put(index, 2, node.initializer);
+        close(index);
+    }
+    void visit(ExprStmt &node) {
+        uint32_t index = open(FlatKind::ExprStmt, node, 1, node.is_semi);
+        put(index, 0, node.expr);
+        close(index);
+    }
+    void visit(ItemStmt &node) {
+        uint32_t index = open(FlatKind::ItemStmt, node, 1);
+        put(index, 0, node.item);
+        close(index);
+    }
+    void visit(PathType &node) {
+        close(open(FlatKind::PathType, node, 0, static_cast<uint8_t>(node.ref_type), intern(node.name)));
+    }
+    void visit(ArrayType &node) {
+        uint32_t index = open(FlatKind::ArrayType, node, 2, static_cast<uint8_t>(node.ref_type));
+        put(index, 0, node.element_type);
+        put(index, 1, node.size_expr);
+        close(index);
+    }
+    void visit(UnitType &node) {
+        close(open(FlatKind::UnitType, node, 0, static_cast<uint8_t>(node.ref_type)));
+    }
+    void visit(SelfType &node) {
+        close(open(FlatKind::SelfType, node, 0, static_cast<uint8_t>(node.ref_type)));
+    }
+    void visit(IdentifierPattern &node) {
+        uint8_t flags = static_cast<uint8_t>(node.is_ref) | static_cast<uint8_t>(node.is_mut) << 2;
+        close(open(FlatKind::IdentifierPattern, node, 0, flags, intern(node.name)));
+    }
+};
+
+} // namespace
+
+FlatAST FlatAST::build(const vector<Item_ptr> &items) {
+    FlatAST flat;
+    FlatAST_Builder builder(flat);
+    for (const auto &item : items) {
+        flat.roots.push_back(static_cast<uint32_t>(flat.kind.size()));
+        builder.dispatch(item);
+    }
+    return flat;
+}
+
+namespace {
+
+// 按 node_id 重建指针形式的 AST，子节点的种类不对时 throw
+struct FlatAST_Rebuilder {
+    const FlatAST &flat;
+    ASTArena &arena;
+    FlatAST_Rebuilder(const FlatAST &flat_, ASTArena &arena_) : flat(flat_), arena(arena_) {}
+
+    template <class T, class... Args>
+    T *make(uint32_t i, Args &&...args) {
+        T *node = arena.make<T>(std::forward<Args>(args)...);
+        node->NodeId = flat.node_id[i];
+        return node;
+    }
+    [[noreturn]] void broken(uint32_t i) {
+        throw string("Error, broken FlatAST at ") + flat_kind_to_string(flat.kind[i]) + " " + std::to_string(i);
+    }
+    void expect_children(uint32_t i, size_t count) {
+        if (flat.child_count[i] != count) broken(i);
+    }
+    string name(uint32_t i) { return string(flat.name_of(i)); }
+    // 第 k 个子节点，kind_ok 检查种类；optional 时可以不存在
+    template <class T>
+    T *child(uint32_t i, size_t k, bool (*kind_ok)(FlatKind), bool optional = false) {
+        uint32_t c = flat.child(i, k);
+        if (c == FlatAST::NO_NODE) {
+            if (!optional) broken(i);
+            return nullptr;
+        }
+        if (!kind_ok(flat.kind[c])) broken(i);
+        return static_cast<T *>(build(c));
+    }
+    Expr_ptr expr(uint32_t i, size_t k, bool optional = false) {
+        return child<Expr_Node>(i, k, FlatAST::is_expr, optional);
+    }
+    Type_ptr type(uint32_t i, size_t k, bool optional = false) {
+        return child<Type_Node>(i, k, FlatAST::is_type, optional);
+    }
+    Stmt_ptr stmt(uint32_t i, size_t k, bool optional = false) {
+        return child<Stmt_Node>(i, k, FlatAST::is_stmt, optional);
+    }
+    Item_ptr item(uint32_t i, size_t k) { return child<Item_Node>(i, k, FlatAST::is_item); }
+    Pattern_ptr pattern(uint32_t i, size_t k) {
+        return child<Pattern_Node>(i, k, [](FlatKind kind) { return kind == FlatKind::IdentifierPattern; });
+    }
+    vector<string> name_list(uint32_t i) {
+        vector<string> names;
+        for (size_t k = 0; k < flat.name_list_size(i); k++) {
+            names.emplace_back(flat.name_list_at(i, k));
+        }
+        return names;
+    }
+    ReferenceType ref_type(uint32_t i) { return static_cast<ReferenceType>(flat.flags[i]); }
+
+    AST_Node *build(uint32_t i) {
+        uint8_t flags = flat.flags[i];
+        size_t count = flat.child_count[i];
+        switch (flat.kind[i]) {
+            case FlatKind::LiteralExpr:
+                expect_children(i, 0);
+                return make<LiteralExpr>(i, static_cast<LiteralType>(flags), name(i));
+            case FlatKind::IdentifierExpr:
+                expect_children(i, 0);
+                return make<IdentifierExpr>(i, name(i));
+            case FlatKind::BinaryExpr: {
+                expect_children(i, 2);
+                Expr_ptr left = expr(i, 0);
+                Expr_ptr right = expr(i, 1);
+                return make<BinaryExpr>(i, static_cast<Binary_Operator>(flags), left, right);
+            }
+            case FlatKind::UnaryExpr:
+                expect_children(i, 1);
+                return make<UnaryExpr>(i, static_cast<Unary_Operator>(flags), expr(i, 0));
+            case FlatKind::CallExpr: {
+                if (count < 1) broken(i);
+                Expr_ptr callee = expr(i, 0);
+                vector<Expr_ptr> arguments;
+                for (size_t k = 1; k < count; k++) {
+                    arguments.push_back(expr(i, k));
+                }
+                return make<CallExpr>(i, callee, std::move(arguments));
+            }
+            case FlatKind::FieldExpr:
+                expect_children(i, 1);
+                return make<FieldExpr>(i, expr(i, 0), name(i));
+            case FlatKind::StructExpr: {
+                vector<string> names = name_list(i);
+                expect_children(i, names.size() + 1);
+                Type_ptr struct_name = type(i, 0);
+                vector<pair<string, Expr_ptr>> fields;
+                for (size_t k = 0; k < names.size(); k++) {
+                    fields.emplace_back(std::move(names[k]), expr(i, k + 1));
+                }
+                return make<StructExpr>(i, struct_name, std::move(fields));
+            }
+            case FlatKind::IndexExpr: {
+                expect_children(i, 2);
+                Expr_ptr base = expr(i, 0);
+                Expr_ptr index = expr(i, 1);
+                return make<IndexExpr>(i, base, index);
+            }
+            case FlatKind::BlockExpr: {
+                if (count < 1) broken(i);
+                vector<Stmt_ptr> statements;
+                for (size_t k = 0; k + 1 < count; k++) {
+                    statements.push_back(stmt(i, k));
+                }
+                Stmt_ptr tail = stmt(i, count - 1, true);
+                BlockExpr_ptr node = make<BlockExpr>(i, std::move(statements), tail);
+                node->must_return_unit = flags;
+                return node;
+            }
+            case FlatKind::IfExpr: {
+                expect_children(i, 3);
+                Expr_ptr condition = expr(i, 0);
+                Expr_ptr then_branch = expr(i, 1);
+                Expr_ptr else_branch = expr(i, 2, true);
+                IfExpr_ptr node = make<IfExpr>(i, condition, then_branch, else_branch);
+                node->must_return_unit = flags;
+                return node;
+            }
+            case FlatKind::WhileExpr: {
+                expect_children(i, 2);
+                Expr_ptr condition = expr(i, 0);
+                Expr_ptr body = expr(i, 1);
+                return make<WhileExpr>(i, condition, body);
+            }
+            case FlatKind::LoopExpr: {
+                expect_children(i, 1);
+                LoopExpr_ptr node = make<LoopExpr>(i, expr(i, 0));
+                node->must_return_unit = flags;
+                return node;
+            }
+            case FlatKind::ReturnExpr:
+                expect_children(i, 1);
+                return make<ReturnExpr>(i, expr(i, 0, true));
+            case FlatKind::BreakExpr:
+                expect_children(i, 1);
+                return make<BreakExpr>(i, expr(i, 0, true));
+            case FlatKind::ContinueExpr:
+                expect_children(i, 0);
+                return make<ContinueExpr>(i);
+            case FlatKind::CastExpr: {
+                expect_children(i, 2);
+                Expr_ptr operand = expr(i, 0);
+                Type_ptr target_type = type(i, 1);
+                return make<CastExpr>(i, operand, target_type);
+            }
+            case FlatKind::PathExpr:
+                expect_children(i, 1);
+                return make<PathExpr>(i, type(i, 0), name(i));
+            case FlatKind::SelfExpr:
+                expect_children(i, 0);
+                return make<SelfExpr>(i);
+            case FlatKind::UnitExpr:
+                expect_children(i, 0);
+                return make<UnitExpr>(i);
+            case FlatKind::ArrayExpr: {
+                vector<Expr_ptr> elements;
+                for (size_t k = 0; k < count; k++) {
+                    elements.push_back(expr(i, k));
+                }
+                return make<ArrayExpr>(i, std::move(elements));
+            }
+            case FlatKind::RepeatArrayExpr: {
+                expect_children(i, 2);
+                Expr_ptr element = expr(i, 0);
+                Expr_ptr size = expr(i, 1);
+                return make<RepeatArrayExpr>(i, element, size);
+            }
+            case FlatKind::FnItem: {
+                if (count < 2 || count % 2 != 0) broken(i);
+                size_t parameter_count = count / 2 - 1;
+                vector<pair<Pattern_ptr, Type_ptr>> parameters;
+                for (size_t k = 0; k < parameter_count; k++) {
+                    Pattern_ptr parameter = pattern(i, 2 * k);
+                    parameters.emplace_back(parameter, type(i, 2 * k + 1));
+                }
+                Type_ptr return_type = type(i, 2 * parameter_count, true);
+                Expr_ptr body = expr(i, 2 * parameter_count + 1);
+                return make<FnItem>(i, name(i), static_cast<fn_reciever_type>(flags), std::move(parameters),
+                                    return_type, body);
+            }
+            case FlatKind::StructItem: {
+                vector<string> names = name_list(i);
+                expect_children(i, names.size());
+                vector<pair<string, Type_ptr>> fields;
+                for (size_t k = 0; k < names.size(); k++) {
+                    fields.emplace_back(std::move(names[k]), type(i, k));
+                }
+                return make<StructItem>(i, name(i), std::move(fields));
+            }
+            case FlatKind::EnumItem:
+                expect_children(i, 0);
+                return make<EnumItem>(i, name(i), name_list(i));
+            case FlatKind::ImplItem: {
+                vector<Item_ptr> methods;
+                for (size_t k = 0; k < count; k++) {
+                    methods.push_back(item(i, k));
+                }
+                return make<ImplItem>(i, name(i), std::move(methods));
+            }
+            case FlatKind::ConstItem: {
+                expect_children(i, 2);
+                Type_ptr const_type = type(i, 0);
+                Expr_ptr value = expr(i, 1);
+                return make<ConstItem>(i, name(i), const_type, value);
+            }
+            case FlatKind::LetStmt: {
+                expect_children(i, 3);
+                Pattern_ptr let_pattern = pattern(i, 0);
+                Type_ptr let_type = type(i, 1, true);
+                Expr_ptr initializer = expr(i, 2, true);
+                return make<LetStmt>(i, let_pattern, let_type, initializer);
+            }
+            case FlatKind::ExprStmt:
+                expect_children(i, 1);
+                return make<ExprStmt>(i, expr(i, 0), flags != 0);
+            case FlatKind::ItemStmt:
+                expect_children(i, 1);
+                return make<ItemStmt>(i, item(i, 0));
+            case FlatKind::PathType:
+                expect_children(i, 0);
+                return make<PathType>(i, name(i), ref_type(i));
+            case FlatKind::ArrayType: {
+                expect_children(i, 2);
+                Type_ptr element_type = type(i, 0);
+                Expr_ptr size_expr = expr(i, 1);
+                return make<ArrayType>(i, element_type, size_expr, ref_type(i));
+            }
+            case FlatKind::UnitType:
+                expect_children(i, 0);
+                return make<UnitType>(i, ref_type(i));
+            case FlatKind::SelfType:
+                expect_children(i, 0);
+                return make<SelfType>(i, ref_type(i));
+            case FlatKind::IdentifierPattern:
+                expect_children(i, 0);
+                return make<IdentifierPattern>(i, name(i), static_cast<Mutibility>(flags >> 2),
+                                               static_cast<ReferenceType>(flags & 3));
+        }
+        broken(i);
+    }
+};
+
+template <class T>
+void write_array(string &out, const vector<T> &values) {
+    uint64_t count = values.size();
+    out.append(reinterpret_cast<const char *>(&count), sizeof(count));
+    out.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+// 从一段二进制里顺序读，越界时返回 false
+struct BinaryReader {
+    std::string_view data;
+    size_t pos = 0;
+    bool read_count(uint64_t &count, size_t element_size) {
+        if (data.size() - pos < sizeof(count)) return false;
+        std::memcpy(&count, data.data() + pos, sizeof(count));
+        pos += sizeof(count);
+        return count <= (data.size() - pos) / element_size;
+    }
+    template <class T>
+    bool read_array(vector<T> &values) {
+        uint64_t count;
+        if (!read_count(count, sizeof(T))) return false;
+        values.resize(count);
+        std::memcpy(values.data(), data.data() + pos, count * sizeof(T));
+        pos += count * sizeof(T);
+        return true;
+    }
+};
+
+} // namespace
+
+vector<Item_ptr> FlatAST::to_ast(ASTArena &arena) const {
+    FlatAST_Rebuilder rebuilder(*this, arena);
+    vector<Item_ptr> items;
+    for (uint32_t root : roots) {
+        if (!is_item(kind[root])) rebuilder.broken(root);
+        items.push_back(static_cast<Item_ptr>(rebuilder.build(root)));
+    }
+    return items;
+}
+
+string FlatAST::serialize() const {
+    string out;
+    write_array(out, kind);
+    write_array(out, flags);
+    write_array(out, node_id);
+    write_array(out, subtree_end);
+    write_array(out, first_child);
+    write_array(out, child_count);
+    write_array(out, name);
+    write_array(out, name_list);
+    write_array(out, children);
+    write_array(out, name_lists);
+    write_array(out, roots);
+    vector<uint32_t> lengths;
+    for (const string &text : strings) {
+        lengths.push_back(static_cast<uint32_t>(text.size()));
+    }
+    write_array(out, lengths);
+    for (const string &text : strings) {
+        out.append(text);
+    }
+    return out;
+}
+
+bool FlatAST::deserialize(std::string_view data, FlatAST &flat) {
+    BinaryReader reader{data};
+    vector<uint32_t> lengths;
+    if (!reader.read_array(flat.kind) || !reader.read_array(flat.flags) || !reader.read_array(flat.node_id) ||
+        !reader.read_array(flat.subtree_end) || !reader.read_array(flat.first_child) ||
+        !reader.read_array(flat.child_count) || !reader.read_array(flat.name) ||
+        !reader.read_array(flat.name_list) || !reader.read_array(flat.children) ||
+        !reader.read_array(flat.name_lists) || !reader.read_array(flat.roots) || !reader.read_array(lengths)) {
+        return false;
+    }
+    flat.strings.clear();
+    for (uint32_t length : lengths) {
+        if (data.size() - reader.pos < length) return false;
+        flat.strings.emplace_back(data.substr(reader.pos, length));
+        reader.pos += length;
+    }
+    if (reader.pos != data.size()) return false;
+    // 检查下标，保证之后的访问都不会越界，to_ast 的递归一定会结束
+    size_t n = flat.size();
+    if (flat.flags.size() != n || flat.node_id.size() != n || flat.subtree_end.size() != n ||
+        flat.first_child.size() != n || flat.child_count.size() != n || flat.name.size() != n ||
+        flat.name_list.size() != n) {
+        return false;
+    }
+    vector<bool> seen(n, false);
+    for (uint32_t i = 0; i < n; i++) {
+        if (flat.kind[i] > FlatKind::IdentifierPattern || flat.node_id[i] >= n || seen[flat.node_id[i]]) return false;
+        seen[flat.node_id[i]] = true;
+        if (flat.subtree_end[i] <= i || flat.subtree_end[i] > n) return false;
+        if (uint64_t(flat.first_child[i]) + flat.child_count[i] > flat.children.size()) return false;
+        for (uint32_t c : flat.child_list(i)) {
+            if (c != NO_NODE && (c <= i || c >= flat.subtree_end[i])) return false;
+        }
+        if (flat.name[i] != NO_NAME && flat.name[i] >= flat.strings.size()) return false;
+        if (flat.name_list[i] != NO_NAME) {
+            uint32_t start = flat.name_list[i];
+            if (start >= flat.name_lists.size() ||
+                uint64_t(start) + 1 + flat.name_lists[start] > flat.name_lists.size()) {
+                return false;
+            }
+            for (size_t k = 0; k < flat.name_lists[start]; k++) {
+                if (flat.name_lists[start + 1 + k] >= flat.strings.size()) return false;
+            }
+        }
+    }
+    for (uint32_t root : flat.roots) {
+        if (root >= n) return false;
+    }
+    return true;
+}
+
+string flat_kind_to_string(FlatKind kind) {
+    switch (kind) {
+        case FlatKind::LiteralExpr: return "LiteralExpr";
+        case FlatKind::IdentifierExpr: return "IdentifierExpr";
+        case FlatKind::BinaryExpr: return "BinaryExpr";
+        case FlatKind::UnaryExpr: return "UnaryExpr";
+        case FlatKind::CallExpr: return "CallExpr";
+        case FlatKind::FieldExpr: return "FieldExpr";
+        case FlatKind::StructExpr: return "StructExpr";
+        case FlatKind::IndexExpr: return "IndexExpr";
+        case FlatKind::BlockExpr: return "BlockExpr";
+        case FlatKind::IfExpr: return "IfExpr";
+        case FlatKind::WhileExpr: return "WhileExpr";
+        case FlatKind::LoopExpr: return "LoopExpr";
+        case FlatKind::ReturnExpr: return "ReturnExpr";
+        case FlatKind::BreakExpr: return "BreakExpr";
+        case FlatKind::ContinueExpr: return "ContinueExpr";
+        case FlatKind::CastExpr: return "CastExpr";
+        case FlatKind::PathExpr: return "PathExpr";
+        case FlatKind::SelfExpr: return "SelfExpr";
+        case FlatKind::UnitExpr: return "UnitExpr";
+        case FlatKind::ArrayExpr: return "ArrayExpr";
+        case FlatKind::RepeatArrayExpr: return "RepeatArrayExpr";
+        case FlatKind::FnItem: return "FnItem";
+        case FlatKind::StructItem: return "StructItem";
+        case FlatKind::EnumItem: return "EnumItem";
+        case FlatKind::ImplItem: return "ImplItem";
+        case FlatKind::ConstItem: return "ConstItem";
+        case FlatKind::LetStmt: return "LetStmt";
+        case FlatKind::ExprStmt: return "ExprStmt";
+        case FlatKind::ItemStmt: return "ItemStmt";
+        case FlatKind::PathType: return "PathType";
+        case FlatKind::ArrayType: return "ArrayType";
+        case FlatKind::UnitType: return "UnitType";
+        case FlatKind::SelfType: return "SelfType";
+        case FlatKind::IdentifierPattern: return "IdentifierPattern";
+        default: return "unknown_flat_kind";
+    }
+}
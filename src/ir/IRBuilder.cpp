@@ -220,11 +220,6 @@ IRType_ptr deduce_gep_pointee(IRType_ptr root_type,
     return current ? current : root_type;
 }
 
-std::unordered_map<const IRModule *, std::size_t> &string_literal_counters() {
-    static std::unordered_map<const IRModule *, std::size_t> counters;
-    return counters;
-}
-
 std::string encode_string_literal(const std::string &text) {
     std::ostringstream oss;
     oss << "c\"";
@@ -715,6 +710,20 @@ IRFunction_ptr IRModule::define_function(const std::string &name,
     return fn;
 }
 
+GlobalValue_ptr IRModule::find_string_literal(const std::string &text) const {
+    auto it = string_literals_.find(text);
+    return it == string_literals_.end() ? nullptr : it->second;
+}
+
+void IRModule::register_string_literal(const std::string &text,
+                                       GlobalValue_ptr global) {
+    string_literals_.emplace(text, std::move(global));
+}
+
+std::size_t IRModule::string_literal_count() const {
+    return string_literals_.size();
+}
+
 const std::vector<GlobalValue_ptr> &IRModule::globals() const {
     return globals_;
 }
@@ -1186,13 +1195,19 @@ void IRBuilder::create_memset(IRValue_ptr dst, IRValue_ptr value,
 }
 
 GlobalValue_ptr IRBuilder::create_string_literal(const std::string &text) {
-    auto &counter = string_literal_counters()[&module_];
-    const std::string name = ".str." + std::to_string(counter++);
+    if (auto existing = module_.find_string_literal(text)) {
+        return existing;
+    }
+    const std::string name =
+        ".str." + std::to_string(module_.string_literal_count());
     auto i8_type = std::make_shared<IntegerType>(8);
     auto array_type =
         std::make_shared<ArrayType>(i8_type, text.size() + 1 /* null */);
     auto init_text = encode_string_literal(text);
-    return module_.create_global(name, array_type, init_text, true, "private");
+    auto global =
+        module_.create_global(name, array_type, init_text, true, "private");
+    module_.register_string_literal(text, global);
+    return global;
 }
 
 IRValue_ptr IRBuilder::create_i32_constant(int64_t value) {
@@ -20,20 +20,18 @@ namespace ir {
 // IRGenerator 负责驱动 AST 遍历并交给 IRGenVisitor 处理。
 IRGenerator::IRGenerator(
     IRModule &module, IRBuilder &builder, TypeLowering &type_lowering,
-    std::map<size_t, Scope_ptr> &node_scope_map,
-    std::map<Scope_ptr, Local_Variable_map> &scope_local_variable_map,
-    std::map<size_t, RealType_ptr> &type_map,
-    std::map<size_t, std::pair<RealType_ptr, PlaceKind>>
+    NodeTable<Scope_ptr> &node_scope_map,
+    NodeTable<RealType_ptr> &type_map,
+    NodeTable<std::pair<RealType_ptr, PlaceKind>>
         &node_type_and_place_kind_map,
-    std::map<size_t, OutcomeState> &node_outcome_state_map,
-    std::map<size_t, FnDecl_ptr> &call_expr_to_decl_map,
+    NodeTable<OutcomeState> &node_outcome_state_map,
+    NodeTable<FnDecl_ptr> &call_expr_to_decl_map,
     std::map<ConstDecl_ptr, ConstValue_ptr> &const_value_map,
-    std::map<size_t, FnDecl_ptr> &fn_item_to_decl_map,
-    std::map<size_t, ValueDecl_ptr> &identifier_expr_to_decl_map,
-    std::map<size_t, LetDecl_ptr> &let_stmt_to_decl_map)
+    NodeTable<FnDecl_ptr> &fn_item_to_decl_map,
+    NodeTable<ValueDecl_ptr> &identifier_expr_to_decl_map,
+    NodeTable<LetDecl_ptr> &let_stmt_to_decl_map)
     : module_(module), builder_(builder), type_lowering_(type_lowering),
       node_scope_map_(node_scope_map),
-      scope_local_variable_map_(scope_local_variable_map),
       type_map_(type_map),
       node_type_and_place_kind_map_(node_type_and_place_kind_map),
       node_outcome_state_map_(node_outcome_state_map),
@@ -54,7 +52,7 @@ void IRGenerator::generate(const std::vector<Item_ptr> &ast_items) {
                          let_stmt_to_decl_map_);
     for (const auto &item : ast_items) {
         if (item) {
-            item->accept(visitor);
+            visitor.dispatch(item);
         }
     }
 }
@@ -62,16 +60,16 @@ void IRGenerator::generate(const std::vector<Item_ptr> &ast_items) {
 // IRGenVisitor 携带所有语义信息，在遍历时生成 IR。
 IRGenVisitor::IRGenVisitor(
     IRModule &module, IRBuilder &builder, TypeLowering &type_lowering,
-    std::map<size_t, Scope_ptr> &node_scope_map,
-    std::map<size_t, RealType_ptr> &type_map,
-    std::map<size_t, std::pair<RealType_ptr, PlaceKind>>
+    NodeTable<Scope_ptr> &node_scope_map,
+    NodeTable<RealType_ptr> &type_map,
+    NodeTable<std::pair<RealType_ptr, PlaceKind>>
         &node_type_and_place_kind_map,
-    std::map<size_t, OutcomeState> &node_outcome_state_map,
-    std::map<size_t, FnDecl_ptr> &call_expr_to_decl_map,
+    NodeTable<OutcomeState> &node_outcome_state_map,
+    NodeTable<FnDecl_ptr> &call_expr_to_decl_map,
     std::map<ConstDecl_ptr, ConstValue_ptr> &const_value_map,
-    std::map<size_t, FnDecl_ptr> &fn_item_to_decl_map,
-    std::map<size_t, ValueDecl_ptr> &identifier_expr_to_decl_map,
-    std::map<size_t, LetDecl_ptr> &let_stmt_to_decl_map)
+    NodeTable<FnDecl_ptr> &fn_item_to_decl_map,
+    NodeTable<ValueDecl_ptr> &identifier_expr_to_decl_map,
+    NodeTable<LetDecl_ptr> &let_stmt_to_decl_map)
     : module_(module), builder_(builder), type_lowering_(type_lowering),
       node_scope_map_(node_scope_map),
       type_map_(type_map),
@@ -84,11 +82,11 @@ IRGenVisitor::IRGenVisitor(
 
 // 处理函数节点：创建 IR 函数与上下文，并继续遍历函数体。
 void IRGenVisitor::visit(FnItem &node) {
-    auto decl_iter = fn_item_to_decl_map_.find(node.NodeId);
-    if (decl_iter == fn_item_to_decl_map_.end() || !decl_iter->second) {
+    auto decl_entry = fn_item_to_decl_map_.get(node.NodeId);
+    if (decl_entry == nullptr || !*decl_entry) {
         return;
     }
-    auto decl = decl_iter->second;
+    auto decl = *decl_entry;
     if (!decl || !decl->ast_node) {
         return;
     }
@@ -160,7 +158,7 @@ void IRGenVisitor::visit(FnItem &node) {
     if (decl->is_main) {
         needs_return_slot = true;
         auto ir_type = type_lowering_.lower(
-            std::make_shared<I32RealType>(ReferenceType::NO_REF));
+            TypeContext::primitive(RealTypeKind::I32));
         ctx.return_slot = builder_.create_temp_alloca(ir_type, "ret.slot");
     }
     else if (needs_return_slot) {
@@ -178,7 +176,7 @@ void IRGenVisitor::visit(FnItem &node) {
     }
 
     if (node.body) {
-        node.body->accept(*this);
+        dispatch(node.body);
     }
 
     if (needs_return_slot && !decl->is_main &&
@@ -220,7 +218,7 @@ void IRGenVisitor::visit(LetStmt &node) {
     if (!node.initializer) {
         return;
     }
-    node.initializer->accept(*this);
+    dispatch(node.initializer);
     if (!ctx.current_block) {
         return; // 不可达
     }
@@ -232,15 +230,15 @@ void IRGenVisitor::visit(ExprStmt &node) {
     if (!node.expr) {
         return;
     }
-    node.expr->accept(*this);
+    dispatch(node.expr);
     if (!node.is_semi) {
-        auto type_iter =
-            node_type_and_place_kind_map_.find(node.expr->NodeId);
-        if (type_iter != node_type_and_place_kind_map_.end() &&
-            type_iter->second.first &&
-            type_iter->second.first->kind != RealTypeKind::UNIT &&
-            type_iter->second.first->kind != RealTypeKind::NEVER) {
-            auto expr_type = type_iter->second.first;
+        auto type_entry =
+            node_type_and_place_kind_map_.get(node.expr->NodeId);
+        if (type_entry != nullptr &&
+            type_entry->first &&
+            type_entry->first->kind != RealTypeKind::UNIT &&
+            type_entry->first->kind != RealTypeKind::NEVER) {
+            auto expr_type = type_entry->first;
             if (is_aggregate_type(expr_type)) {
                 expr_address_map_[node.NodeId] =
                     get_lvalue(node.expr->NodeId);
@@ -262,7 +260,7 @@ void IRGenVisitor::visit(ReturnExpr &node) {
         return; // 不可达
     }
     if (node.return_value) {
-        node.return_value->accept(*this);
+        dispatch(node.return_value);
         if (ctx.return_slot) {
             store_expression_result(node.return_value->NodeId,
                                     ctx.return_slot, ctx.decl->return_type);
@@ -280,7 +278,7 @@ void IRGenVisitor::visit(BreakExpr &node) {
     }
     auto &ctx = current_fn();
     if (node.break_value && loop->break_slot && ctx.current_block) {
-        node.break_value->accept(*this);
+        dispatch(node.break_value);
         store_expression_result(node.break_value->NodeId, loop->break_slot,
                                 node_type(node.break_value->NodeId));
     }
@@ -310,18 +308,18 @@ void IRGenVisitor::visit(BinaryExpr &node) {
     auto &ctx = current_fn();
     auto eval_operands = [&]() {
         if (node.left) {
-            node.left->accept(*this);
+            dispatch(node.left);
         }
         if (node.right) {
-            node.right->accept(*this);
+            dispatch(node.right);
         }
     };
     auto load_left_type = [&](RealTypeKind fallback = RealTypeKind::I32) {
-        auto iter = node_type_and_place_kind_map_.find(node.left->NodeId);
-        if (iter == node_type_and_place_kind_map_.end() || !iter->second.first) {
+        auto entry = node_type_and_place_kind_map_.get(node.left->NodeId);
+        if (entry == nullptr || !entry->first) {
             return fallback;
         }
-        return iter->second.first->kind;
+        return entry->first->kind;
     };
     auto is_unsigned_kind = [&](RealTypeKind kind) {
         return kind == RealTypeKind::U32 || kind == RealTypeKind::USIZE;
@@ -510,8 +508,8 @@ void IRGenVisitor::visit(BinaryExpr &node) {
     case Binary_Operator::OR_OR: {
         auto result_slot = builder_.create_temp_alloca(
             type_lowering_.lower(
-                std::make_shared<BoolRealType>(ReferenceType::NO_REF)));
-        node.left->accept(*this);
+                TypeContext::primitive(RealTypeKind::BOOL)));
+        dispatch(node.left);
         auto right_block = builder_.create_block("logical.rhs");
         auto merge_block = builder_.create_block("logical.merge");
         ensure_current_insertion();
@@ -521,7 +519,7 @@ void IRGenVisitor::visit(BinaryExpr &node) {
             builder_.create_store(
                 std::make_shared<ConstantValue>(
                     type_lowering_.lower(
-                        std::make_shared<BoolRealType>(ReferenceType::NO_REF)),
+                        TypeContext::primitive(RealTypeKind::BOOL)),
                     0),
                 result_slot);
             builder_.create_cond_br(lhs_value, right_block, merge_block);
@@ -529,7 +527,7 @@ void IRGenVisitor::visit(BinaryExpr &node) {
             builder_.create_store(
                 std::make_shared<ConstantValue>(
                     type_lowering_.lower(
-                        std::make_shared<BoolRealType>(ReferenceType::NO_REF)),
+                        TypeContext::primitive(RealTypeKind::BOOL)),
                     1),
                 result_slot);
             builder_.create_cond_br(lhs_value, merge_block, right_block);
@@ -537,7 +535,7 @@ void IRGenVisitor::visit(BinaryExpr &node) {
         ctx.current_block = right_block;
         builder_.set_insertion_point(right_block);
         ctx.block_sealed = false;
-        node.right->accept(*this);
+        dispatch(node.right);
         ensure_current_insertion();
         auto rhs_value = get_rvalue(node.right->NodeId);
         builder_.create_store(rhs_value, result_slot);
@@ -560,14 +558,14 @@ void IRGenVisitor::visit(UnaryExpr &node) {
     }
     auto &ctx = current_fn();
     auto operand_type_kind = [&](size_t id) -> RealTypeKind {
-        auto iter = node_type_and_place_kind_map_.find(id);
-        if (iter == node_type_and_place_kind_map_.end() || !iter->second.first) {
+        auto entry = node_type_and_place_kind_map_.get(id);
+        if (entry == nullptr || !entry->first) {
             return RealTypeKind::I32;
         }
-        return iter->second.first->kind;
+        return entry->first->kind;
     };
 
-    node.right->accept(*this);
+    dispatch(node.right);
     switch (node.op) {
     case Unary_Operator::NEG: {
         auto rhs = get_rvalue(node.right->NodeId);
@@ -628,11 +626,11 @@ void IRGenVisitor::visit(CallExpr &node) {
     if (!ctx.current_block) {
         return;
     }
-    auto decl_iter = call_expr_to_decl_map_.find(node.NodeId);
-    if (decl_iter == call_expr_to_decl_map_.end() || !decl_iter->second) {
+    auto decl_entry = call_expr_to_decl_map_.get(node.NodeId);
+    if (decl_entry == nullptr || !*decl_entry) {
         throw std::runtime_error("CallExpr missing target FnDecl");
     }
-    auto fn_decl = decl_iter->second;
+    auto fn_decl = *decl_entry;
     if (!fn_decl) {
         throw std::runtime_error("Invalid FnDecl for CallExpr");
     }
@@ -642,7 +640,7 @@ void IRGenVisitor::visit(CallExpr &node) {
         if (node.arguments.size() != 1 || !node.arguments[0]) {
             throw std::runtime_error("exit function requires one argument");
         }
-        node.arguments[0]->accept(*this);
+        dispatch(node.arguments[0]);
         auto exit_code = get_rvalue(node.arguments[0]->NodeId);
         ensure_current_insertion();
         builder_.create_store(exit_code, ctx.return_slot);
@@ -658,17 +656,17 @@ void IRGenVisitor::visit(CallExpr &node) {
         need_struct = true;
     }
     if (need_struct) {
-        node.callee->accept(*this);
+        dispatch(node.callee);
     }
     for (const auto &arg : node.arguments) {
         if (arg) {
-            arg->accept(*this);
+            dispatch(arg);
         }
     }
     // array len 内建函数，直接返回一个值
     if (fn_decl->is_array_len) {
         size_t array_size = 0;
-        auto callee_ptr = std::dynamic_pointer_cast<FieldExpr>(node.callee);
+        auto callee_ptr = dynamic_cast<FieldExpr *>(node.callee);
         if (!callee_ptr) {
             throw std::runtime_error("Array len callee is not FieldExpr");
         }
@@ -686,7 +684,7 @@ void IRGenVisitor::visit(CallExpr &node) {
     }
     std::vector<IRValue_ptr> call_args;
     if (need_struct) {
-        auto method_callee = std::dynamic_pointer_cast<FieldExpr>(node.callee);
+        auto method_callee = dynamic_cast<FieldExpr *>(node.callee);
         if (!method_callee || !method_callee->base) {
             throw std::runtime_error("Method call missing base expression");
         }
@@ -705,10 +703,10 @@ void IRGenVisitor::visit(CallExpr &node) {
         if (!self_operand) {
             throw std::runtime_error("Failed to prepare self argument");
         }
-        auto base_type_it =
-            node_type_and_place_kind_map_.find(method_callee->base->NodeId);
-        if (base_type_it != node_type_and_place_kind_map_.end()) {
-            auto base_type = base_type_it->second.first;
+        auto base_type_entry =
+            node_type_and_place_kind_map_.get(method_callee->base->NodeId);
+        if (base_type_entry != nullptr) {
+            auto base_type = base_type_entry->first;
             if (base_type && base_type->is_ref != ReferenceType::NO_REF) {
                 ensure_current_insertion();
                 self_operand = builder_.create_load(self_operand);
@@ -727,8 +725,7 @@ void IRGenVisitor::visit(CallExpr &node) {
     ensure_current_insertion();
     auto ret_real_type = fn_decl->return_type
                              ? fn_decl->return_type
-                             : std::make_shared<UnitRealType>(
-                                   ReferenceType::NO_REF);
+                             : TypeContext::primitive(RealTypeKind::UNIT);
     auto ret_ir_type = type_lowering_.lower(ret_real_type);
     if (fn_decl->is_builtin) {
         auto fn_type = type_lowering_.lower_function(fn_decl);
@@ -776,7 +773,7 @@ void IRGenVisitor::visit(IfExpr &node) {
             "if.result.slot");
     }
 
-    node.condition->accept(*this);
+    dispatch(node.condition);
     auto cond_value = get_rvalue(node.condition->NodeId);
     ensure_current_insertion();
     builder_.create_cond_br(cond_value, then_block,
@@ -785,7 +782,7 @@ void IRGenVisitor::visit(IfExpr &node) {
     builder_.set_insertion_point(then_block);
     ctx.current_block = then_block;
     ctx.block_sealed = false;
-    node.then_branch->accept(*this);
+    dispatch(node.then_branch);
     if (ctx.current_block && !ctx.block_sealed) {
         if (need_result) {
             store_expression_result(node.then_branch->NodeId, result_slot,
@@ -798,7 +795,7 @@ void IRGenVisitor::visit(IfExpr &node) {
     ctx.block_sealed = false;
     if (node.else_branch) {
         ctx.current_block = else_block;
-        node.else_branch->accept(*this);
+        dispatch(node.else_branch);
         if (ctx.current_block && !ctx.block_sealed) {
             if (need_result) {
                 store_expression_result(node.else_branch->NodeId, result_slot,
@@ -834,7 +831,7 @@ void IRGenVisitor::visit(WhileExpr &node) {
     builder_.set_insertion_point(cond_block);
     ctx.current_block = cond_block;
     ctx.block_sealed = false;
-    node.condition->accept(*this);
+    dispatch(node.condition);
     auto cond_value = get_rvalue(node.condition->NodeId);
     builder_.create_cond_br(cond_value, body_block, exit_block);
 
@@ -848,7 +845,7 @@ void IRGenVisitor::visit(WhileExpr &node) {
     builder_.set_insertion_point(body_block);
     ctx.current_block = body_block;
     ctx.block_sealed = false;
-    node.body->accept(*this);
+    dispatch(node.body);
 
     if (ctx.current_block && !ctx.block_sealed) {
         builder_.create_br(cond_block);
@@ -894,7 +891,7 @@ void IRGenVisitor::visit(LoopExpr &node) {
     }
     ctx.loop_stack.push_back(loop_ctx);
 
-    node.body->accept(*this);
+    dispatch(node.body);
     if (ctx.current_block && !ctx.block_sealed) {
         builder_.set_insertion_point(ctx.current_block);
         builder_.create_br(body_block);
@@ -924,7 +921,7 @@ void IRGenVisitor::visit(BlockExpr &node) {
             break;
         }
         // std::cerr << "visite stmt \n";
-        stmt->accept(*this);
+        dispatch(stmt);
         if (!current_block_has_next(stmt->NodeId)) {
             ctx.current_block = nullptr;
             // std::cerr << "break! Node id = " << stmt->NodeId << "\n";
@@ -933,7 +930,7 @@ void IRGenVisitor::visit(BlockExpr &node) {
     }
     if (node.tail_statement) {
         // std::cerr << "visit tail, NodeId = " << node.tail_statement->NodeId << "\n";
-        node.tail_statement->accept(*this);
+        dispatch(node.tail_statement);
         // 如果返回值不是 void 才有值
         if (current_block_has_next(node.tail_statement->NodeId) &&
             node_type_and_place_kind_map_[node.tail_statement->NodeId].first->kind != RealTypeKind::UNIT) {
@@ -954,13 +951,13 @@ void IRGenVisitor::visit(StructExpr &node) {
     if (!fn_ctx_) {
         throw std::runtime_error("StructExpr outside of function");
     }
-    auto type_iter = node_type_and_place_kind_map_.find(node.NodeId);
-    if (type_iter == node_type_and_place_kind_map_.end() ||
-        !type_iter->second.first) {
+    auto type_entry = node_type_and_place_kind_map_.get(node.NodeId);
+    if (type_entry == nullptr ||
+        !type_entry->first) {
         throw std::runtime_error("StructExpr missing inferred type");
     }
     auto struct_type =
-        std::dynamic_pointer_cast<StructRealType>(type_iter->second.first);
+        std::dynamic_pointer_cast<StructRealType>(type_entry->first);
     if (!struct_type) {
         throw std::runtime_error("StructExpr type is not a struct");
     }
@@ -994,7 +991,7 @@ void IRGenVisitor::visit(StructExpr &node) {
             throw std::runtime_error("StructExpr field type missing: " +
                                      field_name);
         }
-        expr->accept(*this);
+        dispatch(expr);
         ensure_current_insertion();
         auto field_gep = builder_.create_gep(
             slot, ir_struct_type,
@@ -1031,7 +1028,7 @@ void IRGenVisitor::visit(ArrayExpr &node) {
         if (!elem) {
             throw std::runtime_error("ArrayExpr element missing");
         }
-        elem->accept(*this);
+        dispatch(elem);
         ensure_current_insertion();
         auto element_addr =
             builder_.create_gep(slot, ir_array_type,
@@ -1067,16 +1064,16 @@ void IRGenVisitor::visit(RepeatArrayExpr &node) {
         expr_address_map_[node.NodeId] = slot;
         return;
     }
-    node.element->accept(*this);
+    dispatch(node.element);
     const bool aggregate_element =
         is_aggregate_type(array_type->element_type);
     IRValue_ptr element_value = nullptr;
     IRValue_ptr element_source_addr = nullptr;
     if (aggregate_element) {
-        auto addr_it = expr_address_map_.find(node.element->NodeId);
+        auto addr_entry = expr_address_map_.get(node.element->NodeId);
         element_source_addr =
-            addr_it != expr_address_map_.end()
-                ? addr_it->second
+            addr_entry != nullptr
+                ? *addr_entry
                 : get_lvalue(node.element->NodeId);
     } else {
         element_value = get_rvalue(node.element->NodeId);
@@ -1084,7 +1081,7 @@ void IRGenVisitor::visit(RepeatArrayExpr &node) {
     auto zero = builder_.create_i32_constant(0);
     // 改成手动写一个 while 循环来赋值，避免生成过大的 IR。
     auto idx = builder_.create_temp_alloca(
-        type_lowering_.lower(std::make_shared<UsizeRealType>(ReferenceType::NO_REF)),
+        type_lowering_.lower(TypeContext::primitive(RealTypeKind::USIZE)),
         "repeat.array.idx");
     builder_.create_store(zero, idx);
     auto cond = builder_.create_block("repeatarray.while.cond");
@@ -1135,20 +1132,20 @@ void IRGenVisitor::visit(FieldExpr &node) {
     }
     auto &ctx = current_fn();
     if (type->kind == RealTypeKind::FUNCTION) {
-        node.base->accept(*this);
-        auto value_it = expr_value_map_.find(node.base->NodeId);
-        if (value_it != expr_value_map_.end()) {
-            expr_value_map_[node.NodeId] = value_it->second;
+        dispatch(node.base);
+        auto value_entry = expr_value_map_.get(node.base->NodeId);
+        if (value_entry != nullptr) {
+            expr_value_map_[node.NodeId] = *value_entry;
             return;
         }
-        auto addr_it = expr_address_map_.find(node.base->NodeId);
-        if (addr_it != expr_address_map_.end()) {
-            expr_address_map_[node.NodeId] = addr_it->second;
+        auto addr_entry = expr_address_map_.get(node.base->NodeId);
+        if (addr_entry != nullptr) {
+            expr_address_map_[node.NodeId] = *addr_entry;
             return;
         }
         throw std::runtime_error("FieldExpr function base has no value");
     } else {
-        node.base->accept(*this);
+        dispatch(node.base);
         auto base_addr = get_lvalue(node.base->NodeId);
         auto [base_type, base_placekind] =
             node_type_and_place_kind_map_[node.base->NodeId];
@@ -1201,8 +1198,8 @@ void IRGenVisitor::visit(IndexExpr &node) {
     if (!type) {
         throw std::runtime_error("IndexExpr missing inferred type");
     }
-    node.base->accept(*this);
-    node.index->accept(*this);
+    dispatch(node.base);
+    dispatch(node.index);
     auto base_addr = get_lvalue(node.base->NodeId);
     // 如果 base 是引用类型，那么取它的底层类型
     auto [base_type, base_placekind] =
@@ -1233,12 +1230,12 @@ void IRGenVisitor::visit(LiteralExpr &node) {
     auto &ctx = current_fn();
     switch (node.literal_type) {
     case LiteralType::NUMBER: {
-        constant = builder_.create_i32_constant(safe_stoll(node.value));
+        constant = builder_.create_i32_constant(integer_literal_value(node.number, node.value));
         break;
     }
     case LiteralType::BOOL: {
         auto lowered_type = type_lowering_.lower(
-            std::make_shared<BoolRealType>(ReferenceType::NO_REF));
+            TypeContext::primitive(RealTypeKind::BOOL));
         constant = std::make_shared<ConstantValue>(
             lowered_type, node.value == "true" ? 1 : 0);
         break;
@@ -1248,14 +1245,14 @@ void IRGenVisitor::visit(LiteralExpr &node) {
             throw std::runtime_error("empty char literal");
         }
         auto lowered_type = type_lowering_.lower(
-            std::make_shared<CharRealType>(ReferenceType::NO_REF));
+            TypeContext::primitive(RealTypeKind::CHAR));
         constant = std::make_shared<ConstantValue>(
             lowered_type, static_cast<int>(node.value.front()));
         break;
     }
     case LiteralType::STRING: {
         auto str_type = type_lowering_.lower(
-            std::make_shared<StrRealType>(ReferenceType::NO_REF));
+            TypeContext::primitive(RealTypeKind::STR));
         auto previous_block = builder_.insertion_block();
         builder_.set_insertion_point(ctx.entry_block);
         constant =
@@ -1283,11 +1280,11 @@ void IRGenVisitor::visit(LiteralExpr &node) {
 
 // 标识符访问：let -> 地址，const -> 常量或全局。
 void IRGenVisitor::visit(IdentifierExpr &node) {
-    auto decl_iter = identifier_expr_to_decl_map_.find(node.NodeId);
-    if (decl_iter == identifier_expr_to_decl_map_.end() || !decl_iter->second) {
+    auto decl_entry = identifier_expr_to_decl_map_.get(node.NodeId);
+    if (decl_entry == nullptr || !*decl_entry) {
         return;
     }
-    auto target = decl_iter->second;
+    auto target = *decl_entry;
     auto &ctx = current_fn();
 
     if (target->kind == ValueDeclKind::LetStmt) {
@@ -1330,16 +1327,16 @@ void IRGenVisitor::visit(CastExpr &node) {
     if (!fn_ctx_ || !node.expr) {
         throw std::runtime_error("Invalid CastExpr");
     }
-    node.expr->accept(*this);
-    auto expr_iter = node_type_and_place_kind_map_.find(node.expr->NodeId);
-    auto target_iter = node_type_and_place_kind_map_.find(node.NodeId);
-    if (expr_iter == node_type_and_place_kind_map_.end() ||
-        target_iter == node_type_and_place_kind_map_.end() ||
-        !expr_iter->second.first || !target_iter->second.first) {
+    dispatch(node.expr);
+    auto expr_entry = node_type_and_place_kind_map_.get(node.expr->NodeId);
+    auto target_entry = node_type_and_place_kind_map_.get(node.NodeId);
+    if (expr_entry == nullptr ||
+        target_entry == nullptr ||
+        !expr_entry->first || !target_entry->first) {
         throw std::runtime_error("CastExpr missing type information");
     }
-    auto src_type = expr_iter->second.first;
-    auto dst_type = target_iter->second.first;
+    auto src_type = expr_entry->first;
+    auto dst_type = target_entry->first;
     if (src_type->is_ref != ReferenceType::NO_REF ||
         dst_type->is_ref != ReferenceType::NO_REF) {
         throw std::runtime_error("CastExpr does not support references");
@@ -1445,12 +1442,12 @@ void IRGenVisitor::visit(PathExpr &node) {
         if (variant_iter == enum_decl->variants.end()) {
             throw std::runtime_error("Enum has no variant named: " + node.name);
         }
-        auto type_iter = node_type_and_place_kind_map_.find(node.NodeId);
-        if (type_iter == node_type_and_place_kind_map_.end() ||
-            !type_iter->second.first) {
+        auto type_entry = node_type_and_place_kind_map_.get(node.NodeId);
+        if (type_entry == nullptr ||
+            !type_entry->first) {
             throw std::runtime_error("Enum PathExpr missing type info");
         }
-        auto lowered_type = type_lowering_.lower(type_iter->second.first);
+        auto lowered_type = type_lowering_.lower(type_entry->first);
         auto constant = std::make_shared<ConstantValue>(
             lowered_type, static_cast<int64_t>(variant_iter->second));
         expr_value_map_[node.NodeId] = constant;
@@ -1465,15 +1462,9 @@ void IRGenVisitor::visit(StructItem &node) { return; }
 // EnumItem: 同上。
 void IRGenVisitor::visit(EnumItem &node) { return; }
 
-// ImplItem: 需要遍历内部方法/常量。
-void IRGenVisitor::visit(ImplItem &node) { AST_Walker::visit(node); }
-
 // ConstItem: 全局 lowering 已处理，IR 阶段无需重复。
 void IRGenVisitor::visit(ConstItem &node) { return; }
 
-// ItemStmt: 继续遍历内部 Item。
-void IRGenVisitor::visit(ItemStmt &node) { AST_Walker::visit(node); }
-
 // self。
 void IRGenVisitor::visit(SelfExpr &node) {
     if (!fn_ctx_) {
@@ -1557,36 +1548,36 @@ void IRGenVisitor::ensure_current_insertion() {
 }
 
 IRValue_ptr IRGenVisitor::get_rvalue(size_t node_id) {
-    auto iter = expr_value_map_.find(node_id);
-    if (iter != expr_value_map_.end()) {
-        return iter->second;
+    auto entry = expr_value_map_.get(node_id);
+    if (entry != nullptr) {
+        return *entry;
     }
-    auto addr_iter = expr_address_map_.find(node_id);
-    if (addr_iter == expr_address_map_.end()) {
+    auto addr_entry = expr_address_map_.get(node_id);
+    if (addr_entry == nullptr) {
         throw std::runtime_error(
             "IRGenVisitor::get_rvalue missing address for node " +
             std::to_string(node_id));
     }
-    auto value = builder_.create_load(addr_iter->second);
+    auto value = builder_.create_load(*addr_entry);
     return value;
 }
 
 IRValue_ptr IRGenVisitor::get_lvalue(size_t node_id) {
-    auto addr_iter = expr_address_map_.find(node_id);
+    auto addr_entry = expr_address_map_.get(node_id);
     auto &ctx = current_fn();
-    if (addr_iter != expr_address_map_.end()) {    
-        return addr_iter->second;
+    if (addr_entry != nullptr) {    
+        return *addr_entry;
     } else {
-        auto value_iter = expr_value_map_.find(node_id);
-        if (value_iter == expr_value_map_.end()) {
+        auto value_entry = expr_value_map_.get(node_id);
+        if (value_entry == nullptr) {
             throw std::runtime_error("IRGenVisitor::get_lvalue missing value");
         }
         auto previous_block = builder_.insertion_block();
         // 到 entry block 分配临时槽存放值。
         builder_.set_insertion_point(ctx.entry_block);
-        auto address = builder_.create_alloca(value_iter->second->type());
+        auto address = builder_.create_alloca((*value_entry)->type());
         builder_.set_insertion_point(previous_block);
-        builder_.create_store(value_iter->second, address);
+        builder_.create_store(*value_entry, address);
         return address;
     }
 }
@@ -1606,13 +1597,13 @@ const LoopContext *IRGenVisitor::current_loop() const {
 }
 
 RealType_ptr IRGenVisitor::node_type(size_t node_id) const {
-    auto iter = node_type_and_place_kind_map_.find(node_id);
-    if (iter != node_type_and_place_kind_map_.end() && iter->second.first) {
-        return iter->second.first;
+    auto entry = node_type_and_place_kind_map_.get(node_id);
+    if (entry != nullptr && entry->first) {
+        return entry->first;
     }
-    auto type_iter = type_map_.find(node_id);
-    if (type_iter != type_map_.end()) {
-        return type_iter->second;
+    auto type_entry = type_map_.get(node_id);
+    if (type_entry != nullptr) {
+        return *type_entry;
     }
     return nullptr;
 }
@@ -1670,14 +1661,11 @@ bool IRGenVisitor::is_zero_initializer_expr(const Expr_ptr &expr) const {
     if (!expr) {
         return false;
     }
-    if (auto literal = std::dynamic_pointer_cast<LiteralExpr>(expr)) {
+    if (auto literal = dynamic_cast<LiteralExpr *>(expr)) {
         switch (literal->literal_type) {
         case LiteralType::NUMBER: {
-            try {
-                return safe_stoll(literal->value) == 0;
-            } catch (...) {
-                return false;
-            }
+            const IntegerLiteral &number = literal->number;
+            return !number.invalid && !number.overflow && number.value == 0;
         }
         case LiteralType::BOOL:
             return literal->value == "false";
@@ -1685,10 +1673,10 @@ bool IRGenVisitor::is_zero_initializer_expr(const Expr_ptr &expr) const {
             return false;
         }
     }
-    if (auto repeat = std::dynamic_pointer_cast<RepeatArrayExpr>(expr)) {
+    if (auto repeat = dynamic_cast<RepeatArrayExpr *>(expr)) {
         return is_zero_initializer_expr(repeat->element);
     }
-    if (auto array_expr = std::dynamic_pointer_cast<ArrayExpr>(expr)) {
+    if (auto array_expr = dynamic_cast<ArrayExpr *>(expr)) {
         for (const auto &element : array_expr->elements) {
             if (!is_zero_initializer_expr(element)) {
                 return false;
@@ -1719,11 +1707,11 @@ TypeDecl_ptr IRGenVisitor::resolve_type_decl(Type_ptr type_node) const {
     if (!type_node) {
         return nullptr;
     }
-    auto type_iter = type_map_.find(type_node->NodeId);
-    if (type_iter == type_map_.end() || !type_iter->second) {
+    auto type_entry = type_map_.get(type_node->NodeId);
+    if (type_entry == nullptr || !*type_entry) {
         return nullptr;
     }
-    auto real_type = type_iter->second;
+    auto real_type = *type_entry;
     if (auto struct_type = std::dynamic_pointer_cast<StructRealType>(real_type)) {
         return struct_type->decl.lock();
     }
@@ -52,8 +52,7 @@ void GlobalLoweringDriver::visit_scope(Scope_ptr scope) {
         if (!struct_decl) {
             continue;
         }
-        auto real_type = std::make_shared<StructRealType>(
-            struct_decl->name, ReferenceType::NO_REF, struct_decl);
+        auto real_type = type_lowering_.types().struct_type(struct_decl);
         (void)type_lowering_.size_in_bytes(real_type);
     }
 
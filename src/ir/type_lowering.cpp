@@ -53,69 +53,6 @@ uint64_t read_unsigned(ConstValue_ptr value) {
     throw std::runtime_error("ConstValue is not unsigned integer");
 }
 
-RealType_ptr strip_reference(const RealType_ptr &type) {
-    if (!type) {
-        throw std::runtime_error("invalid RealType");
-    }
-    switch (type->kind) {
-    case RealTypeKind::BOOL:
-        return std::make_shared<BoolRealType>(ReferenceType::NO_REF);
-    case RealTypeKind::CHAR:
-        return std::make_shared<CharRealType>(ReferenceType::NO_REF);
-    case RealTypeKind::UNIT:
-        return std::make_shared<UnitRealType>(ReferenceType::NO_REF);
-    case RealTypeKind::NEVER:
-        return std::make_shared<NeverRealType>(ReferenceType::NO_REF);
-    case RealTypeKind::I32:
-        return std::make_shared<I32RealType>(ReferenceType::NO_REF);
-    case RealTypeKind::ISIZE:
-        return std::make_shared<IsizeRealType>(ReferenceType::NO_REF);
-    case RealTypeKind::U32:
-        return std::make_shared<U32RealType>(ReferenceType::NO_REF);
-    case RealTypeKind::USIZE:
-        return std::make_shared<UsizeRealType>(ReferenceType::NO_REF);
-    case RealTypeKind::ANYINT:
-        return std::make_shared<AnyIntRealType>(ReferenceType::NO_REF);
-    case RealTypeKind::STR:
-        return std::make_shared<StrRealType>(ReferenceType::NO_REF);
-    case RealTypeKind::STRING:
-        return std::make_shared<StringRealType>(ReferenceType::NO_REF);
-    default:
-        break;
-    }
-    switch (type->kind) {
-    case RealTypeKind::ARRAY: {
-        auto arr = std::dynamic_pointer_cast<ArrayRealType>(type);
-        return std::make_shared<ArrayRealType>(arr->element_type, arr->size_expr,
-                                               ReferenceType::NO_REF, arr->size);
-    }
-    case RealTypeKind::STRUCT: {
-        auto struct_type = std::dynamic_pointer_cast<StructRealType>(type);
-        return std::make_shared<StructRealType>(
-            struct_type->name, ReferenceType::NO_REF, struct_type->decl.lock());
-    }
-    case RealTypeKind::ENUM: {
-        auto enum_type = std::dynamic_pointer_cast<EnumRealType>(type);
-        return std::make_shared<EnumRealType>(
-            enum_type->name, ReferenceType::NO_REF, enum_type->decl.lock());
-    }
-    case RealTypeKind::FUNCTION: {
-        auto fn_type = std::dynamic_pointer_cast<FunctionRealType>(type);
-        return std::make_shared<FunctionRealType>(fn_type->decl.lock(),
-                                                  ReferenceType::NO_REF);
-    }
-    default:
-        break;
-    }
-    throw std::runtime_error("strip_reference: unsupported RealType");
-}
-
-RealType_ptr clone_with_ref(const RealType_ptr &type, ReferenceType ref) {
-    auto base = strip_reference(type);
-    base->is_ref = ref;
-    return base;
-}
-
 bool is_aggregate_return(const RealType_ptr &type) {
     if (!type || type->is_ref != ReferenceType::NO_REF) {
         return false;
@@ -144,7 +81,7 @@ IRType_ptr TypeLowering::lower(RealType_ptr type) {
         throw std::runtime_error("invalid RealType");
     }
     if (type->is_ref != ReferenceType::NO_REF) {
-        auto base = strip_reference(type);
+        auto base = types_.with_ref(type, ReferenceType::NO_REF);
         auto pointee = lower(base);
         return std::make_shared<PointerType>(pointee);
     }
@@ -227,11 +164,9 @@ std::shared_ptr<FunctionType> TypeLowering::lower_function(FnDecl_ptr decl) {
         RealType_ptr self_real = nullptr;
         auto self_decl = decl->self_struct.lock();
         if (self_decl) {
-            std::string self_name = self_decl->name;
-            self_real =
-                std::make_shared<StructRealType>(self_name, ref, self_decl);
+            self_real = types_.struct_type(self_decl, ref);
         } else if (decl->is_builtin && decl->builtin_method_self_type) {
-            self_real = clone_with_ref(decl->builtin_method_self_type, ref);
+            self_real = types_.with_ref(decl->builtin_method_self_type, ref);
         } else {
             throw std::runtime_error("method missing self struct");
         }
@@ -242,8 +177,7 @@ std::shared_ptr<FunctionType> TypeLowering::lower_function(FnDecl_ptr decl) {
     }
     auto ret_real_type = decl->return_type
                              ? decl->return_type
-                             : std::make_shared<UnitRealType>(
-                                   ReferenceType::NO_REF);
+                             : TypeContext::primitive(RealTypeKind::UNIT);
     IRType_ptr ret_type = lower(ret_real_type);
     // 如果是 main 函数要特判成 i32 返回类型
     if (decl->is_main) {
@@ -0,0 +1,19 @@
+#include "lexer/interner.h"
+
+uint32_t SymbolInterner::intern(std::string_view name) {
+    auto it = symbol_ids.find(name);
+    if (it != symbol_ids.end()) {
+        return it->second;
+    }
+    storage.emplace_back(name);
+    std::string_view stored(storage.back());
+    uint32_t id = static_cast<uint32_t>(symbol_names.size());
+    symbol_names.push_back(stored);
+    symbol_ids.emplace(stored, id);
+    return id;
+}
+
+uint32_t SymbolInterner::find(std::string_view name) const {
+    auto it = symbol_ids.find(name);
+    return it == symbol_ids.end() ? NO_SYMBOL : it->second;
+}
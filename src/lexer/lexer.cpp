@@ -1,80 +1,61 @@
 #include "lexer/lexer.h"
+#include "lexer/scan.h"
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <iostream>
+#include <thread>
 
-Lexer::Lexer() {
-    // 初始化关键字映射
-    keywords_map = {
-        {"let", Token_type::LET},
-        {"mut", Token_type::MUT},
-        {"fn", Token_type::FN},
-        {"if", Token_type::IF},
-        {"else", Token_type::ELSE},
-        {"while", Token_type::WHILE},
-        {"for", Token_type::FOR},
-        {"in", Token_type::IN},
-        {"return", Token_type::RETURN},
-        {"break", Token_type::BREAK},
-        {"continue", Token_type::CONTINUE},
-        {"struct", Token_type::STRUCT},
-        {"as", Token_type::AS},
-        {"const", Token_type::CONST},
-        {"enum", Token_type::ENUM},
-        {"impl", Token_type::IMPL},
-        {"loop", Token_type::LOOP},
-        {"ref", Token_type::REF},
-        {"use", Token_type::USE},
-        {"self", Token_type::SELF},
-        {"Self", Token_type::BIG_SELF},
-        {"true", Token_type::TRUE},
-        {"false", Token_type::FALSE}
-    };
-    // 初始化符号映射
-    symbol_map = {
-        {"(", Token_type::LEFT_PARENTHESIS},
-        {")", Token_type::RIGHT_PARENTHESIS},
-        {"{", Token_type::LEFT_BRACE},
-        {"}", Token_type::RIGHT_BRACE},
-        {"[", Token_type::LEFT_BRACKET},
-        {"]", Token_type::RIGHT_BRACKET},
-        {";", Token_type::SEMICOLON},
-        {",", Token_type::COMMA},
-        {"+", Token_type::PLUS},
-        {"-", Token_type::MINUS},
-        {"*", Token_type::STAR},
-        {"/", Token_type::SLASH},
-        {"%", Token_type::PERCENT},
-        {"&", Token_type::AMPERSAND},
-        {"|", Token_type::PIPE},
-        {"^", Token_type::CARET},
-        {"==", Token_type::EQUAL_EQUAL},
-        {"+=", Token_type::PLUS_EQUAL},
-        {"-=", Token_type::MINUS_EQUAL},
-        {"*=", Token_type::STAR_EQUAL},
-        {"/=", Token_type::SLASH_EQUAL},
-        {"%=", Token_type::PERCENT_EQUAL},
-        {"&=", Token_type::AMPERSAND_EQUAL},
-        {"|=", Token_type::PIPE_EQUAL},
-        {"^=", Token_type::CARET_EQUAL},
-        {"<<", Token_type::LEFT_SHIFT},
-        {">>", Token_type::RIGHT_SHIFT},
-        {"<<=", Token_type::LEFT_SHIFT_EQUAL},
-        {">>=", Token_type::RIGHT_SHIFT_EQUAL},
-        {".", Token_type::DOT},
-        {"->", Token_type::ARROW},
-        {":", Token_type::COLON},
-        {"::", Token_type::COLON_COLON},
-        // {"~", Token_type::TILDE},
-        {"!", Token_type::BANG},
-        {"=", Token_type::EQUAL},
-        {"!=", Token_type::NOT_EQUAL},
-        {"<", Token_type::LESS},
-        {">", Token_type::GREATER},
-        {"<=", Token_type::LESS_EQUAL},
-        {">=", Token_type::GREATER_EQUAL},
-        {"&&", Token_type::AMPERSAND_AMPERSAND},
-        {"||", Token_type::PIPE_PIPE}
-    };
+namespace {
+
+struct KeywordEntry {
+    std::string_view name;
+    Token_type type;
+};
+
+// 下标就是关键字在 interner 中的 id（构造 Lexer 时按这个顺序最先插入）
+constexpr KeywordEntry KEYWORDS[] = {
+    {"let", Token_type::LET},
+    {"mut", Token_type::MUT},
+    {"fn", Token_type::FN},
+    {"if", Token_type::IF},
+    {"else", Token_type::ELSE},
+    {"while", Token_type::WHILE},
+    {"for", Token_type::FOR},
+    {"in", Token_type::IN},
+    {"return", Token_type::RETURN},
+    {"break", Token_type::BREAK},
+    {"continue", Token_type::CONTINUE},
+    {"struct", Token_type::STRUCT},
+    {"as", Token_type::AS},
+    {"const", Token_type::CONST},
+    {"enum", Token_type::ENUM},
+    {"impl", Token_type::IMPL},
+    {"loop", Token_type::LOOP},
+    {"ref", Token_type::REF},
+    {"use", Token_type::USE},
+    {"self", Token_type::SELF},
+    {"Self", Token_type::BIG_SELF},
+    {"true", Token_type::TRUE},
+    {"false", Token_type::FALSE}
+};
+
+// 编译期求出关键字在 KEYWORDS 中的下标
+consteval int keyword_id(std::string_view name) {
+    for (size_t i = 0; i < std::size(KEYWORDS); i++) {
+        if (KEYWORDS[i].name == name) return static_cast<int>(i);
+    }
+    throw "no such keyword";
+}
+
+} // namespace
+
+Lexer::Lexer()
+    : interner(std::make_shared<SymbolInterner>()), literals(std::make_shared<LiteralPool>()) {
+    // 关键字最先插入 interner，id 就是 KEYWORDS 的下标
+    for (const auto &keyword : KEYWORDS) {
+        interner->intern(keyword.name);
+    }
 }
 
 string token_type_to_string(Token_type type) {
@@ -156,8 +137,8 @@ void Token::show_token() const {
     std::cerr << "[" << token_type_to_string(type) << ", " << value << "]" << std::endl;
 }
 
-Token::Token(Token_type _type, string _value) {
-    this->type = _type, this->value = _value;
+Token::Token(Token_type _type, std::string_view _value, uint32_t _symbol_id) {
+    this->type = _type, this->value = _value, this->symbol_id = _symbol_id;
 }
 
 string Lexer::get_escape_character(char ch) const {
@@ -179,55 +160,453 @@ bool Lexer::is_not_symbol(char ch) const {
     return false;
 }
 
-void Lexer::add_identifier(string &now_str) {
-    if (keywords_map.find(now_str) != keywords_map.end()) {
-        tokens.push_back(Token(keywords_map[now_str], now_str));
-    } else {
-        tokens.push_back(Token(Token_type::IDENTIFIER, now_str));
+int Lexer::keyword_index(std::string_view text) const {
+    // 先按长度，再按首字母分派，最后至多做一次字符串比较
+    auto check = [text](int id) { return KEYWORDS[id].name == text ? id : -1; };
+    switch (text.size()) {
+        case 2:
+            switch (text[0]) {
+                case 'a': return check(keyword_id("as"));
+                case 'f': return check(keyword_id("fn"));
+                case 'i': return text[1] == 'f' ? check(keyword_id("if")) : check(keyword_id("in"));
+            }
+            break;
+        case 3:
+            switch (text[0]) {
+                case 'f': return check(keyword_id("for"));
+                case 'l': return check(keyword_id("let"));
+                case 'm': return check(keyword_id("mut"));
+                case 'r': return check(keyword_id("ref"));
+                case 'u': return check(keyword_id("use"));
+            }
+            break;
+        case 4:
+            switch (text[0]) {
+                case 'e': return text[1] == 'l' ? check(keyword_id("else")) : check(keyword_id("enum"));
+                case 'i': return check(keyword_id("impl"));
+                case 'l': return check(keyword_id("loop"));
+                case 's': return check(keyword_id("self"));
+                case 'S': return check(keyword_id("Self"));
+                case 't': return check(keyword_id("true"));
+            }
+            break;
+        case 5:
+            switch (text[0]) {
+                case 'b': return check(keyword_id("break"));
+                case 'c': return check(keyword_id("const"));
+                case 'f': return check(keyword_id("false"));
+                case 'w': return check(keyword_id("while"));
+            }
+            break;
+        case 6:
+            switch (text[0]) {
+                case 'r': return check(keyword_id("return"));
+                case 's': return check(keyword_id("struct"));
+            }
+            break;
+        case 8:
+            return check(keyword_id("continue"));
+    }
+    return -1;
+}
+
+size_t Lexer::match_symbol(char ch, char next_ch, char next_next_ch, Token_type &type) const {
+    // 最长匹配：能接上更长的符号就一定取更长的
+    switch (ch) {
+        case '(': type = Token_type::LEFT_PARENTHESIS; return 1;
+        case ')': type = Token_type::RIGHT_PARENTHESIS; return 1;
+        case '{': type = Token_type::LEFT_BRACE; return 1;
+        case '}': type = Token_type::RIGHT_BRACE; return 1;
+        case '[': type = Token_type::LEFT_BRACKET; return 1;
+        case ']': type = Token_type::RIGHT_BRACKET; return 1;
+        case ';': type = Token_type::SEMICOLON; return 1;
+        case ',': type = Token_type::COMMA; return 1;
+        case '.': type = Token_type::DOT; return 1;
+        case '+':
+            if (next_ch == '=') { type = Token_type::PLUS_EQUAL; return 2; }
+            type = Token_type::PLUS; return 1;
+        case '-':
+            if (next_ch == '=') { type = Token_type::MINUS_EQUAL; return 2; }
+            if (next_ch == '>') { type = Token_type::ARROW; return 2; }
+            type = Token_type::MINUS; return 1;
+        case '*':
+            if (next_ch == '=') { type = Token_type::STAR_EQUAL; return 2; }
+            type = Token_type::STAR; return 1;
+        case '/':
+            if (next_ch == '=') { type = Token_type::SLASH_EQUAL; return 2; }
+            type = Token_type::SLASH; return 1;
+        case '%':
+            if (next_ch == '=') { type = Token_type::PERCENT_EQUAL; return 2; }
+            type = Token_type::PERCENT; return 1;
+        case '^':
+            if (next_ch == '=') { type = Token_type::CARET_EQUAL; return 2; }
+            type = Token_type::CARET; return 1;
+        case '&':
+            if (next_ch == '&') { type = Token_type::AMPERSAND_AMPERSAND; return 2; }
+            if (next_ch == '=') { type = Token_type::AMPERSAND_EQUAL; return 2; }
+            type = Token_type::AMPERSAND; return 1;
+        case '|':
+            if (next_ch == '|') { type = Token_type::PIPE_PIPE; return 2; }
+            if (next_ch == '=') { type = Token_type::PIPE_EQUAL; return 2; }
+            type = Token_type::PIPE; return 1;
+        case '=':
+            if (next_ch == '=') { type = Token_type::EQUAL_EQUAL; return 2; }
+            type = Token_type::EQUAL; return 1;
+        case '!':
+            if (next_ch == '=') { type = Token_type::NOT_EQUAL; return 2; }
+            type = Token_type::BANG; return 1;
+        case ':':
+            if (next_ch == ':') { type = Token_type::COLON_COLON; return 2; }
+            type = Token_type::COLON; return 1;
+        case '<':
+            if (next_ch == '<') {
+                if (next_next_ch == '=') { type = Token_type::LEFT_SHIFT_EQUAL; return 3; }
+                type = Token_type::LEFT_SHIFT; return 2;
+            }
+            if (next_ch == '=') { type = Token_type::LESS_EQUAL; return 2; }
+            type = Token_type::LESS; return 1;
+        case '>':
+            if (next_ch == '>') {
+                if (next_next_ch == '=') { type = Token_type::RIGHT_SHIFT_EQUAL; return 3; }
+                type = Token_type::RIGHT_SHIFT; return 2;
+            }
+            if (next_ch == '=') { type = Token_type::GREATER_EQUAL; return 2; }
+            type = Token_type::GREATER; return 1;
+        // case '~': type = Token_type::TILDE; return 1;
+        default: return 0;
     }
-    now_str = "";
 }
 
-void Lexer::add_number(string &now_str) {
+void Lexer::add_identifier(std::string_view text) {
+    int keyword = keyword_index(text);
+    size_t begin = text.data() - source->data();
+    if (keyword >= 0) {
+        emit(Token(KEYWORDS[keyword].type, KEYWORDS[keyword].name, keyword), begin, begin + text.size());
+        return;
+    }
+    uint32_t id = interner->intern(text);
+    emit(Token(Token_type::IDENTIFIER, interner->name(id), id), begin, begin + text.size());
+}
+
+void Lexer::add_number(std::string_view text) {
     bool is_valid = true;
     // to do : 判断是否合法的数字
     // 只需要考虑整数
     // 需要考虑：后缀（比如 _i32..）与前缀（0x.. 0o.. 0b..）
     // 暂时没有实现，先不急
     if (is_valid) {
-        tokens.push_back(Token(Token_type::NUMBER, now_str));
+        Token token(Token_type::NUMBER, text);
+        // 只解码一次，错误（非法 / 溢出）先记下来，用到的时候再报
+        token.number = decode_integer_literal(text);
+        size_t begin = text.data() - source->data();
+        emit(token, begin, begin + text.size());
     } else {
         throw string("CE, invalid number");
     }
-    now_str = "";
 }
 
-// remark: 我没有考虑 cstring，但是目前数据没有
+void Lexer::emit_literal(Token_type type, std::string_view bytes, size_t begin, size_t end) {
+    emit(Token(type, literals->intern(bytes)), begin, end);
+}
+
+void Lexer::emit(Token token, size_t begin, size_t end) {
+    token.begin = begin;
+    token.end = end;
+    if (streaming) {
+        ring[(ring_head + ring_count) % RING_SIZE] = token;
+        ring_count++;
+    } else {
+        tokens.push_back(token);
+    }
+}
+
+void Lexer::reset(SourceBuffer_ptr source_, bool streaming_) {
+    source = source_;
+    state = LexState();
+    streaming = streaming_;
+    tokens.clear();
+    current_token_index = 0;
+    ring.assign(streaming ? RING_SIZE : 0, Token(Token_type::IDENTIFIER, ""));
+    ring_head = ring_count = 0;
+}
+
 void Lexer::read_and_get_tokens() {
-    string line, all_code;
-    // 是否在 /* ... */ 多行注释中
-    bool is_in_block_comment = false;
-    // 是否在 // 单行注释中
-    bool is_in_line_comment = false;
-    bool is_in_common_string = false; // 是否在 "" 中
-    bool is_in_raw_string = false;    // 是否在 r"" 或者 r#""# 中
-    size_t raw_string_level = 0;         // raw string 的 # 数量
-    bool is_in_char = false; // 是否在 '' 中
-    bool is_in_number = false; // 是否在一个数字中
-    bool is_in_identifier = false; // 是否在一个标识符中
-    while (getline(std::cin, line)) {
-        all_code += line + "\n";
-    }
-    all_code += "   ";
-    size_t code_len = all_code.size();
-    string now_str = "";
-    for (size_t i = 0; i + 2 < code_len; i++) {
-        char now_ch = all_code[i];
-        char next_ch = all_code[i + 1];
-        char next_next_ch = all_code[i + 2];
+    tokenize(SourceBuffer::from_stdin());
+}
+
+void Lexer::read_and_get_tokens(const string &path) {
+    tokenize(SourceBuffer::from_file(path));
+}
+
+void Lexer::tokenize(SourceBuffer_ptr source_) {
+    reset(source_, false);
+    lex_more();
+}
+
+void Lexer::start_stream(SourceBuffer_ptr source_) {
+    reset(source_, true);
+}
+
+vector<size_t> Lexer::find_chunk_borders(std::string_view text, size_t chunk_count) const {
+    // 状态转移和 lex_more 保持一致，只是不产生 token
+    size_t n = text.size();
+    auto at = [&](size_t pos) { return pos < n ? text[pos] : ' '; };
+    vector<size_t> borders = {0};
+    size_t i = 0;
+    while (i < n) {
+        char ch = text[i];
+        if (ch == '\n') {
+            // 行首一定不在任何注释 / 字符串 / 字符中，也不在 identifier / number 中
+            if (borders.size() < chunk_count && i + 1 < n && i + 1 >= borders.size() * n / chunk_count) {
+                borders.push_back(i + 1);
+            }
+            i++;
+        } else if (ch == '/' && at(i + 1) == '*') {
+            size_t j = i + 2;
+            while (true) {
+                j = scan::find_byte(text, j, '*');
+                if (j >= n) return {};
+                if (at(j + 1) == '/') break;
+                j++;
+            }
+            i = j + 2;
+        } else if (ch == '/' && at(i + 1) == '/') {
+            // 停在换行符上，让上面判断能不能在这里切分
+            i = scan::find_byte(text, i + 2, '\n');
+        } else if (ch == 'r' && (at(i + 1) == '\"' || at(i + 1) == '#')) {
+            size_t level = 0;
+            size_t j = i + 1;
+            while (at(j) == '#') {
+                level++;
+                j++;
+            }
+            if (at(j) != '\"') return {};
+            j++;
+            while (true) {
+                j = scan::find_byte(text, j, '\"');
+                if (j >= n) return {};
+                size_t k = 1;
+                while (k <= level && at(j + k) == '#') k++;
+                if (k > level) break;
+                j++;
+            }
+            i = j + 1 + level;
+        } else if (ch == '\"') {
+            size_t j = i + 1;
+            while (true) {
+                j = scan::find_either(text, j, '\"', '\\');
+                if (j >= n) return {};
+                if (text[j] == '\"') break;
+                j += 2;
+            }
+            i = j + 1;
+        } else if (ch == '\'') {
+            i += at(i + 1) == '\\' ? 4 : 3;
+        } else {
+            i++;
+        }
+    }
+    borders.push_back(n);
+    return borders;
+}
+
+void Lexer::tokenize_parallel(SourceBuffer_ptr source_, size_t thread_count, size_t min_chunk_size) {
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    size_t chunk_count = std::min(thread_count, source_->size() / std::max<size_t>(1, min_chunk_size));
+    vector<size_t> borders;
+    if (chunk_count > 1) {
+        borders = find_chunk_borders(source_->view(), chunk_count);
+    }
+    if (borders.size() <= 2) {
+        tokenize(source_);
+        return;
+    }
+    chunk_count = borders.size() - 1;
+    // 每一块用自己的 Lexer（也就有自己的 interner），互不干扰
+    vector<vector<Token>> chunk_tokens(chunk_count);
+    vector<SymbolInterner_ptr> chunk_interners(chunk_count);
+    vector<LiteralPool_ptr> chunk_literals(chunk_count);
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<bool> failed{false};
+    auto worker = [&]() {
+        size_t k;
+        while (!failed && (k = next_chunk++) < chunk_count) {
+            try {
+                Lexer chunk_lexer;
+                chunk_lexer.tokenize(SourceBuffer::slice(source_, borders[k], borders[k + 1] - borders[k]));
+                chunk_tokens[k] = std::move(chunk_lexer.tokens);
+                chunk_interners[k] = chunk_lexer.interner;
+                chunk_literals[k] = chunk_lexer.literals;
+            } catch (...) {
+                failed = true;
+            }
+        }
+    };
+    vector<std::thread> threads;
+    for (size_t t = 1; t < std::min(thread_count, chunk_count); t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (failed) {
+        // 有错误的话顺序重新分一遍，保证报出来的是第一个错误
+        tokenize(source_);
+        return;
+    }
+    // 按顺序拼起来，标识符重新放进自己的 interner，id 和顺序分词时一样；
+    // 字面量的内容拷进自己的 literal pool，每一块的 Lexer 析构之后 value 仍然有效
+    reset(source_, false);
+    state.pos = source->size() + 1;
+    state.finished = true;
+    for (size_t k = 0; k < chunk_count; k++) {
+        for (Token &token : chunk_tokens[k]) {
+            if (token.type == Token_type::IDENTIFIER) {
+                token.symbol_id = interner->intern(token.value);
+                token.value = interner->name(token.symbol_id);
+            } else if (token.type == Token_type::STRING || token.type == Token_type::CHAR) {
+                token.value = literals->intern(token.value);
+            }
+            token.begin += borders[k];
+            token.end += borders[k];
+            tokens.push_back(token);
+        }
+        chunk_tokens[k].clear();
+        chunk_tokens[k].shrink_to_fit();
+    }
+}
+
+void Lexer::relex(size_t offset, size_t removed_length, std::string_view inserted_text) {
+    if (streaming || view_parent != nullptr) {
+        throw string("Error, relex needs tokens from tokenize");
+    }
+    std::string_view old_text = source->view();
+    if (offset > old_text.size() || removed_length > old_text.size() - offset) {
+        throw string("Error, edit out of range");
+    }
+    string new_code;
+    new_code.reserve(old_text.size() - removed_length + inserted_text.size());
+    new_code.append(old_text.substr(0, offset));
+    new_code.append(inserted_text);
+    new_code.append(old_text.substr(offset + removed_length));
+    SourceBuffer_ptr new_source = SourceBuffer::from_string(std::move(new_code));
+    std::string_view new_text = new_source->view();
+    // 修改之后的 token 整体平移 delta
+    ptrdiff_t delta = static_cast<ptrdiff_t>(inserted_text.size()) - static_cast<ptrdiff_t>(removed_length);
+    size_t new_edit_end = offset + inserted_text.size();
+    size_t old_edit_end = offset + removed_length;
+
+    // 扫描一个 token 最多向后看到它的 end，所以 end < offset 的 token 都不受影响
+    // 从最后一个这样的 token 的开头重新扫描，token 的开头一定不在注释 / 字符串 / 字符中
+    size_t first_touched = std::partition_point(tokens.begin(), tokens.end(),
+        [&](const Token &token) { return token.end < offset; }) - tokens.begin();
+    size_t restart_index = first_touched == 0 ? 0 : first_touched - 1;
+    size_t restart_pos = first_touched == 0 ? 0 : tokens[restart_index].begin;
+    // 修改之后的第一个旧 token，从这里开始可能可以直接复用
+    size_t reuse_index = std::partition_point(tokens.begin(), tokens.end(),
+        [&](const Token &token) { return token.begin < old_edit_end; }) - tokens.begin();
+
+    // 共用 interner 和 literal pool，新标识符的 id 和旧的一致
+    Lexer sub_lexer;
+    sub_lexer.interner = interner;
+    sub_lexer.literals = literals;
+    sub_lexer.reset(new_source, true);
+    sub_lexer.state.pos = restart_pos;
+    vector<Token> relexed;
+    bool synced = false;
+    while (sub_lexer.has_more_tokens()) {
+        Token token = sub_lexer.consume_token();
+        if (token.begin >= new_edit_end) {
+            // 新 token 和某个旧 token 在同一个位置开始时，两边都处于干净状态，
+            // 后面的代码又完全一样，之后的 token 必然相同，不用再往后扫了
+            while (reuse_index < tokens.size() &&
+                   static_cast<ptrdiff_t>(tokens[reuse_index].begin) + delta < static_cast<ptrdiff_t>(token.begin)) {
+                reuse_index++;
+            }
+            if (reuse_index < tokens.size() &&
+                static_cast<ptrdiff_t>(tokens[reuse_index].begin) + delta == static_cast<ptrdiff_t>(token.begin)) {
+                synced = true;
+                break;
+            }
+        }
+        relexed.push_back(token);
+    }
+
+    // 指向源代码的 value（符号和数字）要改为指向新代码，标识符和字面量指向 interner / literal pool，不用改
+    auto move_to_new_source = [&](Token &token, ptrdiff_t shift) {
+        token.begin += shift;
+        token.end += shift;
+        if (token.symbol_id == SymbolInterner::NO_SYMBOL && token.type != Token_type::STRING &&
+            token.type != Token_type::CHAR) {
+            token.value = new_text.substr(token.begin, token.end - token.begin);
+        }
+    };
+    vector<Token> result;
+    result.reserve(restart_index + relexed.size() + (synced ? tokens.size() - reuse_index : 0));
+    for (size_t k = 0; k < restart_index; k++) {
+        result.push_back(tokens[k]);
+        move_to_new_source(result.back(), 0);
+    }
+    result.insert(result.end(), relexed.begin(), relexed.end());
+    if (synced) {
+        for (size_t k = reuse_index; k < tokens.size(); k++) {
+            result.push_back(tokens[k]);
+            move_to_new_source(result.back(), delta);
+        }
+    }
+    source = new_source;
+    tokens = std::move(result);
+    current_token_index = 0;
+}
+
+// remark: 我没有考虑 cstring，但是目前数据没有
+void Lexer::lex_more() {
+    if (state.finished) {
+        return;
+    }
+    bool &is_in_block_comment = state.is_in_block_comment;
+    bool &is_in_line_comment = state.is_in_line_comment;
+    bool &is_in_common_string = state.is_in_common_string;
+    bool &is_in_raw_string = state.is_in_raw_string;
+    size_t &raw_string_level = state.raw_string_level;
+    bool &is_in_char = state.is_in_char;
+    bool &is_in_number = state.is_in_number;
+    bool &is_in_identifier = state.is_in_identifier;
+    size_t &token_start = state.token_start;
+    bool &string_has_escape = state.string_has_escape;
+    string &now_str = state.now_str;
+    const SourceBuffer &code = *source;
+    // 末尾之后的位置由 SourceBuffer::at 视为空白，多扫一个位置来结束最后的 token
+    size_t code_len = code.size() + 1;
+    std::string_view text = code.view();
+    // 结束当前的 identifier / number，它在源代码中是 [token_start, end)
+    auto flush_word = [&](size_t end) {
+        if (is_in_number) {
+            add_number(text.substr(token_start, end - token_start));
+            is_in_number = false;
+        }
+        if (is_in_identifier) {
+            add_identifier(text.substr(token_start, end - token_start));
+            is_in_identifier = false;
+        }
+    };
+    for (size_t i = state.pos; i < code_len; i++) {
+        // 流式分词时，一旦有了新 token 就先停下来
+        if (ring_count > 0) {
+            state.pos = i;
+            return;
+        }
+        char now_ch = code.at(i);
+        char next_ch = code.at(i + 1);
+        char next_next_ch = code.at(i + 2);
         // 处理多行注释 : /* ... */
+        // 注释和字符串内部用 scan 批量跳到下一个可能有意义的字符
         if (is_in_block_comment) {
-            if (now_ch == '*' && next_ch == '/') {
+            i = scan::find_byte(text, i, '*');
+            if (code.at(i) == '*' && code.at(i + 1) == '/') {
                 is_in_block_comment = false;
                 i++;
             }
@@ -235,7 +614,8 @@ void Lexer::read_and_get_tokens() {
         }
         // 处理单行注释 : // ...
         if (is_in_line_comment) {
-            if (now_ch == '\n') {
+            i = scan::find_byte(text, i, '\n');
+            if (code.at(i) == '\n') {
                 is_in_line_comment = false;
             }
             continue;
@@ -246,13 +626,13 @@ void Lexer::read_and_get_tokens() {
                 if (next_next_ch != '\'') {
                     throw string("CE, find no '");
                 }
-                tokens.push_back(Token(Token_type::CHAR, get_escape_character(next_ch)));
+                emit_literal(Token_type::CHAR, get_escape_character(next_ch), i - 1, i + 3);
                 i += 2;
             } else {
                 if (next_ch != '\'') {
                     throw string("CE, find no '");
                 }
-                tokens.push_back(Token(Token_type::CHAR, string(1, now_ch)));
+                emit_literal(Token_type::CHAR, text.substr(i, 1), i - 1, i + 2);
                 i += 1;
             }
             is_in_char = false;
@@ -261,13 +641,26 @@ void Lexer::read_and_get_tokens() {
         if (is_in_common_string) {
             if (now_ch == '\"') {
                 is_in_common_string = false;
-                tokens.push_back(Token(Token_type::STRING, now_str));
-                now_str = "";
+                if (string_has_escape) {
+                    emit_literal(Token_type::STRING, now_str, token_start - 1, i + 1);
+                    now_str = "";
+                } else {
+                    emit_literal(Token_type::STRING, text.substr(token_start, i - token_start),
+                                 token_start - 1, i + 1);
+                }
             } else if (now_ch == '\\') {
+                if (!string_has_escape) {
+                    string_has_escape = true;
+                    now_str = string(text.substr(token_start, i - token_start));
+                }
                 now_str += get_escape_character(next_ch);
                 i++;
             } else {
-                now_str += now_ch;
+                size_t end = scan::find_either(text, i + 1, '\"', '\\');
+                if (string_has_escape) {
+                    now_str += text.substr(i, end - i);
+                }
+                i = end - 1;
             }
             continue;
         }
@@ -275,30 +668,32 @@ void Lexer::read_and_get_tokens() {
             if (now_ch == '\"') {
                 bool can_end = true;
                 for (size_t j = 1; j <= raw_string_level; j++) {
-                    if (i + j >= code_len || all_code[i + j] != '#') {
+                    if (code.at(i + j) != '#') {
                         can_end = false;
                         break;
                     }
                 }
                 if (can_end) {
                     is_in_raw_string = false;
-                    tokens.push_back(Token(Token_type::STRING, now_str));
-                    now_str = "";
+                    // raw string 从 r 开始：r + raw_string_level 个 # + "
+                    emit_literal(Token_type::STRING, text.substr(token_start, i - token_start),
+                                 token_start - raw_string_level - 2, i + raw_string_level + 1);
                     i += raw_string_level;
-                } else {
-                    now_str += now_ch;
                 }
             } else {
-                now_str += now_ch;
+                i = scan::find_byte(text, i + 1, '\"') - 1;
             }
             continue;
         }
+        // 注释也会结束当前的 identifier / number
         if (now_ch == '/' && next_ch == '*') {
+            flush_word(i);
             is_in_block_comment = true;
             i++;
             continue;
         }
         if (now_ch == '/' && next_ch == '/') {
+            flush_word(i);
             is_in_line_comment = true;
             i++;
             continue;
@@ -306,15 +701,16 @@ void Lexer::read_and_get_tokens() {
         if (is_not_symbol(now_ch)) {
             // 需要特殊考虑：raw string 的情况
             if (now_ch == 'r' && (next_ch == '\"' || next_ch == '#')) {
+                flush_word(i);
                 is_in_raw_string = true;
                 if (next_ch == '#') {
                     raw_string_level = 1;
                     size_t j = i + 2;
-                    while (j < code_len && all_code[j] == '#') {
+                    while (code.at(j) == '#') {
                         raw_string_level++;
                         j++;
                     }
-                    if (j < code_len && all_code[j] == '\"') {
+                    if (code.at(j) == '\"') {
                         i = j;
                     } else {
                         throw string("CE, no starting of raw string");
@@ -323,52 +719,40 @@ void Lexer::read_and_get_tokens() {
                     i++;
                     raw_string_level = 0;
                 }
-                if (is_in_number) {
-                    add_number(now_str);
-                    is_in_number = false;
-                }
-                if (is_in_identifier) {
-                    add_identifier(now_str);
-                    is_in_identifier = false;
-                }
+                token_start = i + 1;
                 continue;
             }
-            if (is_in_number || is_in_identifier) {now_str += now_ch;}
-            else {
-                now_str = string(1, now_ch);
+            if (!is_in_number && !is_in_identifier) {
+                token_start = i;
                 if (now_ch <= '9' && now_ch >= '0') {is_in_number = true;}
                 else {is_in_identifier = true;}
             }
+            // 一次跳过整段字母数字，但末尾的 r 后面如果是 " 或 #，要留给下一轮当作 raw string 的开头
+            size_t end = scan::skip_identifier(text, i + 1);
+            if (end - 1 > i && code.at(end - 1) == 'r' && (code.at(end) == '\"' || code.at(end) == '#')) {
+                end--;
+            }
+            i = end - 1;
         }
         else {
-            if (is_in_number) {
-                add_number(now_str);
-                is_in_number = false;
-            }
-            if (is_in_identifier) {
-                add_identifier(now_str);
-                is_in_identifier = false;
-            }
+            flush_word(i);
             // 空白字符直接 continue
             if (now_ch == ' ' || now_ch == '\t' || now_ch == '\r' || now_ch == '\n') {
+                i = scan::skip_whitespace(text, i + 1) - 1;
                 continue;
             }
-            // 分成长度为 3 2 1 的符号来处理
-            string three_str = string(1, now_ch) + string(1, next_ch) + string(1, next_next_ch);
-            string two_str = string(1, now_ch) + string(1, next_ch);
-            string one_str = string(1, now_ch);
-            if (symbol_map.find(three_str) != symbol_map.end()) {
-                tokens.push_back(Token(symbol_map[three_str], three_str));
-                i += 2;
-            } else if (symbol_map.find(two_str) != symbol_map.end()) {
-                tokens.push_back(Token(symbol_map[two_str], two_str));
-                i += 1;
-            } else if (symbol_map.find(one_str) != symbol_map.end()) {
-                tokens.push_back(Token(symbol_map[one_str], one_str));
+            // 按最长匹配识别符号，越界的部分是空白，不会匹配上
+            Token_type symbol_type;
+            size_t symbol_len = match_symbol(now_ch, next_ch, next_next_ch, symbol_type);
+            if (symbol_len > 0) {
+                emit(Token(symbol_type, text.substr(i, symbol_len)), i, i + symbol_len);
+                i += symbol_len - 1;
             } else {
                 // 考虑 " " 和 ' ' 的情况，这个时候是作为 string / char
                 if (now_ch == '\"') {
                     is_in_common_string = true;
+                    string_has_escape = false;
+                    token_start = i + 1;
                     continue;
                 }
                 if (now_ch == '\'') {
@@ -379,41 +763,79 @@ void Lexer::read_and_get_tokens() {
             }
         }
     }
+    state.pos = code_len;
+    state.finished = true;
     if (is_in_char || is_in_common_string || is_in_raw_string) {
         throw string("CE, find no end char or string");
     }
-    if (is_in_number) {
-        add_number(now_str);
-    } else if (is_in_identifier) {
-        add_identifier(now_str);
-    }
+    flush_word(text.size());
     if (is_in_block_comment) {
         throw string("CE, find no end of block comment");
     }
 }
 
-Token Lexer::peek_token() const {
-    if (current_token_index < tokens.size()) {
-        return tokens[current_token_index];
-    } else {
-        throw string("CE, no more token to peek");
+void Lexer::fill_ring() {
+    while (ring_count == 0 && !state.finished) {
+        lex_more();
+    }
+}
+
+Lexer Lexer::view(const Lexer &parent, size_t begin, size_t end) {
+    if (parent.streaming || parent.view_parent != nullptr || begin > end || end > parent.tokens.size()) {
+        throw string("Error, bad token view");
+    }
+    Lexer lexer;
+    lexer.source = parent.source;
+    lexer.interner = parent.interner;
+    lexer.literals = parent.literals;
+    lexer.view_parent = &parent;
+    lexer.current_token_index = begin;
+    lexer.view_end = end;
+    return lexer;
+}
+
+void Lexer::seek_token(size_t index) {
+    if (streaming || index > token_limit()) {
+        throw string("Error, bad token index");
     }
+    current_token_index = index;
+}
+
+const Token &Lexer::peek_token() {
+    if (streaming) {
+        fill_ring();
+        if (ring_count > 0) {
+            return ring[ring_head];
+        }
+    } else if (current_token_index < token_limit()) {
+        return token_list()[current_token_index];
+    }
+    throw string("CE, no more token to peek");
 }
 
 Token Lexer::consume_token() {
     Token token = peek_token();
-    current_token_index++;
+    if (streaming) {
+        ring_head = (ring_head + 1) % RING_SIZE;
+        ring_count--;
+    } else {
+        current_token_index++;
+    }
     return token;
 }
 
-bool Lexer::has_more_tokens() const {
-    return current_token_index < tokens.size();
+bool Lexer::has_more_tokens() {
+    if (streaming) {
+        fill_ring();
+        return ring_count > 0;
+    }
+    return current_token_index < token_limit();
 }
 
 Token Lexer::consume_expect_token(Token_type type) {
     Token token = consume_token();
     if (token.type != type) {
-        throw string("CE, expected ") + token_type_to_string(type) + string(" but got ") + token.value;
+        throw string("CE, expected ") + token_type_to_string(type) + string(" but got ") + token.str();
     }
     return token;
 }
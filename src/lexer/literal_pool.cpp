@@ -0,0 +1,33 @@
+#include "lexer/literal_pool.h"
+#include <cstring>
+
+std::string_view LiteralPool::allocate(std::string_view bytes) {
+    if (bytes.empty()) {
+        return std::string_view();
+    }
+    char *dest = nullptr;
+    if (bytes.size() > BLOCK_SIZE / 4) {
+        // 很长的字面量单独一块，不浪费当前块剩下的空间
+        large_blocks.push_back(std::make_unique<char[]>(bytes.size()));
+        dest = large_blocks.back().get();
+    } else {
+        if (block_used + bytes.size() > BLOCK_SIZE) {
+            blocks.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+            block_used = 0;
+        }
+        dest = blocks.back().get() + block_used;
+        block_used += bytes.size();
+    }
+    std::memcpy(dest, bytes.data(), bytes.size());
+    return std::string_view(dest, bytes.size());
+}
+
+std::string_view LiteralPool::intern(std::string_view bytes) {
+    auto it = literals.find(bytes);
+    if (it != literals.end()) {
+        return *it;
+    }
+    std::string_view stored = allocate(bytes);
+    literals.insert(stored);
+    return stored;
+}
@@ -0,0 +1,225 @@
+#include "lexer/scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_HAS_X86 1
+#include <immintrin.h>
+#else
+#define SCAN_HAS_X86 0
+#endif
+
+namespace scan {
+
+namespace {
+
+inline bool is_whitespace_char(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+inline bool is_identifier_char(char ch) {
+    if (ch <= '9' && ch >= '0') return true;
+    if (ch <= 'z' && ch >= 'a') return true;
+    if (ch <= 'Z' && ch >= 'A') return true;
+    return ch == '_';
+}
+
+// ---------------- 逐字节实现，也用来处理 SIMD 剩下的尾巴 ----------------
+
+size_t skip_whitespace_scalar(const char *data, size_t pos, size_t size) {
+    while (pos < size && is_whitespace_char(data[pos])) pos++;
+    return pos;
+}
+
+size_t skip_identifier_scalar(const char *data, size_t pos, size_t size) {
+    while (pos < size && is_identifier_char(data[pos])) pos++;
+    return pos;
+}
+
+size_t find_either_scalar(const char *data, size_t pos, size_t size, char ch1, char ch2) {
+    while (pos < size && data[pos] != ch1 && data[pos] != ch2) pos++;
+    return pos;
+}
+
+#if SCAN_HAS_X86
+
+// ---------------- SSE2：一次 16 字节 ----------------
+
+// 每个字节是否在 [lo, hi] 之间（有符号比较，>= 0x80 的字节一定不在 ASCII 区间里）
+inline __m128i in_range_sse2(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+inline __m128i whitespace_mask_sse2(__m128i v) {
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    __m128i tab = _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'));
+    __m128i cr = _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'));
+    __m128i lf = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+    return _mm_or_si128(_mm_or_si128(space, tab), _mm_or_si128(cr, lf));
+}
+
+inline __m128i identifier_mask_sse2(__m128i v) {
+    // 大写字母 | 0x20 之后变成小写字母，两段字母区间合成一次比较
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i alpha = in_range_sse2(lower, 'a', 'z');
+    __m128i digit = in_range_sse2(v, '0', '9');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+}
+
+size_t skip_whitespace_sse2(const char *data, size_t pos, size_t size) {
+    while (pos + 16 <= size) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(whitespace_mask_sse2(v))) & 0xFFFFu;
+        if (stop != 0) return pos + __builtin_ctz(stop);
+        pos += 16;
+    }
+    return skip_whitespace_scalar(data, pos, size);
+}
+
+size_t skip_identifier_sse2(const char *data, size_t pos, size_t size) {
+    while (pos + 16 <= size) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(identifier_mask_sse2(v))) & 0xFFFFu;
+        if (stop != 0) return pos + __builtin_ctz(stop);
+        pos += 16;
+    }
+    return skip_identifier_scalar(data, pos, size);
+}
+
+size_t find_either_sse2(const char *data, size_t pos, size_t size, char ch1, char ch2) {
+    __m128i c1 = _mm_set1_epi8(ch1);
+    __m128i c2 = _mm_set1_epi8(ch2);
+    while (pos + 16 <= size) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, c1), _mm_cmpeq_epi8(v, c2));
+        unsigned found = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (found != 0) return pos + __builtin_ctz(found);
+        pos += 16;
+    }
+    return find_either_scalar(data, pos, size, ch1, ch2);
+}
+
+// ---------------- AVX2：一次 32 字节 ----------------
+
+__attribute__((target("avx2")))
+inline __m256i in_range_avx2(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+__attribute__((target("avx2")))
+size_t skip_whitespace_avx2(const char *data, size_t pos, size_t size) {
+    while (pos + 32 <= size) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+        __m256i tab = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'));
+        __m256i cr = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'));
+        __m256i lf = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(space, tab), _mm256_or_si256(cr, lf));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+        if (stop != 0) return pos + __builtin_ctz(stop);
+        pos += 32;
+    }
+    return skip_whitespace_sse2(data, pos, size);
+}
+
+__attribute__((target("avx2")))
+size_t skip_identifier_avx2(const char *data, size_t pos, size_t size) {
+    while (pos + 32 <= size) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i alpha = in_range_avx2(lower, 'a', 'z');
+        __m256i digit = in_range_avx2(v, '0', '9');
+        __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+        __m256i ident = _mm256_or_si256(_mm256_or_si256(alpha, digit), underscore);
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ident));
+        if (stop != 0) return pos + __builtin_ctz(stop);
+        pos += 32;
+    }
+    return skip_identifier_sse2(data, pos, size);
+}
+
+__attribute__((target("avx2")))
+size_t find_either_avx2(const char *data, size_t pos, size_t size, char ch1, char ch2) {
+    __m256i c1 = _mm256_set1_epi8(ch1);
+    __m256i c2 = _mm256_set1_epi8(ch2);
+    while (pos + 32 <= size) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, c1), _mm256_cmpeq_epi8(v, c2));
+        unsigned found = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+        if (found != 0) return pos + __builtin_ctz(found);
+        pos += 32;
+    }
+    return find_either_sse2(data, pos, size, ch1, ch2);
+}
+
+#endif // SCAN_HAS_X86
+
+struct ScanImpl {
+    ScanLevel level;
+    size_t (*skip_whitespace)(const char *, size_t, size_t);
+    size_t (*skip_identifier)(const char *, size_t, size_t);
+    size_t (*find_either)(const char *, size_t, size_t, char, char);
+};
+
+ScanLevel max_supported_level() {
+#if SCAN_HAS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return ScanLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return ScanLevel::SSE2;
+#endif
+    return ScanLevel::SCALAR;
+}
+
+ScanImpl make_impl(ScanLevel level) {
+#if SCAN_HAS_X86
+    if (level == ScanLevel::AVX2) {
+        return {ScanLevel::AVX2, skip_whitespace_avx2, skip_identifier_avx2, find_either_avx2};
+    }
+    if (level == ScanLevel::SSE2) {
+        return {ScanLevel::SSE2, skip_whitespace_sse2, skip_identifier_sse2, find_either_sse2};
+    }
+#endif
+    return {ScanLevel::SCALAR, skip_whitespace_scalar, skip_identifier_scalar, find_either_scalar};
+}
+
+ScanImpl &current_impl() {
+    static ScanImpl impl = make_impl(max_supported_level());
+    return impl;
+}
+
+} // namespace
+
+ScanLevel scan_level() {
+    return current_impl().level;
+}
+
+void set_scan_level(ScanLevel level) {
+    ScanLevel max_level = max_supported_level();
+    if (static_cast<int>(level) > static_cast<int>(max_level)) {
+        level = max_level;
+    }
+    current_impl() = make_impl(level);
+}
+
+size_t skip_whitespace(std::string_view text, size_t pos) {
+    if (pos >= text.size()) return pos;
+    return current_impl().skip_whitespace(text.data(), pos, text.size());
+}
+
+size_t skip_identifier(std::string_view text, size_t pos) {
+    if (pos >= text.size()) return pos;
+    return current_impl().skip_identifier(text.data(), pos, text.size());
+}
+
+size_t find_byte(std::string_view text, size_t pos, char ch) {
+    if (pos >= text.size()) return pos;
+    return current_impl().find_either(text.data(), pos, text.size(), ch, ch);
+}
+
+size_t find_either(std::string_view text, size_t pos, char ch1, char ch2) {
+    if (pos >= text.size()) return pos;
+    return current_impl().find_either(text.data(), pos, text.size(), ch1, ch2);
+}
+
+} // namespace scan
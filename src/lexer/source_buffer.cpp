@@ -0,0 +1,112 @@
+#include "lexer/source_buffer.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceBuffer::~SourceBuffer() {
+    if (mapped_ != nullptr) {
+        munmap(mapped_, mapped_size_);
+    }
+}
+
+bool SourceBuffer::map_fd(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    // 只有从文件开头读的时候才能整体映射
+    if (lseek(fd, 0, SEEK_CUR) != 0) {
+        return false;
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+    if (file_size == 0) {
+        // 空文件不能 mmap，直接当作空串
+        data_ = owned_.data();
+        size_ = 0;
+        return true;
+    }
+    void *addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    // 词法分析是从头到尾顺序扫描
+    madvise(addr, file_size, MADV_SEQUENTIAL);
+    mapped_ = addr;
+    mapped_size_ = file_size;
+    data_ = static_cast<const char *>(addr);
+    size_ = file_size;
+    return true;
+}
+
+void SourceBuffer::read_fd(int fd, size_t size_hint) {
+    // 先按 hint 预分配，不够再成倍扩容，只做整块 read
+    size_t capacity = size_hint > 0 ? size_hint + 1 : (1 << 16);
+    owned_.resize(capacity);
+    size_t length = 0;
+    while (true) {
+        if (length == owned_.size()) {
+            owned_.resize(owned_.size() * 2);
+        }
+        ssize_t got = read(fd, owned_.data() + length, owned_.size() - length);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            throw string("Error, failed to read source code");
+        }
+        if (got == 0) break;
+        length += static_cast<size_t>(got);
+    }
+    owned_.resize(length);
+    data_ = owned_.data();
+    size_ = length;
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::from_file(const string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw string("Error, cannot open source file ") + path;
+    }
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    try {
+        if (!buffer->map_fd(fd)) {
+            buffer->read_fd(fd, 0);
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    // mmap 之后 fd 可以直接关掉
+    close(fd);
+    return buffer;
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::from_stdin() {
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    if (!buffer->map_fd(STDIN_FILENO)) {
+        struct stat st;
+        size_t size_hint = 0;
+        if (fstat(STDIN_FILENO, &st) == 0 && st.st_size > 0) {
+            size_hint = static_cast<size_t>(st.st_size);
+        }
+        buffer->read_fd(STDIN_FILENO, size_hint);
+    }
+    return buffer;
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::from_string(string code) {
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->owned_ = std::move(code);
+    buffer->data_ = buffer->owned_.data();
+    buffer->size_ = buffer->owned_.size();
+    return buffer;
+}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::slice(std::shared_ptr<SourceBuffer> parent,
+                                                  size_t offset, size_t length) {
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->data_ = parent->data_ + offset;
+    buffer->size_ = length;
+    buffer->parent_ = parent;
+    return buffer;
+}
@@ -0,0 +1,124 @@
+#include "parser/ast_cache.h"
+#include "ast/flat_ast.h"
+#include "lexer/source_buffer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'R', 'C', 'A', 'S', 'T', 'C', 'H', 'E'};
+
+// 缓存文件头，后面紧跟着 FlatAST 序列化的结果
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t source_hash;
+    uint64_t source_size;
+    uint64_t payload_hash;
+    uint64_t payload_size;
+    uint64_t node_count;
+};
+
+} // namespace
+
+ASTCache ASTCache::from_env() {
+    const char *dir = std::getenv(DIR_ENV);
+    return ASTCache(dir == nullptr ? "" : dir);
+}
+
+uint64_t ASTCache::hash(std::string_view data) {
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char ch : data) {
+        h ^= ch;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+string ASTCache::path_for(uint64_t source_hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ast", static_cast<unsigned long long>(source_hash));
+    return (std::filesystem::path(dir) / name).string();
+}
+
+std::unique_ptr<ParsedAST> ASTCache::load(std::string_view source) const {
+    if (!enabled()) {
+        return nullptr;
+    }
+    uint64_t source_hash = hash(source);
+    try {
+        SourceBuffer_ptr file = SourceBuffer::from_file(path_for(source_hash));
+        std::string_view data = file->view();
+        Header header;
+        if (data.size() < sizeof(Header)) {
+            return nullptr;
+        }
+        std::memcpy(&header, data.data(), sizeof(Header));
+        std::string_view payload = data.substr(sizeof(Header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+            header.header_size != sizeof(Header) || header.source_hash != source_hash ||
+            header.source_size != source.size() || header.payload_size != payload.size() ||
+            header.payload_hash != hash(payload)) {
+            return nullptr;
+        }
+        FlatAST flat;
+        if (!FlatAST::deserialize(payload, flat) || flat.size() != header.node_count) {
+            return nullptr;
+        }
+        auto ast = std::make_unique<ParsedAST>();
+        ast->items = flat.to_ast(ast->arena);
+        ast->node_count = flat.size();
+        return ast;
+    } catch (const string &) {
+        // 打不开或者结构不对，当作没有命中
+        return nullptr;
+    }
+}
+
+void ASTCache::store(std::string_view source, const ParsedAST &ast) const {
+    if (!enabled()) {
+        return;
+    }
+    FlatAST flat = FlatAST::build(ast.items);
+    if (flat.size() != ast.node_count) {
+        // 树上的节点和 NodeId 对不上，重建出来会不一样，不缓存
+        return;
+    }
+    string payload = flat.serialize();
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.header_size = sizeof(Header);
+    header.source_hash = hash(source);
+    header.source_size = source.size();
+    header.payload_hash = hash(payload);
+    header.payload_size = payload.size();
+    header.node_count = flat.size();
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    string path = path_for(header.source_hash);
+    string temp_path = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return;
+        }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+    }
+}
@@ -1,23 +1,131 @@
 #include "parser/parser.h"
-#include "ast/visitor.h"
+#include "tools/tools.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <optional>
+#include <thread>
 
 vector<Item_ptr> Parser::parse() {
     vector<Item_ptr> items;
     while (lexer.has_more_tokens()) {
         items.push_back(parse_item());
     }
-    // 给每个 AST 节点生成唯一 id
-    ASTIdGenerator id_generator;
-    for (auto &item : items) {
-        item->accept(id_generator);
+    return items;
+}
+
+vector<size_t> Parser::find_item_borders(const vector<Token> &tokens, size_t begin) {
+    vector<size_t> borders;
+    size_t i = begin;
+    while (i < tokens.size()) {
+        Token_type item_type = tokens[i].type;
+        if (item_type != Token_type::FN && item_type != Token_type::STRUCT && item_type != Token_type::ENUM &&
+            item_type != Token_type::IMPL && item_type != Token_type::CONST) {
+            return {};
+        }
+        borders.push_back(i);
+        // ( [ { 的嵌套深度，不区分括号种类，括号种类不匹配的话解析的时候会发现
+        size_t depth = 0;
+        bool finished = false;
+        for (; i < tokens.size() && !finished; i++) {
+            Token_type type = tokens[i].type;
+            if (type == Token_type::LEFT_PARENTHESIS || type == Token_type::LEFT_BRACKET ||
+                type == Token_type::LEFT_BRACE) {
+                depth++;
+            } else if (type == Token_type::RIGHT_PARENTHESIS || type == Token_type::RIGHT_BRACKET ||
+                       type == Token_type::RIGHT_BRACE) {
+                if (depth == 0) {
+                    return {};
+                }
+                depth--;
+                finished = depth == 0 && type == Token_type::RIGHT_BRACE && item_type != Token_type::CONST;
+            } else if (type == Token_type::SEMICOLON) {
+                finished = depth == 0 && item_type == Token_type::CONST;
+            }
+        }
+        if (!finished) {
+            return {};
+        }
+    }
+    borders.push_back(tokens.size());
+    return borders;
+}
+
+vector<Item_ptr> Parser::parse_parallel(size_t thread_count, size_t min_chunk_tokens) {
+    if (lexer.is_streaming()) {
+        return parse();
+    }
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    size_t begin = lexer.token_index();
+    size_t token_count = lexer.tokens.size() - begin;
+    size_t chunk_count = std::min(thread_count, token_count / std::max<size_t>(1, min_chunk_tokens));
+    vector<size_t> item_borders;
+    if (chunk_count > 1) {
+        item_borders = find_item_borders(lexer.tokens, begin);
     }
+    if (item_borders.size() <= 2) {
+        return parse();
+    }
+    // 相邻的 item 分成一段，每段的 token 个数差不多；chunk_borders 是每段第一个 item 的下标
+    vector<size_t> chunk_borders = {0};
+    for (size_t k = 1; k + 1 < item_borders.size(); k++) {
+        if (chunk_borders.size() < chunk_count &&
+            item_borders[k] - begin >= chunk_borders.size() * token_count / chunk_count) {
+            chunk_borders.push_back(k);
+        }
+    }
+    chunk_borders.push_back(item_borders.size() - 1);
+    chunk_count = chunk_borders.size() - 1;
+
+    // 每一段用自己的 Parser，NodeId 先从 0 开始编号，arena 最后交给这个 Parser
+    vector<vector<Item_ptr>> chunk_items(chunk_count);
+    vector<ASTArena> chunk_arenas(chunk_count);
+    vector<size_t> chunk_node_counts(chunk_count);
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<bool> failed{false};
+    auto worker = [&]() {
+        size_t k;
+        while (!failed && (k = next_chunk++) < chunk_count) {
+            try {
+                Lexer chunk_lexer = Lexer::view(lexer, item_borders[chunk_borders[k]], item_borders[chunk_borders[k + 1]]);
+                Parser chunk_parser(chunk_lexer);
+                for (size_t item = chunk_borders[k]; item < chunk_borders[k + 1] && !failed; item++) {
+                    chunk_items[k].push_back(chunk_parser.parse_item());
+                    // 每个 item 必须正好在预扫描出来的边界结束，否则和顺序解析不一致
+                    if (chunk_lexer.token_index() != item_borders[item + 1]) {
+                        failed = true;
+                    }
+                }
+                chunk_node_counts[k] = chunk_parser.node_count();
+                chunk_arenas[k].adopt(chunk_parser.arena);
+            } catch (...) {
+                failed = true;
+            }
+        }
+    };
+    run_in_parallel(std::min(thread_count, chunk_count), worker);
+    if (failed) {
+        // 有错误的话顺序重新解析一遍，保证报出来的是第一个错误
+        return parse();
+    }
+    // 按顺序拼起来，NodeId 加上前面所有段的节点个数，就和顺序解析时一样
+    vector<Item_ptr> items;
+    for (size_t k = 0; k < chunk_count; k++) {
+        size_t offset = next_node_id;
+        chunk_arenas[k].for_each_node([&](AST_Node *node) { node->NodeId += offset; });
+        arena.adopt(chunk_arenas[k]);
+        next_node_id += chunk_node_counts[k];
+        items.insert(items.end(), chunk_items[k].begin(), chunk_items[k].end());
+    }
+    lexer.seek_token(item_borders.back());
     return items;
 }
 
 Item_ptr Parser::parse_item() {
     // 这里只需要考虑 fn, struct, enum, impl, const 五种 item
-    Token token = lexer.peek_token();
+    const Token &token = lexer.peek_token();
     if (token.type == Token_type::FN) {
         return parse_fn_item();
     } else if (token.type == Token_type::STRUCT) {
@@ -29,7 +137,7 @@ Item_ptr Parser::parse_item() {
     } else if (token.type == Token_type::CONST) {
         return parse_const_item();
     } else {
-        throw string("CE, expected item but got ") + token.value;
+        throw string("CE, expected item but got ") + token.str();
     }
 }
 
@@ -37,7 +145,7 @@ FnItem_ptr Parser::parse_fn_item() {
     // example :
     // fn function_name(param1: Type1, param2: Type2, ...) -> ReturnType { body }
     lexer.consume_expect_token(Token_type::FN);
-    string function_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+    string function_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
     lexer.consume_expect_token(Token_type::LEFT_PARENTHESIS);
     fn_reciever_type receiver_type = fn_reciever_type::NO_RECEIVER;
     if (lexer.peek_token().type == Token_type::SELF) {
@@ -46,7 +154,7 @@ FnItem_ptr Parser::parse_fn_item() {
         if (lexer.peek_token().type == Token_type::COMMA)
             lexer.consume_expect_token(Token_type::COMMA); // 消费掉逗号
         else if (lexer.peek_token().type != Token_type::RIGHT_PARENTHESIS) {
-            throw string("PE, expected , or ) after self but got ") + lexer.peek_token().value;
+            throw string("PE, expected , or ) after self but got ") + lexer.peek_token().str();
         }
     } else if (lexer.peek_token().type == Token_type::AMPERSAND) {
         lexer.consume_expect_token(Token_type::AMPERSAND); // 消费掉 &
@@ -60,7 +168,7 @@ FnItem_ptr Parser::parse_fn_item() {
         if (lexer.peek_token().type == Token_type::COMMA)
             lexer.consume_expect_token(Token_type::COMMA); // 消费掉逗号
         else if (lexer.peek_token().type != Token_type::RIGHT_PARENTHESIS) {
-            throw string("PE, expected , or ) after self but got ") + lexer.peek_token().value;
+            throw string("PE, expected , or ) after self but got ") + lexer.peek_token().str();
         }
     }
     vector<pair<Pattern_ptr, Type_ptr>> parameters;
@@ -82,7 +190,7 @@ FnItem_ptr Parser::parse_fn_item() {
         return_type = parse_type();
     }
     BlockExpr_ptr body = parse_block_expression();
-    return std::make_shared<FnItem>(function_name, receiver_type,
+    return make<FnItem>(function_name, receiver_type,
         std::move(parameters), std::move(return_type), std::move(body));
 }
 
@@ -90,11 +198,11 @@ StructItem_ptr Parser::parse_struct_item() {
     // example :
     // struct StructName { field1: Type1, field2: Type2, ... }
     lexer.consume_expect_token(Token_type::STRUCT);
-    string struct_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+    string struct_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
     lexer.consume_expect_token(Token_type::LEFT_BRACE);
     vector<pair<string, Type_ptr>> fields;
     while(lexer.peek_token().type != Token_type::RIGHT_BRACE) {
-        string field_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+        string field_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
         lexer.consume_expect_token(Token_type::COLON);
         Type_ptr field_type = parse_type();
         fields.emplace_back(field_name, std::move(field_type));
@@ -105,17 +213,17 @@ StructItem_ptr Parser::parse_struct_item() {
         }
     }
     lexer.consume_expect_token(Token_type::RIGHT_BRACE);
-    return std::make_shared<StructItem>(struct_name, std::move(fields));
+    return make<StructItem>(struct_name, std::move(fields));
 }
 EnumItem_ptr Parser::parse_enum_item() {
     // example :
     // enum EnumName { Variant1, Variant2, ... }
     lexer.consume_expect_token(Token_type::ENUM);
-    string enum_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+    string enum_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
     lexer.consume_expect_token(Token_type::LEFT_BRACE);
     vector<string> variants;
     while(lexer.peek_token().type != Token_type::RIGHT_BRACE) {
-        string variant_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+        string variant_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
         variants.push_back(variant_name);
         if (lexer.peek_token().type == Token_type::COMMA) {
             lexer.consume_token(); // 消费掉逗号
@@ -124,13 +232,13 @@ EnumItem_ptr Parser::parse_enum_item() {
         }
     }
     lexer.consume_expect_token(Token_type::RIGHT_BRACE);
-    return std::make_shared<EnumItem>(enum_name, std::move(variants));
+    return make<EnumItem>(enum_name, std::move(variants));
 }
 ImplItem_ptr Parser::parse_impl_item() {
     // example :
     // impl StructName { fn method1(...) { ... } fn method2(...) { ... } ... }
     lexer.consume_expect_token(Token_type::IMPL);
-    string struct_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+    string struct_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
     lexer.consume_expect_token(Token_type::LEFT_BRACE);
     vector<Item_ptr> methods;
     while(lexer.peek_token().type != Token_type::RIGHT_BRACE) {
@@ -138,20 +246,20 @@ ImplItem_ptr Parser::parse_impl_item() {
         methods.push_back(parse_fn_item());
     }
     lexer.consume_expect_token(Token_type::RIGHT_BRACE);
-    return std::make_shared<ImplItem>(struct_name, std::move(methods));
+    return make<ImplItem>(struct_name, std::move(methods));
 }
 
 ConstItem_ptr Parser::parse_const_item() {
     // example :
     // const CONST_NAME: Type = value;
     lexer.consume_expect_token(Token_type::CONST);
-    string const_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+    string const_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
     lexer.consume_expect_token(Token_type::COLON);
     Type_ptr const_type = parse_type();
     lexer.consume_expect_token(Token_type::EQUAL);
     Expr_ptr value = parse_expression();
     lexer.consume_expect_token(Token_type::SEMICOLON);
-    return std::make_shared<ConstItem>(const_name, std::move(const_type), std::move(value));
+    return make<ConstItem>(const_name, std::move(const_type), std::move(value));
 }
 
 Pattern_ptr Parser::parse_pattern() {
@@ -167,8 +275,8 @@ Pattern_ptr Parser::parse_pattern() {
         lexer.consume_expect_token(Token_type::MUT);
         mut_type = Mutibility::MUTABLE;
     }
-    string identifier_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
-    return std::make_shared<IdentifierPattern>(identifier_name, mut_type, ref_type);
+    string identifier_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
+    return make<IdentifierPattern>(identifier_name, mut_type, ref_type);
 }
 
 LetStmt_ptr Parser::parse_let_statement() {
@@ -185,7 +293,7 @@ LetStmt_ptr Parser::parse_let_statement() {
         initializer = parse_expression();
     }
     lexer.consume_expect_token(Token_type::SEMICOLON);
-    return std::make_shared<LetStmt>(std::move(pattern), std::move(type), std::move(initializer));
+    return make<LetStmt>(std::move(pattern), std::move(type), std::move(initializer));
 }
 ExprStmt_ptr Parser::parse_expr_statement() {
     // example :
@@ -196,13 +304,13 @@ ExprStmt_ptr Parser::parse_expr_statement() {
         lexer.consume_expect_token(Token_type::SEMICOLON);
         is_semi = true;
     }
-    return std::make_shared<ExprStmt>(std::move(expr), is_semi);
+    return make<ExprStmt>(std::move(expr), is_semi);
 }
 ItemStmt_ptr Parser::parse_item_statement() {
     // example :
     // item
     Item_ptr item = parse_item();
-    return std::make_shared<ItemStmt>(std::move(item));
+    return make<ItemStmt>(std::move(item));
 }
 
 Stmt_ptr Parser::parse_statement() {
@@ -212,7 +320,7 @@ Stmt_ptr Parser::parse_statement() {
     // block 同上，所以如果是 { 开头，那么也是作为语句，可以不以分号结尾
     // 如果是进入了 parse_expr_statement，那么 if 后面可以做运算（也可以没有分号，这个时候是尾随表达式）
     // 所以 statement 里面要先把 if while loop 解析掉
-    Token token = lexer.peek_token();
+    const Token &token = lexer.peek_token();
     if (token.type == Token_type::LET) {
         return parse_let_statement();
     } else if (token.type == Token_type::FN ||
@@ -236,7 +344,7 @@ Stmt_ptr Parser::parse_statement() {
             lexer.consume_expect_token(Token_type::SEMICOLON);
             is_semi = true;
         }
-        return std::make_shared<ExprStmt>(std::move(expr), is_semi);
+        return make<ExprStmt>(std::move(expr), is_semi);
     } else {
         return parse_expr_statement();
     }
@@ -261,7 +369,7 @@ BlockExpr_ptr Parser::parse_block_expression() {
         bool has_semi = true;
         Stmt_ptr stmt = parse_statement();
         Expr_ptr this_expr = nullptr;
-        if (auto expr_stmt = dynamic_cast<ExprStmt*>(stmt.get())) {
+        if (auto expr_stmt = dynamic_cast<ExprStmt*>(stmt)) {
             if (!expr_stmt->is_semi) { has_semi = false; }
             this_expr = expr_stmt->expr;
         }
@@ -270,14 +378,14 @@ BlockExpr_ptr Parser::parse_block_expression() {
                 // 如果是 if, loop，那么打上标记，返回值一定是 () 或者 NeverType
                 // 如果 While，不用管
                 // 否则 CE
-                if (auto if_expr = dynamic_cast<IfExpr*>(tail_expr.get())) {
+                if (auto if_expr = dynamic_cast<IfExpr*>(tail_expr)) {
                     if_expr->must_return_unit = true;
-                } else if (auto loop_expr = dynamic_cast<LoopExpr*>(tail_expr.get())) {
+                } else if (auto loop_expr = dynamic_cast<LoopExpr*>(tail_expr)) {
                     loop_expr->must_return_unit = true;
-                } else if ([[maybe_unused]]auto while_expr = dynamic_cast<WhileExpr*>(tail_expr.get())) {
+                } else if ([[maybe_unused]]auto while_expr = dynamic_cast<WhileExpr*>(tail_expr)) {
                     // do nothing
                     // while 一定返回 ()
-                } else if (auto block_expr = dynamic_cast<BlockExpr*>(tail_expr.get())) {
+                } else if (auto block_expr = dynamic_cast<BlockExpr*>(tail_expr)) {
                     block_expr->must_return_unit = true;
                 } else {
                     throw string("CE, unexpected statement after expression without semicolon");
@@ -295,10 +403,10 @@ BlockExpr_ptr Parser::parse_block_expression() {
             statements.push_back(std::move(tail_statement));
         }
         tail_statement = nullptr;
-        return std::make_shared<BlockExpr>(std::move(statements), nullptr);
+        return make<BlockExpr>(std::move(statements), nullptr);
     }
     else {
-        return std::make_shared<BlockExpr>(std::move(statements), std::move(tail_statement));
+        return make<BlockExpr>(std::move(statements), std::move(tail_statement));
     }
 }
 
@@ -319,7 +427,7 @@ IfExpr_ptr Parser::parse_if_expression() {
         if (lexer.peek_token().type == Token_type::IF) { else_branch = parse_if_expression(); }
         else  {else_branch = parse_block_expression(); }
     }
-    return std::make_shared<IfExpr>(std::move(condition), std::move(then_branch), std::move(else_branch));
+    return make<IfExpr>(std::move(condition), std::move(then_branch), std::move(else_branch));
 }
 WhileExpr_ptr Parser::parse_while_expression() {
     // example :
@@ -329,14 +437,14 @@ WhileExpr_ptr Parser::parse_while_expression() {
     Expr_ptr condition = parse_expression();
     lexer.consume_expect_token(Token_type::RIGHT_PARENTHESIS);
     Expr_ptr body = parse_block_expression();
-    return std::make_shared<WhileExpr>(std::move(condition), std::move(body));
+    return make<WhileExpr>(std::move(condition), std::move(body));
 }
 LoopExpr_ptr Parser::parse_loop_expression() {
     // example :
     // loop { body }
     lexer.consume_expect_token(Token_type::LOOP);
     Expr_ptr body = parse_block_expression();
-    return std::make_shared<LoopExpr>(std::move(body));
+    return make<LoopExpr>(std::move(body));
 }
 Type_ptr Parser::parse_type() {
     // example :
@@ -360,36 +468,155 @@ Type_ptr Parser::parse_type() {
         lexer.consume_expect_token(Token_type::SEMICOLON);
         Expr_ptr size_expr = parse_expression();
         lexer.consume_expect_token(Token_type::RIGHT_BRACKET);
-        return std::make_shared<ArrayType>(std::move(element_type), std::move(size_expr), ref_type);
+        return make<ArrayType>(std::move(element_type), std::move(size_expr), ref_type);
     }
     else if (lexer.peek_token().type == Token_type::LEFT_PARENTHESIS) {
         // ()
         lexer.consume_expect_token(Token_type::LEFT_PARENTHESIS);
         lexer.consume_expect_token(Token_type::RIGHT_PARENTHESIS);
-        return std::make_shared<UnitType>(ref_type);
+        return make<UnitType>(ref_type);
     }
     else if (lexer.peek_token().type == Token_type::BIG_SELF) {
         // Self
         lexer.consume_expect_token(Token_type::BIG_SELF);
-        return std::make_shared<SelfType>(ref_type);
+        return make<SelfType>(ref_type);
     } else {
         // identifier
-        string type_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
-        return std::make_shared<PathType>(type_name, ref_type);
+        string type_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
+        return make<PathType>(type_name, ref_type);
+    }
+}
+
+namespace {
+
+// 中缀运算符对应的 Binary_Operator，不是中缀运算符（后缀、括号等）返回 nullopt
+std::optional<Binary_Operator> infix_operator(Token_type type) {
+    switch (type) {
+        case Token_type::PLUS: return Binary_Operator::ADD;
+        case Token_type::MINUS: return Binary_Operator::SUB;
+        case Token_type::STAR: return Binary_Operator::MUL;
+        case Token_type::SLASH: return Binary_Operator::DIV;
+        case Token_type::PERCENT: return Binary_Operator::MOD;
+        case Token_type::AMPERSAND: return Binary_Operator::AND;
+        case Token_type::PIPE: return Binary_Operator::OR;
+        case Token_type::CARET: return Binary_Operator::XOR;
+        case Token_type::LEFT_SHIFT: return Binary_Operator::SHL;
+        case Token_type::RIGHT_SHIFT: return Binary_Operator::SHR;
+        case Token_type::EQUAL_EQUAL: return Binary_Operator::EQ;
+        case Token_type::NOT_EQUAL: return Binary_Operator::NEQ;
+        case Token_type::LESS: return Binary_Operator::LT;
+        case Token_type::LESS_EQUAL: return Binary_Operator::LEQ;
+        case Token_type::GREATER: return Binary_Operator::GT;
+        case Token_type::GREATER_EQUAL: return Binary_Operator::GEQ;
+        case Token_type::AMPERSAND_AMPERSAND: return Binary_Operator::AND_AND;
+        case Token_type::PIPE_PIPE: return Binary_Operator::OR_OR;
+        case Token_type::EQUAL: return Binary_Operator::ASSIGN;
+        case Token_type::PLUS_EQUAL: return Binary_Operator::ADD_ASSIGN;
+        case Token_type::MINUS_EQUAL: return Binary_Operator::SUB_ASSIGN;
+        case Token_type::STAR_EQUAL: return Binary_Operator::MUL_ASSIGN;
+        case Token_type::SLASH_EQUAL: return Binary_Operator::DIV_ASSIGN;
+        case Token_type::PERCENT_EQUAL: return Binary_Operator::MOD_ASSIGN;
+        case Token_type::CARET_EQUAL: return Binary_Operator::XOR_ASSIGN;
+        case Token_type::AMPERSAND_EQUAL: return Binary_Operator::AND_ASSIGN;
+        case Token_type::PIPE_EQUAL: return Binary_Operator::OR_ASSIGN;
+        case Token_type::LEFT_SHIFT_EQUAL: return Binary_Operator::SHL_ASSIGN;
+        case Token_type::RIGHT_SHIFT_EQUAL: return Binary_Operator::SHR_ASSIGN;
+        default: return std::nullopt;
     }
 }
 
-// 递归下降解析表达式，基于 Pratt 解析器
+// parse_expression 栈上还没有拿到右操作数的运算符
+struct PendingOperator {
+    enum class Kind { PREFIX, INFIX, PAREN } kind;
+    Unary_Operator unary_op = Unary_Operator::NEG;
+    Binary_Operator binary_op = Binary_Operator::ADD;
+    Expr_ptr left = nullptr; // INFIX 的左操作数
+    int rbp = 0;             // 右操作数按这个结合力解析，PAREN 相当于重新从 0 开始
+};
+
+} // namespace
+
+/*
+Pratt 解析表达式，用显式的栈代替 nud / led 之间的递归
+和递归的写法一一对应：
+- 前缀运算符（- ! & &mut *）和左括号压栈，相当于递归调用 parse_expression(nbp) / parse_expression()
+- 中缀运算符把左操作数一起压栈，相当于递归调用 parse_expression(rbp)
+- 栈顶的 rbp 不小于下一个 token 的 lbp 时，栈顶的右操作数就解析完了，出栈建节点
+建节点的顺序和递归的写法完全相同，所以得到的 AST 和 NodeId 也相同
+很长的 a + b + ... 和很深的括号都不会让 C++ 的调用栈变深
+后缀运算（调用、字段、下标、as）和其余的原子表达式仍然交给 led / nud
+*/
 Expr_ptr Parser::parse_expression(int rbp) {
-    Token token = lexer.peek_token();
-    Expr_ptr left = nud(token);
-    while (lexer.has_more_tokens() && rbp < get_lbp(lexer.peek_token().type)) {
-        token = lexer.consume_token();
-        left = led(token, std::move(left));
+    vector<PendingOperator> pending;
+    while (true) {
+        // 前缀部分：一直压栈，直到解析出一个原子表达式
+        Expr_ptr left = nullptr;
+        while (left == nullptr) {
+            Token_type type = lexer.peek_token().type;
+            if (type == Token_type::MINUS) {
+                lexer.consume_expect_token(Token_type::MINUS);
+                pending.push_back({PendingOperator::Kind::PREFIX, Unary_Operator::NEG});
+                pending.back().rbp = get_nbp(Token_type::MINUS);
+            } else if (type == Token_type::BANG) {
+                lexer.consume_expect_token(Token_type::BANG);
+                pending.push_back({PendingOperator::Kind::PREFIX, Unary_Operator::NOT});
+                pending.back().rbp = get_nbp(Token_type::BANG);
+            } else if (type == Token_type::AMPERSAND) {
+                lexer.consume_expect_token(Token_type::AMPERSAND);
+                Unary_Operator op = Unary_Operator::REF;
+                if (lexer.peek_token().type == Token_type::MUT) {
+                    lexer.consume_expect_token(Token_type::MUT);
+                    op = Unary_Operator::REF_MUT;
+                }
+                pending.push_back({PendingOperator::Kind::PREFIX, op});
+                pending.back().rbp = get_nbp(Token_type::AMPERSAND);
+            } else if (type == Token_type::STAR) {
+                lexer.consume_expect_token(Token_type::STAR);
+                pending.push_back({PendingOperator::Kind::PREFIX, Unary_Operator::DEREF});
+                pending.back().rbp = get_nbp(Token_type::STAR);
+            } else if (type == Token_type::LEFT_PARENTHESIS) {
+                lexer.consume_expect_token(Token_type::LEFT_PARENTHESIS);
+                if (lexer.peek_token().type == Token_type::RIGHT_PARENTHESIS) {
+                    // ()
+                    lexer.consume_expect_token(Token_type::RIGHT_PARENTHESIS);
+                    left = make<UnitExpr>();
+                } else {
+                    // (expr)，右括号在出栈的时候消费
+                    pending.push_back({PendingOperator::Kind::PAREN});
+                }
+            } else {
+                left = nud(lexer.peek_token());
+            }
+        }
+        // 中缀 / 后缀部分
+        while (true) {
+            int current_rbp = pending.empty() ? rbp : pending.back().rbp;
+            if (lexer.has_more_tokens() && current_rbp < get_lbp(lexer.peek_token().type)) {
+                Token token = lexer.consume_token();
+                if (std::optional<Binary_Operator> op = infix_operator(token.type)) {
+                    pending.push_back({PendingOperator::Kind::INFIX, Unary_Operator::NEG, *op, left, get_rbp(token.type)});
+                    break; // 接着解析右操作数
+                }
+                left = led(token, left);
+                continue;
+            }
+            if (pending.empty()) {
+                return left;
+            }
+            PendingOperator top = pending.back();
+            pending.pop_back();
+            if (top.kind == PendingOperator::Kind::PREFIX) {
+                left = make<UnaryExpr>(top.unary_op, left);
+            } else if (top.kind == PendingOperator::Kind::INFIX) {
+                left = make<BinaryExpr>(top.binary_op, top.left, left);
+            } else {
+                lexer.consume_expect_token(Token_type::RIGHT_PARENTHESIS);
+            }
+        }
     }
-    return left;
 }
 
+// 原子表达式，前缀运算符和括号在 parse_expression 里处理
 Expr_ptr Parser::nud(Token token) {
     if (token.type == Token_type::IF) {
         return parse_if_expression();
@@ -399,25 +626,13 @@ Expr_ptr Parser::nud(Token token) {
         return parse_loop_expression();
     } else if (token.type == Token_type::LEFT_BRACE) {
         return parse_block_expression();
-    } else if (token.type == Token_type::LEFT_PARENTHESIS) {
-        lexer.consume_expect_token(Token_type::LEFT_PARENTHESIS);
-        if (lexer.peek_token().type == Token_type::RIGHT_PARENTHESIS) {
-            // ()
-            lexer.consume_expect_token(Token_type::RIGHT_PARENTHESIS);
-            return std::make_shared<UnitExpr>();
-        } else {
-            // (expr)
-            Expr_ptr expr = parse_expression();
-            lexer.consume_expect_token(Token_type::RIGHT_PARENTHESIS);
-            return expr;
-        }
     } else if (token.type == Token_type::LEFT_BRACKET) {
         // [expr1, expr2, ...] or [expr; n]
         lexer.consume_expect_token(Token_type::LEFT_BRACKET);
         if (lexer.peek_token().type == Token_type::RIGHT_BRACKET) {
             // []
             lexer.consume_expect_token(Token_type::RIGHT_BRACKET);
-            return std::make_shared<ArrayExpr>(std::vector<Expr_ptr>{});
+            return make<ArrayExpr>(std::vector<Expr_ptr>{});
         }
         Expr_ptr first_expr = parse_expression();
         if (lexer.peek_token().type == Token_type::SEMICOLON) {
@@ -425,7 +640,7 @@ Expr_ptr Parser::nud(Token token) {
             lexer.consume_expect_token(Token_type::SEMICOLON);
             Expr_ptr size_expr = parse_expression();
             lexer.consume_expect_token(Token_type::RIGHT_BRACKET);
-            return std::make_shared<RepeatArrayExpr>(std::move(first_expr), std::move(size_expr));
+            return make<RepeatArrayExpr>(std::move(first_expr), std::move(size_expr));
         } else {
             // normal array [expr1, expr2, ...(,)]
             std::vector<Expr_ptr> elements; elements.push_back(std::move(first_expr));
@@ -437,7 +652,7 @@ Expr_ptr Parser::nud(Token token) {
                 elements.push_back(parse_expression());
             }
             lexer.consume_expect_token(Token_type::RIGHT_BRACKET);
-            return std::make_shared<ArrayExpr>(std::move(elements));
+            return make<ArrayExpr>(std::move(elements));
         }
     } else if (token.type == Token_type::IDENTIFIER) {
         lexer.consume_expect_token(Token_type::IDENTIFIER);
@@ -448,17 +663,17 @@ Expr_ptr Parser::nud(Token token) {
         if (lexer.peek_token().type == Token_type::COLON_COLON) {
             // 路径表达式
             lexer.consume_expect_token(Token_type::COLON_COLON);
-            string path_segment = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
-            PathType_ptr base_type = std::make_shared<PathType>(token.value, ReferenceType::NO_REF);
-            return std::make_shared<PathExpr>(std::move(base_type), path_segment);
+            string path_segment = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
+            PathType_ptr base_type = make<PathType>(token.str(), ReferenceType::NO_REF);
+            return make<PathExpr>(std::move(base_type), path_segment);
         } else if (lexer.peek_token().type == Token_type::LEFT_BRACE) {
             // struct 初始化
             // example: StructName { field1: value1, field2: value2, ... }
-            string struct_name = token.value;
+            string struct_name = token.str();
             lexer.consume_expect_token(Token_type::LEFT_BRACE);
             vector<pair<string, Expr_ptr>> fields;
             while(lexer.peek_token().type != Token_type::RIGHT_BRACE) {
-                string field_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+                string field_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
                 lexer.consume_expect_token(Token_type::COLON);
                 Expr_ptr field_value = parse_expression();
                 fields.emplace_back(field_name, std::move(field_value));
@@ -469,10 +684,10 @@ Expr_ptr Parser::nud(Token token) {
                 }
             }
             lexer.consume_expect_token(Token_type::RIGHT_BRACE);
-            PathType_ptr struct_type = std::make_shared<PathType>(struct_name, ReferenceType::NO_REF);
-            return std::make_shared<StructExpr>(std::move(struct_type), std::move(fields));
+            PathType_ptr struct_type = make<PathType>(struct_name, ReferenceType::NO_REF);
+            return make<StructExpr>(std::move(struct_type), std::move(fields));
         } else {
-            return std::make_shared<IdentifierExpr>(token.value);
+            return make<IdentifierExpr>(token.str());
         }
     } else if (token.type == Token_type::BIG_SELF) {
         // Self 出现在表达式里面一定得是 Self:: 或者 Self {}
@@ -480,14 +695,14 @@ Expr_ptr Parser::nud(Token token) {
         if (lexer.peek_token().type == Token_type::COLON_COLON) {
             // 路径表达式
             lexer.consume_expect_token(Token_type::COLON_COLON);
-            string path_segment = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
-            SelfType_ptr base_type = std::make_shared<SelfType>(ReferenceType::NO_REF);
-            return std::make_shared<PathExpr>(std::move(base_type), path_segment);
+            string path_segment = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
+            SelfType_ptr base_type = make<SelfType>(ReferenceType::NO_REF);
+            return make<PathExpr>(std::move(base_type), path_segment);
         } else if (lexer.peek_token().type == Token_type::LEFT_BRACE) {
             lexer.consume_expect_token(Token_type::LEFT_BRACE);
             vector<pair<string, Expr_ptr>> fields;
             while(lexer.peek_token().type != Token_type::RIGHT_BRACE) {
-                string field_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
+                string field_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
                 lexer.consume_expect_token(Token_type::COLON);
                 Expr_ptr field_value = parse_expression();
                 fields.emplace_back(field_name, std::move(field_value));
@@ -498,164 +713,55 @@ Expr_ptr Parser::nud(Token token) {
                 }
             }
             lexer.consume_expect_token(Token_type::RIGHT_BRACE);
-            SelfType_ptr struct_type = std::make_shared<SelfType>(ReferenceType::NO_REF);
-            return std::make_shared<StructExpr>(std::move(struct_type), std::move(fields));
+            SelfType_ptr struct_type = make<SelfType>(ReferenceType::NO_REF);
+            return make<StructExpr>(std::move(struct_type), std::move(fields));
         } else {
-            throw string("CE in parser nud !!! unexpected token after Self: ") + lexer.peek_token().value;
+            throw string("CE in parser nud !!! unexpected token after Self: ") + lexer.peek_token().str();
         }
     } else if (token.type == Token_type::SELF) {
         lexer.consume_expect_token(Token_type::SELF);
-        return std::make_shared<SelfExpr>();
+        return make<SelfExpr>();
     } else if (token.type == Token_type::NUMBER) {
         lexer.consume_expect_token(Token_type::NUMBER);
-        return std::make_shared<LiteralExpr>(LiteralType::NUMBER, token.value);
+        return make<LiteralExpr>(LiteralType::NUMBER, token.str(), token.number);
     } else if (token.type == Token_type::TRUE || 
                token.type == Token_type::FALSE) {
         lexer.consume_token();
-        return std::make_shared<LiteralExpr>(LiteralType::BOOL, token.value);
+        return make<LiteralExpr>(LiteralType::BOOL, token.str());
     } else if (token.type == Token_type::STRING) {
         lexer.consume_expect_token(Token_type::STRING);
-        return std::make_shared<LiteralExpr>(LiteralType::STRING, token.value);
+        return make<LiteralExpr>(LiteralType::STRING, token.str());
     } else if (token.type == Token_type::CHAR) {
         lexer.consume_expect_token(Token_type::CHAR);
-        return std::make_shared<LiteralExpr>(LiteralType::CHAR, token.value);
-    } else if (token.type == Token_type::MINUS) {
-        lexer.consume_expect_token(Token_type::MINUS);
-        Expr_ptr right = parse_expression(get_nbp(Token_type::MINUS));
-        return std::make_shared<UnaryExpr>(Unary_Operator::NEG, std::move(right));
-    } else if (token.type == Token_type::BANG) {
-        lexer.consume_expect_token(Token_type::BANG);
-        Expr_ptr right = parse_expression(get_nbp(Token_type::BANG));
-        return std::make_shared<UnaryExpr>(Unary_Operator::NOT, std::move(right));
-    } else if (token.type == Token_type::AMPERSAND) {
-        lexer.consume_expect_token(Token_type::AMPERSAND);
-        if (lexer.peek_token().type == Token_type::MUT) {
-            lexer.consume_expect_token(Token_type::MUT);
-            Expr_ptr right = parse_expression(get_nbp(Token_type::AMPERSAND));
-            return std::make_shared<UnaryExpr>(Unary_Operator::REF_MUT, std::move(right));
-        } else {
-            Expr_ptr right = parse_expression(get_nbp(Token_type::AMPERSAND));
-            return std::make_shared<UnaryExpr>(Unary_Operator::REF, std::move(right));
-        }
-    } else if (token.type == Token_type::STAR) {
-        lexer.consume_expect_token(Token_type::STAR);
-        Expr_ptr right = parse_expression(get_nbp(Token_type::STAR));
-        return std::make_shared<UnaryExpr>(Unary_Operator::DEREF, std::move(right));
+        return make<LiteralExpr>(LiteralType::CHAR, token.str());
     } else if (token.type == Token_type::BREAK) {
         lexer.consume_expect_token(Token_type::BREAK);
         if (lexer.peek_token().type != Token_type::SEMICOLON &&
             lexer.peek_token().type != Token_type::RIGHT_BRACE) {
             // break 后面可以有表达式
             Expr_ptr expr = parse_expression();
-            return std::make_shared<BreakExpr>(std::move(expr));
+            return make<BreakExpr>(std::move(expr));
         }
-        return std::make_shared<BreakExpr>();
+        return make<BreakExpr>();
     } else if (token.type == Token_type::RETURN) {
         lexer.consume_expect_token(Token_type::RETURN);
         if (lexer.peek_token().type != Token_type::SEMICOLON &&
             lexer.peek_token().type != Token_type::RIGHT_BRACE) {
             // return 后面可以有表达式
             Expr_ptr expr = parse_expression();
-            return std::make_shared<ReturnExpr>(std::move(expr));
+            return make<ReturnExpr>(std::move(expr));
         }
-        return std::make_shared<ReturnExpr>();
+        return make<ReturnExpr>();
     } else if (token.type == Token_type::CONTINUE) {
         lexer.consume_expect_token(Token_type::CONTINUE);
-        return std::make_shared<ContinueExpr>();
+        return make<ContinueExpr>();
     } else {
-        throw string("CE in parser nud !!! unexpected token in expression: ") + token.value;
+        throw string("CE in parser nud !!! unexpected token in expression: ") + token.str();
     }
 }
-// 处理中缀表达式
+// 处理后缀表达式，中缀运算符在 parse_expression 里处理
 Expr_ptr Parser::led(Token token, Expr_ptr left) {
-    if (token.type == Token_type::PLUS) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::PLUS));
-        return std::make_shared<BinaryExpr>(Binary_Operator::ADD, std::move(left), std::move(right));
-    } else if (token.type == Token_type::MINUS) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::MINUS));
-        return std::make_shared<BinaryExpr>(Binary_Operator::SUB, std::move(left), std::move(right));
-    } else if (token.type == Token_type::STAR) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::STAR));
-        return std::make_shared<BinaryExpr>(Binary_Operator::MUL, std::move(left), std::move(right));
-    } else if (token.type == Token_type::SLASH) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::SLASH));
-        return std::make_shared<BinaryExpr>(Binary_Operator::DIV, std::move(left), std::move(right));
-    } else if (token.type == Token_type::PERCENT) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::PERCENT));
-        return std::make_shared<BinaryExpr>(Binary_Operator::MOD, std::move(left), std::move(right));
-    } else if (token.type == Token_type::AMPERSAND) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::AMPERSAND));
-        return std::make_shared<BinaryExpr>(Binary_Operator::AND, std::move(left), std::move(right));
-    } else if (token.type == Token_type::PIPE) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::PIPE));
-        return std::make_shared<BinaryExpr>(Binary_Operator::OR, std::move(left), std::move(right));
-    } else if (token.type == Token_type::CARET) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::CARET));
-        return std::make_shared<BinaryExpr>(Binary_Operator::XOR, std::move(left), std::move(right));
-    } else if (token.type == Token_type::LEFT_SHIFT) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::LEFT_SHIFT));
-        return std::make_shared<BinaryExpr>(Binary_Operator::SHL, std::move(left), std::move(right));
-    } else if (token.type == Token_type::RIGHT_SHIFT) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::RIGHT_SHIFT));
-        return std::make_shared<BinaryExpr>(Binary_Operator::SHR, std::move(left), std::move(right));
-    } else if (token.type == Token_type::EQUAL_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::EQUAL_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::EQ, std::move(left), std::move(right));
-    } else if (token.type == Token_type::NOT_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::NOT_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::NEQ, std::move(left), std::move(right));
-    } else if (token.type == Token_type::LESS) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::LESS));
-        return std::make_shared<BinaryExpr>(Binary_Operator::LT, std::move(left), std::move(right));
-    } else if (token.type == Token_type::LESS_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::LESS_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::LEQ, std::move(left), std::move(right));
-    } else if (token.type == Token_type::GREATER) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::GREATER));
-        return std::make_shared<BinaryExpr>(Binary_Operator::GT, std::move(left), std::move(right));
-    } else if (token.type == Token_type::GREATER_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::GREATER_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::GEQ, std::move(left), std::move(right));
-    } else if (token.type == Token_type::AMPERSAND_AMPERSAND) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::AMPERSAND_AMPERSAND));
-        return std::make_shared<BinaryExpr>(Binary_Operator::AND_AND, std::move(left), std::move(right));
-    } else if (token.type == Token_type::PIPE_PIPE) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::PIPE_PIPE));
-        return std::make_shared<BinaryExpr>(Binary_Operator::OR_OR, std::move(left), std::move(right));
-    } else if (token.type == Token_type::EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::PLUS_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::PLUS_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::ADD_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::MINUS_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::MINUS_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::SUB_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::STAR_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::STAR_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::MUL_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::SLASH_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::SLASH_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::DIV_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::PERCENT_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::PERCENT_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::MOD_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::CARET_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::CARET_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::XOR_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::AMPERSAND_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::AMPERSAND_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::AND_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::PIPE_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::PIPE_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::OR_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::LEFT_SHIFT_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::LEFT_SHIFT_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::SHL_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::RIGHT_SHIFT_EQUAL) {
-        Expr_ptr right = parse_expression(get_rbp(Token_type::RIGHT_SHIFT_EQUAL));
-        return std::make_shared<BinaryExpr>(Binary_Operator::SHR_ASSIGN, std::move(left), std::move(right));
-    } else if (token.type == Token_type::LEFT_PARENTHESIS) {
+    if (token.type == Token_type::LEFT_PARENTHESIS) {
         // 函数调用
         vector<Expr_ptr> arguments;
         while (lexer.peek_token().type != Token_type::RIGHT_PARENTHESIS) {
@@ -668,22 +774,22 @@ Expr_ptr Parser::led(Token token, Expr_ptr left) {
             }
         }
         lexer.consume_expect_token(Token_type::RIGHT_PARENTHESIS);
-        return std::make_shared<CallExpr>(std::move(left), std::move(arguments));
+        return make<CallExpr>(std::move(left), std::move(arguments));
     } else if (token.type == Token_type::DOT) {
         // 字段访问
-        string field_name = lexer.consume_expect_token(Token_type::IDENTIFIER).value;
-        return std::make_shared<FieldExpr>(std::move(left), field_name);
+        string field_name = lexer.consume_expect_token(Token_type::IDENTIFIER).str();
+        return make<FieldExpr>(std::move(left), field_name);
     } else if (token.type == Token_type::LEFT_BRACKET) {
         // 数组下标访问
         Expr_ptr index = parse_expression();
         lexer.consume_expect_token(Token_type::RIGHT_BRACKET);
-        return std::make_shared<IndexExpr>(std::move(left), std::move(index));
+        return make<IndexExpr>(std::move(left), std::move(index));
     } else if (token.type == Token_type::AS) {
         // 类型转换
         Type_ptr target_type = parse_type();
-        return std::make_shared<CastExpr>(std::move(left), std::move(target_type));
+        return make<CastExpr>(std::move(left), std::move(target_type));
     } else {
-        throw string("CE in parser led !!! unexpected token in expression: ") + token.value;
+        throw string("CE in parser led !!! unexpected token in expression: ") + token.str();
     }
 }
 
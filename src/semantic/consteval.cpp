@@ -3,6 +3,7 @@
 #include "semantic/scope.h"
 #include "semantic/type.h"
 #include "tools/tools.h"
+#include <algorithm>
 
 string const_value_kind_to_string(ConstValueKind kind) {
     switch (kind) {
@@ -20,28 +21,29 @@ string const_value_kind_to_string(ConstValueKind kind) {
 }
 
 ConstValue_ptr ConstItemVisitor::parse_literal_token_to_const_value(LiteralType type, string value) {
+    IntegerLiteral number;
+    if (type == LiteralType::NUMBER) {
+        number = decode_integer_literal(value);
+    }
+    return parse_literal_token_to_const_value(type, value, number);
+}
+
+ConstValue_ptr ConstItemVisitor::parse_literal_token_to_const_value(LiteralType type, const string &value, const IntegerLiteral &number) {
     if (type == LiteralType::NUMBER) {
         // ...i32, ...u32, ...isize, ...usize, ...
-        if (value.size() >= 3 && value.substr(value.size() - 3) == "i32") {
-            // i32
-            int int_value = static_cast<int>(safe_stoll(value));
-            return std::make_shared<I32_ConstValue>(int_value);
-        } else if (value.size() >= 3 && value.substr(value.size() - 3) == "u32") {
-            // u32
-            unsigned int uint_value = static_cast<unsigned int>(safe_stoll(value));
-            return std::make_shared<U32_ConstValue>(uint_value);
-        } else if (value.size() >= 5 && value.substr(value.size() - 5) == "isize") {
-            // isize
-            int isize_value = static_cast<int>(safe_stoll(value));
-            return std::make_shared<Isize_ConstValue>(isize_value);
-        } else if (value.size() >= 5 && value.substr(value.size() - 5) == "usize") {
-            // usize
-            unsigned int usize_value = static_cast<unsigned int>(safe_stoll(value));
-            return std::make_shared<Usize_ConstValue>(usize_value);
-        } else {
-            // anyint
-            long long anyint_value = safe_stoll(value);
-            return std::make_shared<AnyInt_ConstValue>(anyint_value);
+        long long number_value = integer_literal_value(number, value);
+        switch (number.suffix) {
+            case IntegerSuffix::I32:
+                return std::make_shared<I32_ConstValue>(static_cast<int>(number_value));
+            case IntegerSuffix::U32:
+                return std::make_shared<U32_ConstValue>(static_cast<unsigned int>(number_value));
+            case IntegerSuffix::ISIZE:
+                return std::make_shared<Isize_ConstValue>(static_cast<int>(number_value));
+            case IntegerSuffix::USIZE:
+                return std::make_shared<Usize_ConstValue>(static_cast<unsigned int>(number_value));
+            default:
+                // anyint
+                return std::make_shared<AnyInt_ConstValue>(number_value);
         }
     } else if (type == LiteralType::BOOL) {
         if (value == "true") {
@@ -475,21 +477,18 @@ size_t ConstItemVisitor::calc_const_array_size(ConstValue_ptr size_value) {
 
 void ConstItemVisitor::visit(LiteralExpr &node) {
     if (is_need_to_calculate) {
-        const_value = parse_literal_token_to_const_value(node.literal_type, node.value);
+        const_value = parse_literal_token_to_const_value(node.literal_type, node.value, node.number);
         is_need_to_calculate = false;
     }
     AST_Walker::visit(node);
 }
 void ConstItemVisitor::visit(IdentifierExpr &node) {
     if (is_need_to_calculate) {
-        auto const_decl = find_const_decl(node_scope_map[node.NodeId], node.name);
+        auto const_decl = bound_const(node);
         if (const_decl == nullptr) {
             throw string("CE, undefined constant: ") + node.name;
         }
-        if (const_value_map.find(const_decl) == const_value_map.end()) {
-            throw string("CE, constant not evaluated yet: ") + node.name;
-        }
-        const_value = const_value_map[const_decl];
+        const_value = evaluate_const(const_decl);
         is_need_to_calculate = false;
     }
     AST_Walker::visit(node);
@@ -501,12 +500,12 @@ void ConstItemVisitor::visit(BinaryExpr &node) {
         ConstValue_ptr right_value;
         // calc left
         is_need_to_calculate = true;
-        node.left->accept(*this);
+        dispatch(node.left);
         left_value = const_value;
         const_value = nullptr;
         // calc right
         is_need_to_calculate = true;
-        node.right->accept(*this);
+        dispatch(node.right);
         right_value = const_value;
         const_value = nullptr;
         // 计算结果
@@ -521,7 +520,7 @@ void ConstItemVisitor::visit(UnaryExpr &node) {
         ConstValue_ptr right_value;
         // calc right
         is_need_to_calculate = true;
-        node.right->accept(*this);
+        dispatch(node.right);
         right_value = const_value;
         const_value = nullptr;
         // 计算结果
@@ -551,11 +550,11 @@ void ConstItemVisitor::visit(StructExpr &node) {
 void ConstItemVisitor::visit(IndexExpr &node) { 
     if (is_need_to_calculate) {
         is_need_to_calculate = true;
-        node.base->accept(*this);
+        dispatch(node.base);
         ConstValue_ptr base_value = const_value;
         const_value = nullptr;
         is_need_to_calculate = true;
-        node.index->accept(*this);
+        dispatch(node.index);
         ConstValue_ptr index_value = const_value;
         const_value = nullptr;
         size_t index = calc_const_array_size(index_value);
@@ -620,7 +619,7 @@ void ConstItemVisitor::visit(CastExpr &node) {
         ConstValue_ptr value;
         // calc value
         is_need_to_calculate = true;
-        node.expr->accept(*this);
+        dispatch(node.expr);
         value = const_value;
         const_value = nullptr;
         // 计算结果
@@ -653,7 +652,7 @@ void ConstItemVisitor::visit(ArrayExpr &node) {
         vector<ConstValue_ptr> elem;
         for (auto expr : node.elements) {
             is_need_to_calculate = true;
-            expr->accept(*this);
+            dispatch(expr);
             elem.push_back(const_value);
             const_value = nullptr;
         }
@@ -665,11 +664,11 @@ void ConstItemVisitor::visit(ArrayExpr &node) {
 void ConstItemVisitor::visit(RepeatArrayExpr &node) {
     if (is_need_to_calculate) {
         is_need_to_calculate = true;
-        node.element->accept(*this);
+        dispatch(node.element);
         ConstValue_ptr element_value = const_value;
         const_value = nullptr;
         is_need_to_calculate = true;
-        node.size->accept(*this);
+        dispatch(node.size);
         ConstValue_ptr size_value = const_value;
         const_value = nullptr;
 
@@ -708,26 +707,62 @@ void ConstItemVisitor::visit(ConstItem &node) {
     if (is_need_to_calculate) {
         throw string("CE, const definition not allowed in constant expression");
     }
-    // 需要计算这个 const item 的值
-    // 先递归 type
-    // 如果是数组，就要把表达式也给算出来，并且存在 const_expr_to_size_map 里面
-    is_need_to_calculate = true;
-    node.const_type->accept(*this);
     auto const_decl = find_const_decl(node_scope_map[node.NodeId], node.const_name);
     // 找到定义
     if (const_decl == nullptr) {
         throw string("CE, undefined constant: ") + node.const_name;
     }
+    // 被别的 const 用到的时候可能已经求过了
+    evaluate_const(const_decl);
+}
+ConstDecl_ptr ConstItemVisitor::bound_const(IdentifierExpr &node) {
+    if (ConstDecl_ptr *bound = const_refs.get(node.NodeId)) {
+        return *bound;
+    }
+    Scope_ptr *scope = node_scope_map.get(node.NodeId);
+    ConstDecl_ptr const_decl = scope == nullptr ? nullptr : find_const_decl(*scope, node.name);
+    const_refs[node.NodeId] = const_decl;
+    return const_decl;
+}
+ConstValue_ptr ConstItemVisitor::evaluate_const(const ConstDecl_ptr &const_decl) {
+    auto it = const_value_map.find(const_decl);
+    if (it != const_value_map.end()) {
+        return it->second;
+    }
+    auto cycle_begin = std::find(evaluating.begin(), evaluating.end(), const_decl);
+    if (cycle_begin != evaluating.end()) {
+        string cycle;
+        for (auto k = cycle_begin; k != evaluating.end(); k++) {
+            cycle += (*k)->name + " -> ";
+        }
+        throw string("CE, cycle in constant definitions: ") + cycle + const_decl->name;
+    }
+    if (const_decl->ast_node == nullptr) {
+        throw string("Error, constant without definition: ") + const_decl->name;
+    }
+    ConstItem &node = *const_decl->ast_node;
+    // 可能是在求别的表达式的途中用到了这个 const，先把现场存起来
+    bool outer_need_to_calculate = is_need_to_calculate;
+    ConstValue_ptr outer_value = const_value;
+    evaluating.push_back(const_decl);
+    // 需要计算这个 const item 的值
+    // 先递归 type
+    // 如果是数组，就要把表达式也给算出来，并且存在 const_expr_to_size_map 里面
+    is_need_to_calculate = true;
+    dispatch(node.const_type);
     is_need_to_calculate = true;
-    node.value->accept(*this);
+    const_value = nullptr;
+    dispatch(node.value);
     if (const_value == nullptr) {
         // 这个情况不应该发生，发生了说明代码写错了没找到
         throw string("CE, failed to evaluate constant: ") + node.const_name;
     }
-    const_value = const_cast_to_realtype(const_value, type_map[node.const_type->NodeId]);
-    const_value_map[const_decl] = const_value;
-    const_value = nullptr;
-    is_need_to_calculate = false;
+    ConstValue_ptr value = const_cast_to_realtype(const_value, type_map[node.const_type->NodeId]);
+    const_value_map[const_decl] = value;
+    evaluating.pop_back();
+    is_need_to_calculate = outer_need_to_calculate;
+    const_value = outer_value;
+    return value;
 }
 void ConstItemVisitor::visit(LetStmt &node) {
     if (is_need_to_calculate) {
@@ -755,9 +790,9 @@ void ConstItemVisitor::visit(PathType &node) {
 }
 void ConstItemVisitor::visit(ArrayType &node) {
     if (is_need_to_calculate) {
-        node.element_type->accept(*this);
+        dispatch(node.element_type);
         is_need_to_calculate = true;
-        node.size_expr->accept(*this);
+        dispatch(node.size_expr);
         size_t array_size = calc_const_array_size(const_value);
         const_value = nullptr;
         is_need_to_calculate = false;
@@ -783,3 +818,178 @@ void ConstItemVisitor::visit(IdentifierPattern &node) {
     }
     AST_Walker::visit(node);
 }
+
+namespace {
+
+void hash_combine(size_t &h, size_t value) {
+    h ^= value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+}
+
+} // namespace
+
+ConstDecl_ptr ConstExprTable::resolve(IdentifierExpr &node) {
+    return evaluator.bound_const(node);
+}
+
+RealType_ptr ConstExprTable::scalar_target(CastExpr &node) {
+    RealType_ptr *target = type_map.get(node.target_type->NodeId);
+    if (target == nullptr || *target == nullptr) {
+        return nullptr;
+    }
+    switch ((*target)->kind) {
+        case RealTypeKind::BOOL:
+        case RealTypeKind::CHAR:
+        case RealTypeKind::UNIT:
+        case RealTypeKind::I32:
+        case RealTypeKind::U32:
+        case RealTypeKind::ISIZE:
+        case RealTypeKind::USIZE:
+        case RealTypeKind::ANYINT:
+            return *target;
+        default:
+            return nullptr;
+    }
+}
+
+bool ConstExprTable::hash(Expr_ptr expr, size_t &h) {
+    h = static_cast<size_t>(expr->kind);
+    switch (expr->kind) {
+        case NodeKind::LiteralExpr: {
+            auto &node = static_cast<LiteralExpr &>(*expr);
+            hash_combine(h, static_cast<size_t>(node.literal_type));
+            hash_combine(h, std::hash<string>()(node.value));
+            return true;
+        }
+        case NodeKind::IdentifierExpr: {
+            ConstDecl_ptr decl = resolve(static_cast<IdentifierExpr &>(*expr));
+            hash_combine(h, std::hash<ConstDecl *>()(decl.get()));
+            return decl != nullptr;
+        }
+        case NodeKind::BinaryExpr: {
+            auto &node = static_cast<BinaryExpr &>(*expr);
+            size_t left, right;
+            if (!hash(node.left, left) || !hash(node.right, right)) return false;
+            hash_combine(h, static_cast<size_t>(node.op));
+            hash_combine(h, left);
+            hash_combine(h, right);
+            return true;
+        }
+        case NodeKind::UnaryExpr: {
+            auto &node = static_cast<UnaryExpr &>(*expr);
+            size_t right;
+            if (!hash(node.right, right)) return false;
+            hash_combine(h, static_cast<size_t>(node.op));
+            hash_combine(h, right);
+            return true;
+        }
+        case NodeKind::IndexExpr: {
+            auto &node = static_cast<IndexExpr &>(*expr);
+            size_t base, index;
+            if (!hash(node.base, base) || !hash(node.index, index)) return false;
+            hash_combine(h, base);
+            hash_combine(h, index);
+            return true;
+        }
+        case NodeKind::CastExpr: {
+            auto &node = static_cast<CastExpr &>(*expr);
+            RealType_ptr target = scalar_target(node);
+            size_t operand;
+            if (target == nullptr || !hash(node.expr, operand)) return false;
+            hash_combine(h, static_cast<size_t>(target->kind));
+            hash_combine(h, static_cast<size_t>(target->is_ref));
+            hash_combine(h, operand);
+            return true;
+        }
+        case NodeKind::UnitExpr:
+            return true;
+        case NodeKind::ArrayExpr: {
+            auto &node = static_cast<ArrayExpr &>(*expr);
+            hash_combine(h, node.elements.size());
+            for (auto element : node.elements) {
+                size_t element_hash;
+                if (!hash(element, element_hash)) return false;
+                hash_combine(h, element_hash);
+            }
+            return true;
+        }
+        case NodeKind::RepeatArrayExpr: {
+            auto &node = static_cast<RepeatArrayExpr &>(*expr);
+            size_t element, size;
+            if (!hash(node.element, element) || !hash(node.size, size)) return false;
+            hash_combine(h, element);
+            hash_combine(h, size);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool ConstExprTable::equal(Expr_ptr a, Expr_ptr b) {
+    if (a->kind != b->kind) {
+        return false;
+    }
+    switch (a->kind) {
+        case NodeKind::LiteralExpr: {
+            auto &x = static_cast<LiteralExpr &>(*a);
+            auto &y = static_cast<LiteralExpr &>(*b);
+            return x.literal_type == y.literal_type && x.value == y.value;
+        }
+        case NodeKind::IdentifierExpr:
+            return resolve(static_cast<IdentifierExpr &>(*a)) == resolve(static_cast<IdentifierExpr &>(*b));
+        case NodeKind::BinaryExpr: {
+            auto &x = static_cast<BinaryExpr &>(*a);
+            auto &y = static_cast<BinaryExpr &>(*b);
+            return x.op == y.op && equal(x.left, y.left) && equal(x.right, y.right);
+        }
+        case NodeKind::UnaryExpr: {
+            auto &x = static_cast<UnaryExpr &>(*a);
+            auto &y = static_cast<UnaryExpr &>(*b);
+            return x.op == y.op && equal(x.right, y.right);
+        }
+        case NodeKind::IndexExpr: {
+            auto &x = static_cast<IndexExpr &>(*a);
+            auto &y = static_cast<IndexExpr &>(*b);
+            return equal(x.base, y.base) && equal(x.index, y.index);
+        }
+        case NodeKind::CastExpr: {
+            auto &x = static_cast<CastExpr &>(*a);
+            auto &y = static_cast<CastExpr &>(*b);
+            RealType_ptr x_target = scalar_target(x);
+            RealType_ptr y_target = scalar_target(y);
+            return x_target != nullptr && y_target != nullptr && x_target->kind == y_target->kind &&
+                   x_target->is_ref == y_target->is_ref && equal(x.expr, y.expr);
+        }
+        case NodeKind::UnitExpr:
+            return true;
+        case NodeKind::ArrayExpr: {
+            auto &x = static_cast<ArrayExpr &>(*a);
+            auto &y = static_cast<ArrayExpr &>(*b);
+            if (x.elements.size() != y.elements.size()) return false;
+            for (size_t k = 0; k < x.elements.size(); k++) {
+                if (!equal(x.elements[k], y.elements[k])) return false;
+            }
+            return true;
+        }
+        case NodeKind::RepeatArrayExpr: {
+            auto &x = static_cast<RepeatArrayExpr &>(*a);
+            auto &y = static_cast<RepeatArrayExpr &>(*b);
+            return equal(x.element, y.element) && equal(x.size, y.size);
+        }
+        default:
+            return false;
+    }
+}
+
+const size_t *ConstExprTable::find(Expr_ptr expr, size_t h) {
+    auto it = buckets.find(h);
+    if (it == buckets.end()) {
+        return nullptr;
+    }
+    for (const auto &[representative, size] : it->second) {
+        if (equal(representative, expr)) {
+            return &size;
+        }
+    }
+    return nullptr;
+}
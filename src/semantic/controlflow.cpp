@@ -71,56 +71,47 @@ OutcomeState loop_outcome_state(const OutcomeState &body) {
     }
 }
 
-void ControlFlowVisitor::visit(LiteralExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(LiteralExpr &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
 
-void ControlFlowVisitor::visit(IdentifierExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(IdentifierExpr &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
 
-void ControlFlowVisitor::visit(BinaryExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(BinaryExpr &node) {
     node_outcome_state_map[node.NodeId] = sequence_outcome_state(
         node_outcome_state_map[node.left->NodeId],
         node_outcome_state_map[node.right->NodeId]
     );
 }
-void ControlFlowVisitor::visit(UnaryExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(UnaryExpr &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(CallExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(CallExpr &node) {
     OutcomeState state = get_outcome_state({OutcomeType::NEXT});
     for (auto arg : node.arguments) {
         state = sequence_outcome_state(state, node_outcome_state_map[arg->NodeId]);
     }
     node_outcome_state_map[node.NodeId] = state;
 }
-void ControlFlowVisitor::visit(FieldExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(FieldExpr &node) {
     node_outcome_state_map[node.NodeId] = node_outcome_state_map[node.base->NodeId];
 }
-void ControlFlowVisitor::visit(StructExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(StructExpr &node) {
     OutcomeState state = get_outcome_state({OutcomeType::NEXT});
     for (auto &[type, expr] : node.fields) {
         state = sequence_outcome_state(state, node_outcome_state_map[expr->NodeId]);
     }
     node_outcome_state_map[node.NodeId] = state;
 }
-void ControlFlowVisitor::visit(IndexExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(IndexExpr &node) {
     node_outcome_state_map[node.NodeId] = sequence_outcome_state(
         node_outcome_state_map[node.base->NodeId],
         node_outcome_state_map[node.index->NodeId]
     );
 }
-void ControlFlowVisitor::visit(BlockExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(BlockExpr &node) {
     OutcomeState state = get_outcome_state({OutcomeType::NEXT});
     for (auto stmt : node.statements) {
         state = sequence_outcome_state(state, node_outcome_state_map[stmt->NodeId]);
@@ -130,8 +121,7 @@ void ControlFlowVisitor::visit(BlockExpr &node) {
     }
     node_outcome_state_map[node.NodeId] = state;
 }
-void ControlFlowVisitor::visit(IfExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(IfExpr &node) {
     OutcomeState state = ifelse_outcome_state(
         node_outcome_state_map[node.condition->NodeId],
         node_outcome_state_map[node.then_branch->NodeId],
@@ -139,9 +129,8 @@ void ControlFlowVisitor::visit(IfExpr &node) {
     );
     node_outcome_state_map[node.NodeId] = state;
 }
-void ControlFlowVisitor::visit(WhileExpr &node) {
-    loop_depth++;
-    AST_Walker::visit(node);
+void ControlFlowVisitor::enter([[maybe_unused]] WhileExpr &node) { loop_depth++; }
+void ControlFlowVisitor::leave(WhileExpr &node) {
     loop_depth--;
     OutcomeState state = while_outcome_state(
         node_outcome_state_map[node.condition->NodeId],
@@ -149,96 +138,87 @@ void ControlFlowVisitor::visit(WhileExpr &node) {
     );
     node_outcome_state_map[node.NodeId] = state;
 }
-void ControlFlowVisitor::visit(LoopExpr &node) {
-    loop_depth++;
-    AST_Walker::visit(node);
+void ControlFlowVisitor::enter([[maybe_unused]] LoopExpr &node) { loop_depth++; }
+void ControlFlowVisitor::leave(LoopExpr &node) {
     loop_depth--;
     OutcomeState state = loop_outcome_state(
         node_outcome_state_map[node.body->NodeId]
     );
     node_outcome_state_map[node.NodeId] = state;
 }
-void ControlFlowVisitor::visit(ReturnExpr &node) {
+void ControlFlowVisitor::leave(ReturnExpr &node) {
     // 需要检查是否在函数内 (?)
     // 其实（应该）不需要检查，因为在 const 里面会报错，其他地方的表达式一定是在函数内 (?)
     // 真的遇到怪情况了再说
-    AST_Walker::visit(node);
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::RETURN});
     // 有没有可能 return 里面嵌套了一些怪东西（嵌套 break 等等）？
     // 先不管
 }
-void ControlFlowVisitor::visit(BreakExpr &node) {
+void ControlFlowVisitor::enter([[maybe_unused]] BreakExpr &node) {
     if (loop_depth == 0) {
         throw string("CE, break statement not in loop");
     }
-    AST_Walker::visit(node);
+}
+void ControlFlowVisitor::leave(BreakExpr &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::BREAK});
     // 同上，break 里面套了怪东西也不管
 }
-void ControlFlowVisitor::visit(ContinueExpr &node) {
+void ControlFlowVisitor::enter([[maybe_unused]] ContinueExpr &node) {
     if (loop_depth == 0) {
         throw string("CE, continue statement not in loop");
     }
-    AST_Walker::visit(node);
+}
+void ControlFlowVisitor::leave(ContinueExpr &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::BREAK});
     // 同上，continue 里面套了怪东西也不管
 }
-void ControlFlowVisitor::visit(CastExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(CastExpr &node) {
     node_outcome_state_map[node.NodeId] = node_outcome_state_map[node.expr->NodeId];
 }
-void ControlFlowVisitor::visit(PathExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(PathExpr &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(SelfExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(SelfExpr &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(UnitExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(UnitExpr &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(ArrayExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(ArrayExpr &node) {
     OutcomeState state = get_outcome_state({OutcomeType::NEXT});
     for (auto expr : node.elements) {
         state = sequence_outcome_state(state, node_outcome_state_map[expr->NodeId]);
     }
     node_outcome_state_map[node.NodeId] = state;
 }
-void ControlFlowVisitor::visit(RepeatArrayExpr &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(RepeatArrayExpr &node) {
     node_outcome_state_map[node.NodeId] = node_outcome_state_map[node.element->NodeId];
 }
 
-void ControlFlowVisitor::visit(FnItem &node) {
-    // 需要把当前的 loop_depth 归零
-    auto prev_loop_depth = loop_depth;
+void ControlFlowVisitor::enter([[maybe_unused]] FnItem &node) {
+    // 需要把当前的 loop_depth 归零，离开函数的时候恢复
+    outer_loop_depth.push_back(loop_depth);
     loop_depth = 0;
-    AST_Walker::visit(node);
-    loop_depth = prev_loop_depth;
+}
+void ControlFlowVisitor::leave(FnItem &node) {
+    loop_depth = outer_loop_depth.back();
+    outer_loop_depth.pop_back();
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(StructItem &node) { 
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(StructItem &node) { 
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(EnumItem &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(EnumItem &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(ImplItem &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(ImplItem &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(ConstItem &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(ConstItem &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
 
-void ControlFlowVisitor::visit(LetStmt &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(LetStmt &node) {
     // let 好像不能没有 initializer
     // 先这么写了，到时候再看看
     if (node.initializer == nullptr) {
@@ -248,31 +228,24 @@ void ControlFlowVisitor::visit(LetStmt &node) {
         node_outcome_state_map[node.NodeId] = node_outcome_state_map[node.initializer->NodeId];
     }
 }
-void ControlFlowVisitor::visit(ExprStmt &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(ExprStmt &node) {
     node_outcome_state_map[node.NodeId] = node_outcome_state_map[node.expr->NodeId];
 }
-void ControlFlowVisitor::visit(ItemStmt &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(ItemStmt &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(PathType &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(PathType &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(ArrayType &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(ArrayType &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(UnitType &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(UnitType &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(SelfType &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(SelfType &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
-void ControlFlowVisitor::visit(IdentifierPattern &node) {
-    AST_Walker::visit(node);
+void ControlFlowVisitor::leave(IdentifierPattern &node) {
     node_outcome_state_map[node.NodeId] = get_outcome_state({OutcomeType::NEXT});
 }
@@ -1,14 +1,12 @@
 #include "semantic/decl.h"
 #include "semantic/scope.h"
 
-ConstDecl_ptr find_const_decl(Scope_ptr NowScope, string name) {
-    while (NowScope != nullptr) {
-        for (auto decl : NowScope->value_namespace) {
-            if (decl.first == name) {
-                return std::dynamic_pointer_cast<ConstDecl>(decl.second);
-            }
+ConstDecl_ptr find_const_decl(Scope_ptr NowScope, const string &name) {
+    for (Scope *scope = NowScope.get(); scope != nullptr; scope = scope->parent) {
+        auto it = scope->value_namespace.find(name);
+        if (it != scope->value_namespace.end()) {
+            return std::dynamic_pointer_cast<ConstDecl>(it->second);
         }
-        NowScope = NowScope->parent.lock();
     }
     return nullptr;
 }
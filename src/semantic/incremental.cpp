@@ -0,0 +1,260 @@
+#include "semantic/incremental.h"
+#include "lexer/source_buffer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+// 64 位 FNV-1a
+struct Hasher {
+    uint64_t h = 14695981039346656037ULL;
+    void bytes(const void *data, size_t size) {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        for (size_t k = 0; k < size; k++) {
+            h ^= p[k];
+            h *= 1099511628211ULL;
+        }
+    }
+    void add(uint64_t value) { bytes(&value, sizeof(value)); }
+    void add(std::string_view s) {
+        add(s.size());
+        bytes(s.data(), s.size());
+    }
+};
+
+using NameSet = std::unordered_set<std::string_view>;
+
+// 一个节点自己的属性：种类、flags、名字、名字列表、子节点个数
+void hash_node(const FlatAST &flat, uint32_t i, Hasher &h) {
+    h.add(static_cast<uint64_t>(flat.kind[i]));
+    h.add(flat.flags[i]);
+    h.add(flat.name[i] == FlatAST::NO_NAME ? uint64_t(FlatAST::NO_NAME) : 0);
+    h.add(flat.name_of(i));
+    h.add(flat.name_list_size(i));
+    for (size_t k = 0; k < flat.name_list_size(i); k++) {
+        h.add(flat.name_list_at(i, k));
+    }
+    h.add(flat.child_count[i]);
+}
+
+// 整棵子树的结构，下标都换成相对 root 的，不包括 NodeId
+void hash_subtree(const FlatAST &flat, uint32_t root, Hasher &h) {
+    if (root == FlatAST::NO_NODE) {
+        h.add(uint64_t(FlatAST::NO_NODE));
+        return;
+    }
+    h.add(flat.subtree_end[root] - root);
+    for (uint32_t i = root; i < flat.subtree_end[root]; i++) {
+        hash_node(flat, i, h);
+        for (uint32_t c : flat.child_list(i)) {
+            h.add(c == FlatAST::NO_NODE ? uint64_t(FlatAST::NO_NODE) : c - root);
+        }
+    }
+}
+
+void collect_names(const FlatAST &flat, uint32_t root, NameSet &names) {
+    if (root == FlatAST::NO_NODE) {
+        return;
+    }
+    for (uint32_t i = root; i < flat.subtree_end[root]; i++) {
+        if (flat.name[i] != FlatAST::NO_NAME) {
+            names.insert(flat.name_of(i));
+        }
+        for (size_t k = 0; k < flat.name_list_size(i); k++) {
+            names.insert(flat.name_list_at(i, k));
+        }
+    }
+}
+
+// 顶层声明的接口：同名的声明（struct 和它的 impl）按出现的顺序都加进同一个 hash
+struct Interface {
+    Hasher hash;
+    NameSet names; // 接口里出现的名字
+};
+
+// 函数签名：除了最后一个子节点（函数体）之外的部分
+void add_signature(const FlatAST &flat, uint32_t fn, Interface &interface) {
+    hash_node(flat, fn, interface.hash);
+    auto children = flat.child_list(fn);
+    for (size_t k = 0; k + 1 < children.size(); k++) {
+        hash_subtree(flat, children[k], interface.hash);
+        collect_names(flat, children[k], interface.names);
+    }
+}
+
+void add_whole(const FlatAST &flat, uint32_t item, Interface &interface) {
+    hash_subtree(flat, item, interface.hash);
+    collect_names(flat, item, interface.names);
+}
+
+constexpr char MAGIC[8] = {'R', 'C', 'C', 'H', 'E', 'C', 'K', 'S'};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t count;
+    uint64_t payload_hash;
+};
+
+} // namespace
+
+ItemDependencies ItemDependencies::compute(const vector<Item_ptr> &items) {
+    FlatAST flat = FlatAST::build(items);
+    std::unordered_map<std::string_view, Interface> interfaces;
+    for (uint32_t root : flat.roots) {
+        std::string_view name = flat.name_of(root);
+        switch (flat.kind[root]) {
+            case FlatKind::FnItem:
+                add_signature(flat, root, interfaces[name]);
+                break;
+            case FlatKind::StructItem:
+            case FlatKind::EnumItem:
+            case FlatKind::ConstItem:
+                add_whole(flat, root, interfaces[name]);
+                break;
+            case FlatKind::ImplItem: {
+                // impl 里的方法签名和关联常量算在 struct 的接口里
+                Interface &interface = interfaces[name];
+                for (uint32_t member : flat.child_list(root)) {
+                    if (flat.kind[member] == FlatKind::FnItem) {
+                        add_signature(flat, member, interface);
+                    } else {
+                        add_whole(flat, member, interface);
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    ItemDependencies result;
+    result.fingerprints.reserve(flat.roots.size());
+    result.dependencies.reserve(flat.roots.size());
+    for (uint32_t root : flat.roots) {
+        NameSet names;
+        collect_names(flat, root, names);
+        // 只留下顶层声明，再沿着接口里的名字取闭包
+        vector<std::string_view> pending;
+        NameSet dependencies;
+        for (std::string_view name : names) {
+            if (interfaces.contains(name) && dependencies.insert(name).second) {
+                pending.push_back(name);
+            }
+        }
+        while (!pending.empty()) {
+            std::string_view name = pending.back();
+            pending.pop_back();
+            for (std::string_view next : interfaces.at(name).names) {
+                if (interfaces.contains(next) && dependencies.insert(next).second) {
+                    pending.push_back(next);
+                }
+            }
+        }
+        vector<std::string_view> sorted(dependencies.begin(), dependencies.end());
+        std::sort(sorted.begin(), sorted.end());
+
+        Hasher hash;
+        hash_subtree(flat, root, hash);
+        vector<string> dependency_names;
+        dependency_names.reserve(sorted.size());
+        for (std::string_view name : sorted) {
+            hash.add(name);
+            hash.add(interfaces.at(name).hash.h);
+            dependency_names.emplace_back(name);
+        }
+        result.fingerprints.push_back(hash.h);
+        result.dependencies.push_back(std::move(dependency_names));
+    }
+    return result;
+}
+
+CheckedItemCache CheckedItemCache::from_env() {
+    const char *dir = std::getenv(DIR_ENV);
+    return CheckedItemCache(dir == nullptr ? "" : dir);
+}
+
+string CheckedItemCache::path() const {
+    return (std::filesystem::path(dir) / "checked_items").string();
+}
+
+std::unordered_set<uint64_t> CheckedItemCache::load() const {
+    std::unordered_set<uint64_t> fingerprints;
+    if (!enabled()) {
+        return fingerprints;
+    }
+    try {
+        SourceBuffer_ptr file = SourceBuffer::from_file(path());
+        std::string_view data = file->view();
+        Header header;
+        if (data.size() < sizeof(Header)) {
+            return fingerprints;
+        }
+        std::memcpy(&header, data.data(), sizeof(Header));
+        std::string_view payload = data.substr(sizeof(Header));
+        Hasher payload_hash;
+        payload_hash.bytes(payload.data(), payload.size());
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+            header.header_size != sizeof(Header) || payload.size() != header.count * sizeof(uint64_t) ||
+            header.payload_hash != payload_hash.h) {
+            return fingerprints;
+        }
+        fingerprints.reserve(header.count);
+        for (size_t k = 0; k < header.count; k++) {
+            uint64_t fingerprint;
+            std::memcpy(&fingerprint, payload.data() + k * sizeof(uint64_t), sizeof(uint64_t));
+            fingerprints.insert(fingerprint);
+        }
+    } catch (const string &) {
+        // 打不开当作没有记录
+        fingerprints.clear();
+    }
+    return fingerprints;
+}
+
+void CheckedItemCache::store(const vector<uint64_t> &fingerprints) const {
+    if (!enabled()) {
+        return;
+    }
+    vector<uint64_t> sorted = fingerprints;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.header_size = sizeof(Header);
+    header.count = sorted.size();
+    Hasher payload_hash;
+    payload_hash.bytes(sorted.data(), sorted.size() * sizeof(uint64_t));
+    header.payload_hash = payload_hash.h;
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    string target = path();
+    string temp_path = target + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return;
+        }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(sorted.data()),
+                  static_cast<std::streamsize>(sorted.size() * sizeof(uint64_t)));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path, target, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+    }
+}
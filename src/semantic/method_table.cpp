@@ -0,0 +1,32 @@
+#include "semantic/method_table.h"
+
+void MethodTable::add(RealTypeKind kind, const string &name, FnDecl_ptr decl) {
+    if (kind == RealTypeKind::STRUCT) {
+        throw string("Error, builtin method added for struct type");
+    }
+    add(Owner{kind, nullptr}, name, std::move(decl));
+}
+
+void MethodTable::add(const StructDecl *owner, const string &name, FnDecl_ptr decl) {
+    if (owner == nullptr) {
+        throw string("Error, method added for null struct");
+    }
+    add(Owner{RealTypeKind::STRUCT, owner}, name, std::move(decl));
+}
+
+void MethodTable::add(Owner owner, const string &name, FnDecl_ptr decl) {
+    table[owner].emplace(symbols.intern(name), std::move(decl));
+}
+
+FnDecl_ptr MethodTable::find(const RealType_ptr &base_type, const string &name) const {
+    Owner owner{base_type->kind, nullptr};
+    if (base_type->kind == RealTypeKind::STRUCT) {
+        owner.decl = std::static_pointer_cast<StructRealType>(base_type)->decl.lock().get();
+    }
+    auto methods = table.find(owner);
+    if (methods == table.end()) {
+        return nullptr;
+    }
+    auto it = methods->second.find(symbols.find(name));
+    return it == methods->second.end() ? nullptr : it->second;
+}
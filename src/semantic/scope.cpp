@@ -8,7 +8,7 @@ step1 : 建作用域树 + 符号初收集
 
 using std::make_shared;
 
-ScopeBuilder_Visitor::ScopeBuilder_Visitor(Scope_ptr root_scope, map<size_t, shared_ptr<Scope>> &node_scope_map_) :
+ScopeBuilder_Visitor::ScopeBuilder_Visitor(Scope_ptr root_scope, NodeTable<shared_ptr<Scope>> &node_scope_map_) :
     node_scope_map(node_scope_map_), block_is_in_function(false) {
     // 初始化作用域栈，加入根作用域
     scope_stack.push_back(root_scope);
@@ -53,7 +53,7 @@ void ScopeBuilder_Visitor::visit(BlockExpr &node) {
     } else {
         // 新建作用域
         build_new_scope = true;
-        Scope_ptr new_scope = make_shared<Scope>(current_scope(), ScopeKind::Block);
+        Scope_ptr new_scope = make_shared<Scope>(current_scope().get(), ScopeKind::Block);
         current_scope()->children.push_back(new_scope);
         scope_stack.push_back(new_scope);
     }
@@ -113,10 +113,10 @@ void ScopeBuilder_Visitor::visit(RepeatArrayExpr &node) {
 }
 void ScopeBuilder_Visitor::visit(FnItem &node) {
     node_scope_map[node.NodeId] = current_scope();
-    Scope_ptr new_scope = make_shared<Scope>(current_scope(), ScopeKind::Function);
+    Scope_ptr new_scope = make_shared<Scope>(current_scope().get(), ScopeKind::Function);
 
     // FnDecl 现在接收 FnItem_ptr
-    FnItem_ptr fn_item_ptr = make_shared<FnItem>(node);
+    FnItem_ptr fn_item_ptr = &node;
     FnDecl_ptr fn_decl =
         make_shared<FnDecl>(fn_item_ptr, new_scope, node.receiver_type, node.function_name);
     // 关联函数的事情，第二轮再搞
@@ -140,7 +140,7 @@ void ScopeBuilder_Visitor::visit(StructItem &node) {
     node_scope_map[node.NodeId] = current_scope();
 
     // StructDecl 现在接收 StructItem_ptr
-    StructItem_ptr struct_item_ptr = make_shared<StructItem>(node);
+    StructItem_ptr struct_item_ptr = &node;
     StructDecl_ptr struct_decl =
         make_shared<StructDecl>(struct_item_ptr, node.struct_name);
     struct_decl->field_order.reserve(node.fields.size());
@@ -160,7 +160,7 @@ void ScopeBuilder_Visitor::visit(EnumItem &node) {
     node_scope_map[node.NodeId] = current_scope();
 
     // EnumDecl 现在接收 EnumItem_ptr
-    EnumItem_ptr enum_item_ptr = make_shared<EnumItem>(node);
+    EnumItem_ptr enum_item_ptr = &node;
     EnumDecl_ptr enum_decl = make_shared<EnumDecl>(enum_item_ptr, node.enum_name);
     // 加入 type_namespace
     if (current_scope()->type_namespace.find(node.enum_name) != 
@@ -173,7 +173,7 @@ void ScopeBuilder_Visitor::visit(EnumItem &node) {
 }
 void ScopeBuilder_Visitor::visit(ImplItem &node) {
     node_scope_map[node.NodeId] = current_scope();
-    Scope_ptr new_scope = make_shared<Scope>(current_scope(), ScopeKind::Impl, node.struct_name);
+    Scope_ptr new_scope = make_shared<Scope>(current_scope().get(), ScopeKind::Impl, node.struct_name);
     current_scope()->children.push_back(new_scope);
     scope_stack.push_back(new_scope);
     AST_Walker::visit(node);
@@ -183,7 +183,7 @@ void ScopeBuilder_Visitor::visit(ConstItem &node) {
     node_scope_map[node.NodeId] = current_scope();
 
     // ConstDecl 现在接收 ConstItem_ptr
-    ConstItem_ptr const_item_ptr = make_shared<ConstItem>(node);
+    ConstItem_ptr const_item_ptr = &node;
     ConstDecl_ptr const_decl = make_shared<ConstDecl>(const_item_ptr, node.const_name);
     // 加入 value_namespace
     if (current_scope()->value_namespace.find(node.const_name) != 
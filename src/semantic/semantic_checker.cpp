@@ -1,15 +1,35 @@
 #include "semantic/semantic_checker.h"
 #include "semantic/type.h"
+#include "tools/tools.h"
 // #include "ast/visitor.h"
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <exception>
 // #include <iostream>
 #include <memory>
+#include <thread>
 #include <vector>
 
-Semantic_Checker::Semantic_Checker(std::vector<Item_ptr> &items_) :
-    root_scope(std::make_shared<Scope>(nullptr, ScopeKind::Root)), items(items_) {}
+Semantic_Checker::Semantic_Checker(std::vector<Item_ptr> &items_, size_t node_count) :
+    root_scope(std::make_shared<Scope>(nullptr, ScopeKind::Root)), items(items_),
+    method_table(symbols), associated_func_table(symbols) {
+    node_scope_map.reserve(node_count);
+    type_map.reserve(node_count);
+    fn_item_to_decl_map.reserve(node_count);
+    call_expr_to_decl_map.reserve(node_count);
+    identifier_expr_to_decl_map.reserve(node_count);
+    let_stmt_to_decl_map.reserve(node_count);
+    const_expr_to_size_map.reserve(node_count);
+    node_outcome_state_map.reserve(node_count);
+    node_type_and_place_kind_map.reserve(node_count);
+}
 
 void Semantic_Checker::checker() {
+    if (checked_items != nullptr) {
+        item_dependencies = ItemDependencies::compute(items);
+    }
+
     step1_build_scopes_and_collect_symbols();
 
     step2_resolve_types_and_check();
@@ -25,12 +45,12 @@ void Semantic_Checker::step1_build_scopes_and_collect_symbols() {
     // show ast
     // AST_Printer ast_printer;
     // for (auto &item : items) {
-    //     item->accept(ast_printer);
+    //     ast_printer.dispatch(item);
     // }
     // 建作用域树
     ScopeBuilder_Visitor visitor(root_scope, node_scope_map);
     for (auto &item : items) {
-        item->accept(visitor);
+        visitor.dispatch(item);
     }
 }
 
@@ -49,10 +69,11 @@ void Semantic_Checker::Scope_dfs_and_build_type(Scope_ptr scope) {
         将这里面的 fn 和 const 加入到 impl_struct 的 StructDecl 里面
         */
         // 先找到 impl_struct 对应的 StructDecl
-        Scope_ptr current_scope = scope;
+        Scope *current_scope = scope.get();
         while (current_scope != nullptr) {
-            if (current_scope->type_namespace.find(scope->impl_struct) != current_scope->type_namespace.end()) {
-                TypeDecl_ptr type_decl = current_scope->type_namespace[scope->impl_struct];
+            auto it = current_scope->type_namespace.find(scope->impl_struct);
+            if (it != current_scope->type_namespace.end()) {
+                TypeDecl_ptr type_decl = it->second;
                 if (type_decl->kind == TypeDeclKind::Struct) {
                     impl_struct_decl = std::dynamic_pointer_cast<StructDecl>(type_decl);
                     break;
@@ -60,13 +81,13 @@ void Semantic_Checker::Scope_dfs_and_build_type(Scope_ptr scope) {
                     throw string("CE, impl struct name ") + scope->impl_struct + " is not a struct";
                 }
             } else {
-                current_scope = current_scope->parent.lock();
+                current_scope = current_scope->parent;
             }
         }
         if (impl_struct_decl == nullptr) {
             throw string("CE, impl struct name ") + scope->impl_struct + " not found";
         }
-        scope->self_struct = std::make_shared<StructRealType>(scope->impl_struct, ReferenceType::NO_REF, impl_struct_decl);
+        scope->self_struct = types.struct_type(impl_struct_decl);
     }
     
     for (auto [name, type_decl] : scope->type_namespace) {
@@ -77,7 +98,7 @@ void Semantic_Checker::Scope_dfs_and_build_type(Scope_ptr scope) {
                 if (struct_decl->fields.find(field_name) != struct_decl->fields.end()) {
                     throw string("CE, field name ") + field_name + " redefined in struct " + struct_decl->ast_node->struct_name;
                 }
-                RealType_ptr field_type = find_real_type(scope, field_type_ast, type_map, const_expr_queue);
+                RealType_ptr field_type = find_real_type(scope, field_type_ast, type_map, const_expr_queue, types);
                 struct_decl->fields[field_name] = field_type;
             }
         }
@@ -98,16 +119,16 @@ void Semantic_Checker::Scope_dfs_and_build_type(Scope_ptr scope) {
             auto fn_decl = std::dynamic_pointer_cast<FnDecl>(value_decl);
             // 解析 parameters
             for (auto [param_pattern, param_type_ast] : fn_decl->ast_node->parameters) {
-                RealType_ptr param_type = find_real_type(scope, param_type_ast, type_map, const_expr_queue);
+                RealType_ptr param_type = find_real_type(scope, param_type_ast, type_map, const_expr_queue, types);
                 fn_decl->parameters.push_back({param_pattern, param_type});
             }
             // 解析 return type
             if (fn_decl->ast_node->return_type != nullptr) {
-                RealType_ptr return_type = find_real_type(scope, fn_decl->ast_node->return_type, type_map, const_expr_queue);
+                RealType_ptr return_type = find_real_type(scope, fn_decl->ast_node->return_type, type_map, const_expr_queue, types);
                 fn_decl->return_type = return_type;
             } else {
                 // 没有返回类型，默认为 ()
-                fn_decl->return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+                fn_decl->return_type = TypeContext::primitive(RealTypeKind::UNIT);
             }
             if (fn_decl->ast_node) {
                 fn_item_to_decl_map[fn_decl->ast_node->NodeId] = fn_decl;
@@ -115,7 +136,7 @@ void Semantic_Checker::Scope_dfs_and_build_type(Scope_ptr scope) {
         } else if (value_decl->kind == ValueDeclKind::Constant) {
             auto const_decl = std::dynamic_pointer_cast<ConstDecl>(value_decl);
             // 解析 const type
-            RealType_ptr const_type = find_real_type(scope, const_decl->ast_node->const_type, type_map, const_expr_queue);
+            RealType_ptr const_type = find_real_type(scope, const_decl->ast_node->const_type, type_map, const_expr_queue, types);
             const_decl->const_type = const_type;
         }
     }
@@ -136,9 +157,11 @@ void Semantic_Checker::Scope_dfs_and_build_type(Scope_ptr scope) {
                 } else {
                     // 关联函数
                     impl_struct_decl->associated_func[name] = fn_decl;
+                    associated_func_table.add(impl_struct_decl.get(), name, fn_decl);
                     fn_decl->self_struct = impl_struct_decl;
                 }
                 impl_struct_decl->methods[name] = fn_decl;
+                method_table.add(impl_struct_decl.get(), name, fn_decl);
             } else if (value_decl->kind == ValueDeclKind::Constant) {
                 auto const_decl = std::dynamic_pointer_cast<ConstDecl>(value_decl);
                 impl_struct_decl->associated_const[name] = const_decl;
@@ -172,75 +195,184 @@ void Semantic_Checker::Scope_dfs_and_build_type(Scope_ptr scope) {
 
 
 void Semantic_Checker::step3_constant_evaluation_and_control_flow_analysis() {
+    // 解析 let 等处的类型、求 const item、控制流分析、收集 ArrayType 合在一次遍历里
+    // 能合在一起的原因见 semantic_checker.h
     OtherTypeAndRepeatArrayVisitor let_stmt_visitor(
         node_scope_map,
         type_map,
-        const_expr_queue
+        const_expr_queue,
+        types
     );
-    for (auto &item : items) {
-        item->accept(let_stmt_visitor);
-    }
-    // std::cerr << "LetStmtAndRepeatArrayVisitor finish\n";
-    // 先求所有的 const item
-    ConstItemVisitor const_item_visitor(
-        false,
+    ConstItemPass const_item_pass(
         node_scope_map,
         const_value_map,
         type_map,
         const_expr_to_size_map
     );
+    ControlFlowVisitor control_flow_visitor(node_outcome_state_map);
+    ArrayTypeVisitor array_type_visitor(type_map, const_expr_to_size_map, types);
+    FusedWalker walker(let_stmt_visitor, const_item_pass, control_flow_visitor, array_type_visitor);
     for (auto &item : items) {
-        item->accept(const_item_visitor);
+        walker.dispatch(item);
     }
+    // 遍历完所有 as 的目标类型都解析好了，再按需求所有的 const
+    const_item_pass.evaluate_all();
     // 然后对于 queue 中的 const 去求值，如果已经求了就不用管了
+    // 结构相同的表达式只求一次，结果直接共用
+    ConstItemVisitor &const_expr_visitor = const_item_pass.evaluator;
+    ConstExprTable const_expr_table(const_expr_visitor, type_map);
     for (auto expr : const_expr_queue) {
-        if (const_expr_to_size_map.find(expr->NodeId) == const_expr_to_size_map.end()) {
-            ConstItemVisitor const_expr_visitor(
-                true,
-                node_scope_map,
-                const_value_map,
-                type_map,
-                const_expr_to_size_map
-            );
-            expr->accept(const_expr_visitor);
+        if (!const_expr_to_size_map.contains(expr->NodeId)) {
+            size_t h = 0;
+            bool hashable = const_expr_table.hash(expr, h);
+            if (hashable) {
+                if (const size_t *size = const_expr_table.find(expr, h)) {
+                    const_expr_to_size_map[expr->NodeId] = *size;
+                    continue;
+                }
+            }
+            const_expr_visitor.is_need_to_calculate = true;
+            const_expr_visitor.const_value = nullptr;
+            const_expr_visitor.dispatch(expr);
             auto value = const_expr_visitor.const_value;
             size_t size = const_expr_visitor.calc_const_array_size(value);
             const_expr_to_size_map[expr->NodeId] = size;
+            if (hashable) {
+                const_expr_table.insert(expr, h, size);
+            }
         }
     }
-    // 然后进行控制流检查
-    ControlFlowVisitor control_flow_visitor(node_outcome_state_map);
-    for (auto &item : items) {
-        item->accept(control_flow_visitor);
+    // 常量表达式都求完了，补全 ArrayType 的 size
+    array_type_visitor.fill_array_sizes();
+    // 之后的类型都是唯一的，类型相同就是指针相同
+    intern_scope_types(root_scope);
+}
+
+void Semantic_Checker::intern_scope_types(Scope_ptr scope) {
+    for (auto &[name, type_decl] : scope->type_namespace) {
+        if (type_decl->kind == TypeDeclKind::Struct) {
+            auto struct_decl = std::static_pointer_cast<StructDecl>(type_decl);
+            for (auto &[field_name, field_type] : struct_decl->fields) {
+                field_type = types.intern(field_type);
+            }
+        }
+    }
+    for (auto &[name, value_decl] : scope->value_namespace) {
+        if (value_decl->kind == ValueDeclKind::Function) {
+            auto fn_decl = std::static_pointer_cast<FnDecl>(value_decl);
+            for (auto &[param_pattern, param_type] : fn_decl->parameters) {
+                param_type = types.intern(param_type);
+            }
+            if (fn_decl->return_type != nullptr) {
+                fn_decl->return_type = types.intern(fn_decl->return_type);
+            }
+        } else if (value_decl->kind == ValueDeclKind::Constant) {
+            auto const_decl = std::static_pointer_cast<ConstDecl>(value_decl);
+            const_decl->const_type = types.intern(const_decl->const_type);
+        }
+    }
+    for (auto &child_scope : scope->children) {
+        intern_scope_types(child_scope);
     }
 }
 
 void Semantic_Checker::step4_expr_type_and_let_stmt_analysis() {
-    // ArrayTypeVisitor 先跑一遍，补全 ArrayType 的 size
-    ArrayTypeVisitor array_type_visitor(type_map, const_expr_to_size_map);
-    for (auto &item : items) {
-        item->accept(array_type_visitor);
+    // ExprTypeAndLetStmtVisitor 求出每个表达式的 RealType 和 PlaceKind
+    size_t thread_count = step4_thread_count != 0 ? step4_thread_count : std::thread::hardware_concurrency();
+    thread_count = std::min(thread_count, items.size());
+    // 增量检查时，之前检查通过、自己和依赖都没变的 item 不用再查
+    auto unchanged = [&](size_t k) {
+        return checked_items != nullptr && checked_items->contains(item_dependencies.fingerprints[k]);
+    };
+    auto record_passed = [&](size_t end) {
+        if (checked_items != nullptr) {
+            passed_items.assign(item_dependencies.fingerprints.begin(), item_dependencies.fingerprints.begin() + end);
+        }
+    };
+    if (thread_count <= 1 || items.size() < step4_min_items) {
+        ExprTypeAndLetStmtVisitor expr_type_visitor(
+            false,
+            node_type_and_place_kind_map,
+            identifier_expr_to_decl_map,
+            let_stmt_to_decl_map,
+            node_scope_map,
+            type_map,
+            const_expr_to_size_map,
+            node_outcome_state_map,
+            call_expr_to_decl_map,
+            method_table,
+            associated_func_table,
+            types
+        );
+        for (size_t k = 0; k < items.size(); k++) {
+            if (unchanged(k)) {
+                continue;
+            }
+            try {
+                expr_type_visitor.dispatch(items[k]);
+            } catch (...) {
+                record_passed(k);
+                throw;
+            }
+        }
+        record_passed(items.size());
+        return;
     }
-    // std::cerr << "ArrayTypeVisitor finish\n";
-    // ExprTypeAndLetStmtVisitor 再跑一遍，求出每个表达式的 RealType 和 PlaceKind
-    ExprTypeAndLetStmtVisitor expr_type_visitor(
-        false,
-        node_type_and_place_kind_map,
-        identifier_expr_to_decl_map,
-        let_stmt_to_decl_map,
-        node_scope_map,
-        type_map,
-        scope_local_variable_map,
-        const_expr_to_size_map,
-        node_outcome_state_map,
-        call_expr_to_decl_map,
-        builtin_method_funcs,
-        builtin_associated_funcs
-    );
-    for (auto &item : items) {
-        item->accept(expr_type_visitor);
+    // 每个线程自己写的表，只会用到自己检查的 item 的那一段 NodeId
+    struct Step4Result {
+        NodeTable<pair<RealType_ptr, PlaceKind>> node_type_and_place_kind_map;
+        NodeTable<ValueDecl_ptr> identifier_expr_to_decl_map;
+        NodeTable<LetDecl_ptr> let_stmt_to_decl_map;
+        NodeTable<FnDecl_ptr> call_expr_to_decl_map;
+    };
+    vector<Step4Result> results(thread_count);
+    vector<std::exception_ptr> errors(items.size());
+    std::atomic<size_t> next_item = 0, next_result = 0;
+    // 出错的 item 里最靠前的那个，在它后面的 item 不用再检查
+    std::atomic<size_t> first_error = items.size();
+    auto worker = [&]() {
+        Step4Result &result = results[next_result++];
+        ExprTypeAndLetStmtVisitor expr_type_visitor(
+            false,
+            result.node_type_and_place_kind_map,
+            result.identifier_expr_to_decl_map,
+            result.let_stmt_to_decl_map,
+            node_scope_map,
+            type_map,
+            const_expr_to_size_map,
+            node_outcome_state_map,
+            result.call_expr_to_decl_map,
+            method_table,
+            associated_func_table,
+            types
+        );
+        for (size_t k = next_item++; k < items.size() && k < first_error; k = next_item++) {
+            if (unchanged(k)) {
+                continue;
+            }
+            try {
+                expr_type_visitor.dispatch(items[k]);
+            } catch (...) {
+                errors[k] = std::current_exception();
+                size_t expected = first_error;
+                while (k < expected && !first_error.compare_exchange_weak(expected, k)) {
+                }
+                // item 是按顺序取的，这个线程之后取到的都在 k 后面
+                return;
+            }
+        }
+    };
+    run_in_parallel(thread_count, worker);
+    record_passed(first_error);
+    if (first_error < items.size()) {
+        std::rethrow_exception(errors[first_error]);
+    }
+    for (auto &result : results) {
+        node_type_and_place_kind_map.merge_from(std::move(result.node_type_and_place_kind_map));
+        identifier_expr_to_decl_map.merge_from(std::move(result.identifier_expr_to_decl_map));
+        let_stmt_to_decl_map.merge_from(std::move(result.let_stmt_to_decl_map));
+        call_expr_to_decl_map.merge_from(std::move(result.call_expr_to_decl_map));
     }
-    
 }
 
 void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
@@ -253,9 +385,9 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "print"
         );
         print_fn_decl->is_builtin = true;
-        IdentifierPattern_ptr id_pattern = std::make_shared<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
-        print_fn_decl->parameters.push_back({id_pattern, std::make_shared<StrRealType>(ReferenceType::REF)});
-        print_fn_decl->return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        IdentifierPattern_ptr id_pattern = builtin_nodes.make<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
+        print_fn_decl->parameters.push_back({id_pattern, TypeContext::primitive(RealTypeKind::STR, ReferenceType::REF)});
+        print_fn_decl->return_type = TypeContext::primitive(RealTypeKind::UNIT);
         string fn_name = "print";
         if (root_scope->value_namespace.find(fn_name) != root_scope->value_namespace.end()) {
             throw string("CE, builtin function name conflict: ") + fn_name;
@@ -271,9 +403,9 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "println"
         );
         println_fn_decl->is_builtin = true;
-        IdentifierPattern_ptr id_pattern = std::make_shared<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
-        println_fn_decl->parameters.push_back({id_pattern, std::make_shared<StrRealType>(ReferenceType::REF)});
-        println_fn_decl->return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        IdentifierPattern_ptr id_pattern = builtin_nodes.make<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
+        println_fn_decl->parameters.push_back({id_pattern, TypeContext::primitive(RealTypeKind::STR, ReferenceType::REF)});
+        println_fn_decl->return_type = TypeContext::primitive(RealTypeKind::UNIT);
         string fn_name = "println";
         if (root_scope->value_namespace.find(fn_name) != root_scope->value_namespace.end()) {
             throw string("CE, builtin function name conflict: ") + fn_name;
@@ -289,9 +421,9 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "printInt"
         );
         printint_fn_decl->is_builtin = true;
-        IdentifierPattern_ptr id_pattern = std::make_shared<IdentifierPattern>("n", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
-        printint_fn_decl->parameters.push_back({id_pattern, std::make_shared<I32RealType>(ReferenceType::NO_REF)});
-        printint_fn_decl->return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        IdentifierPattern_ptr id_pattern = builtin_nodes.make<IdentifierPattern>("n", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
+        printint_fn_decl->parameters.push_back({id_pattern, TypeContext::primitive(RealTypeKind::I32)});
+        printint_fn_decl->return_type = TypeContext::primitive(RealTypeKind::UNIT);
         string fn_name = "printInt";
         if (root_scope->value_namespace.find(fn_name) != root_scope->value_namespace.end()) {
             throw string("CE, builtin function name conflict: ") + fn_name;
@@ -307,9 +439,9 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "printlnInt"
         );
         printlnint_fn_decl->is_builtin = true;
-        IdentifierPattern_ptr id_pattern = std::make_shared<IdentifierPattern>("n", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
-        printlnint_fn_decl->parameters.push_back({id_pattern, std::make_shared<I32RealType>(ReferenceType::NO_REF)});
-        printlnint_fn_decl->return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        IdentifierPattern_ptr id_pattern = builtin_nodes.make<IdentifierPattern>("n", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
+        printlnint_fn_decl->parameters.push_back({id_pattern, TypeContext::primitive(RealTypeKind::I32)});
+        printlnint_fn_decl->return_type = TypeContext::primitive(RealTypeKind::UNIT);
         string fn_name = "printlnInt";
         if (root_scope->value_namespace.find(fn_name) != root_scope->value_namespace.end()) {
             throw string("CE, builtin function name conflict: ") + fn_name;
@@ -325,7 +457,7 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "getString"
         );
         getstring_fn_decl->is_builtin = true;
-        getstring_fn_decl->return_type = std::make_shared<StringRealType>(ReferenceType::NO_REF);
+        getstring_fn_decl->return_type = TypeContext::primitive(RealTypeKind::STRING);
         string fn_name = "getString";
         if (root_scope->value_namespace.find(fn_name) != root_scope->value_namespace.end()) {
             throw string("CE, builtin function name conflict: ") + fn_name;
@@ -341,7 +473,7 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "getInt"
         );
         getint_fn_decl->is_builtin = true;
-        getint_fn_decl->return_type = std::make_shared<I32RealType>(ReferenceType::NO_REF);
+        getint_fn_decl->return_type = TypeContext::primitive(RealTypeKind::I32);
         string fn_name = "getInt";
         if (root_scope->value_namespace.find(fn_name) != root_scope->value_namespace.end()) {
             throw string("CE, builtin function name conflict: ") + fn_name;
@@ -359,9 +491,9 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
         );
         exit_fn_decl->is_exit = true;
         exit_fn_decl->is_builtin = true;
-        IdentifierPattern_ptr id_pattern = std::make_shared<IdentifierPattern>("code", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
-        exit_fn_decl->parameters.push_back({id_pattern, std::make_shared<I32RealType>(ReferenceType::NO_REF)});
-        exit_fn_decl->return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        IdentifierPattern_ptr id_pattern = builtin_nodes.make<IdentifierPattern>("code", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
+        exit_fn_decl->parameters.push_back({id_pattern, TypeContext::primitive(RealTypeKind::I32)});
+        exit_fn_decl->return_type = TypeContext::primitive(RealTypeKind::UNIT);
         string fn_name = "exit";
         if (root_scope->value_namespace.find(fn_name) != root_scope->value_namespace.end()) {
             throw string("CE, builtin function name conflict: ") + fn_name;
@@ -375,7 +507,7 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
     */
     {
         auto to_string_return =
-            std::make_shared<StringRealType>(ReferenceType::NO_REF);
+            TypeContext::primitive(RealTypeKind::STRING);
         auto make_to_string_decl = [&](RealType_ptr self_type) {
             auto decl = std::make_shared<FnDecl>(
                 nullptr,
@@ -391,15 +523,15 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
         builtin_method_funcs.push_back(
             {RealTypeKind::U32, "to_string",
              make_to_string_decl(
-                 std::make_shared<U32RealType>(ReferenceType::NO_REF))});
+                 TypeContext::primitive(RealTypeKind::U32))});
         builtin_method_funcs.push_back(
             {RealTypeKind::USIZE, "to_string",
              make_to_string_decl(
-                 std::make_shared<UsizeRealType>(ReferenceType::NO_REF))});
+                 TypeContext::primitive(RealTypeKind::USIZE))});
         builtin_method_funcs.push_back(
             {RealTypeKind::ANYINT, "to_string",
              make_to_string_decl(
-                 std::make_shared<U32RealType>(ReferenceType::NO_REF))});
+                 TypeContext::primitive(RealTypeKind::U32))});
     }
     /*    
     as_str and as_mut_str
@@ -411,7 +543,7 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
     */
     {
         auto string_self_type =
-            std::make_shared<StringRealType>(ReferenceType::NO_REF);
+            TypeContext::primitive(RealTypeKind::STRING);
         auto as_str_fn_decl = std::make_shared<FnDecl>(
             nullptr,
             nullptr,
@@ -419,7 +551,7 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "as_str"
         );
         as_str_fn_decl->is_builtin = true;
-        as_str_fn_decl->return_type = std::make_shared<StrRealType>(ReferenceType::REF);
+        as_str_fn_decl->return_type = TypeContext::primitive(RealTypeKind::STR, ReferenceType::REF);
         as_str_fn_decl->set_builtin_method_self_type(string_self_type);
         builtin_method_funcs.push_back({RealTypeKind::STRING, "as_str", as_str_fn_decl});
         auto as_mut_str_fn_decl = std::make_shared<FnDecl>(
@@ -429,7 +561,7 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "as_mut_str"
         );
         as_mut_str_fn_decl->is_builtin = true;
-        as_mut_str_fn_decl->return_type = std::make_shared<StrRealType>(ReferenceType::REF_MUT);
+        as_mut_str_fn_decl->return_type = TypeContext::primitive(RealTypeKind::STR, ReferenceType::REF_MUT);
         as_mut_str_fn_decl->set_builtin_method_self_type(string_self_type);
         builtin_method_funcs.push_back({RealTypeKind::STRING, "as_mut_str", as_mut_str_fn_decl});
     }
@@ -439,9 +571,7 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
     Available on: [T; N], String, &str
     */
     {
-        auto array_self_type = std::make_shared<ArrayRealType>(
-            std::make_shared<AnyIntRealType>(ReferenceType::NO_REF), nullptr,
-            ReferenceType::NO_REF, 0);
+        auto array_self_type = types.array(TypeContext::primitive(RealTypeKind::ANYINT), 0);
         auto arr_len_fn_decl = std::make_shared<FnDecl>(
             nullptr,
             nullptr,
@@ -450,12 +580,12 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
         );
         arr_len_fn_decl->is_builtin = true;
         arr_len_fn_decl->is_array_len = true;
-        arr_len_fn_decl->return_type = std::make_shared<UsizeRealType>(ReferenceType::NO_REF);
+        arr_len_fn_decl->return_type = TypeContext::primitive(RealTypeKind::USIZE);
         arr_len_fn_decl->set_builtin_method_self_type(array_self_type);
         builtin_method_funcs.push_back({RealTypeKind::ARRAY, "len", arr_len_fn_decl});
 
         auto string_self_type =
-            std::make_shared<StringRealType>(ReferenceType::NO_REF);
+            TypeContext::primitive(RealTypeKind::STRING);
         auto string_len_fn_decl = std::make_shared<FnDecl>(
             nullptr,
             nullptr,
@@ -463,11 +593,11 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "string_len"
         );
         string_len_fn_decl->is_builtin = true;
-        string_len_fn_decl->return_type = std::make_shared<UsizeRealType>(ReferenceType::NO_REF);
+        string_len_fn_decl->return_type = TypeContext::primitive(RealTypeKind::USIZE);
         string_len_fn_decl->set_builtin_method_self_type(string_self_type);
         builtin_method_funcs.push_back({RealTypeKind::STRING, "len", string_len_fn_decl});
 
-        auto str_self_type = std::make_shared<StrRealType>(ReferenceType::NO_REF);
+        auto str_self_type = TypeContext::primitive(RealTypeKind::STR);
         auto str_len_fn_decl = std::make_shared<FnDecl>(
             nullptr,
             nullptr,
@@ -475,7 +605,7 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             "str_len"
         );
         str_len_fn_decl->is_builtin = true;
-        str_len_fn_decl->return_type = std::make_shared<UsizeRealType>(ReferenceType::NO_REF);
+        str_len_fn_decl->return_type = TypeContext::primitive(RealTypeKind::USIZE);
         str_len_fn_decl->set_builtin_method_self_type(str_self_type);
         builtin_method_funcs.push_back({RealTypeKind::STR, "len", str_len_fn_decl});
     }
@@ -491,10 +621,10 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             fn_reciever_type::NO_RECEIVER,
             "from"
         );
-        IdentifierPattern_ptr from_id_pattern = std::make_shared<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
-        from_fn_decl->parameters.push_back({from_id_pattern, std::make_shared<StrRealType>(ReferenceType::REF)});
+        IdentifierPattern_ptr from_id_pattern = builtin_nodes.make<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
+        from_fn_decl->parameters.push_back({from_id_pattern, TypeContext::primitive(RealTypeKind::STR, ReferenceType::REF)});
         from_fn_decl->is_builtin = true;
-        from_fn_decl->return_type = std::make_shared<StringRealType>(ReferenceType::NO_REF);
+        from_fn_decl->return_type = TypeContext::primitive(RealTypeKind::STRING);
         builtin_associated_funcs.push_back({RealTypeKind::STRING, "from", from_fn_decl});
         auto from_mut_fn_decl = std::make_shared<FnDecl>(
             nullptr,
@@ -502,10 +632,10 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
             fn_reciever_type::NO_RECEIVER,
             "from"
         );
-        IdentifierPattern_ptr from_mut_id_pattern = std::make_shared<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
-        from_mut_fn_decl->parameters.push_back({from_mut_id_pattern, std::make_shared<StrRealType>(ReferenceType::REF_MUT)});
+        IdentifierPattern_ptr from_mut_id_pattern = builtin_nodes.make<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
+        from_mut_fn_decl->parameters.push_back({from_mut_id_pattern, TypeContext::primitive(RealTypeKind::STR, ReferenceType::REF_MUT)});
         from_mut_fn_decl->is_builtin = true;
-        from_mut_fn_decl->return_type = std::make_shared<StringRealType>(ReferenceType::NO_REF);
+        from_mut_fn_decl->return_type = TypeContext::primitive(RealTypeKind::STRING);
         builtin_associated_funcs.push_back({RealTypeKind::STRING, "from", from_mut_fn_decl});
     }
     /*
@@ -515,18 +645,25 @@ void Semantic_Checker::add_builtin_methods_and_associated_funcs() {
     */
     {
         auto string_self_type =
-            std::make_shared<StringRealType>(ReferenceType::NO_REF);
+            TypeContext::primitive(RealTypeKind::STRING);
         auto append_fn_decl = std::make_shared<FnDecl>(
             nullptr,
             nullptr,
             fn_reciever_type::SELF_REF_MUT,
             "append"
         );
-        IdentifierPattern_ptr append_id_pattern = std::make_shared<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
-        append_fn_decl->parameters.push_back({append_id_pattern, std::make_shared<StrRealType>(ReferenceType::REF)});
+        IdentifierPattern_ptr append_id_pattern = builtin_nodes.make<IdentifierPattern>("s", Mutibility::IMMUTABLE, ReferenceType::NO_REF);
+        append_fn_decl->parameters.push_back({append_id_pattern, TypeContext::primitive(RealTypeKind::STR, ReferenceType::REF)});
         append_fn_decl->is_builtin = true;
-        append_fn_decl->return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        append_fn_decl->return_type = TypeContext::primitive(RealTypeKind::UNIT);
         append_fn_decl->set_builtin_method_self_type(string_self_type);
         builtin_method_funcs.push_back({RealTypeKind::STRING, "append", append_fn_decl});
     }
+    // 全部登记完之后建索引
+    for (auto &[kind, name, decl] : builtin_method_funcs) {
+        method_table.add(kind, name, decl);
+    }
+    for (auto &[kind, name, decl] : builtin_associated_funcs) {
+        associated_func_table.add(kind, name, decl);
+    }
 }
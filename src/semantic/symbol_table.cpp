@@ -0,0 +1,54 @@
+#include "semantic/symbol_table.h"
+#include <algorithm>
+
+void ScopedSymbolTable::enter(Scope *scope) {
+    if (current_scope() == scope) {
+        return;
+    }
+    // path 里是要进入的作用域，从深到浅
+    vector<Scope *> path;
+    Scope *target = scope;
+    while (target != nullptr && target->depth >= active.size()) {
+        path.push_back(target);
+        target = target->parent;
+    }
+    // 比 target 深的作用域都要离开
+    size_t keep = target == nullptr ? 0 : target->depth + 1;
+    while (active.size() > keep) {
+        pop();
+    }
+    // 现在 target 和 active.back() 深度相同，一起往上走到公共祖先
+    while (!active.empty() && active.back().scope != target) {
+        pop();
+        path.push_back(target);
+        target = target->parent;
+    }
+    for (auto it = path.rbegin(); it != path.rend(); it++) {
+        push(*it);
+    }
+}
+
+void ScopedSymbolTable::bind(uint32_t symbol, ValueDecl_ptr decl) {
+    if (symbol >= bindings.size()) {
+        bindings.resize(std::max<size_t>(symbols.size(), size_t(symbol) + 1));
+    }
+    undo_log.emplace_back(symbol, std::move(bindings[symbol]));
+    bindings[symbol] = std::move(decl);
+}
+
+void ScopedSymbolTable::push(Scope *scope) {
+    active.push_back({scope, undo_log.size()});
+    for (auto &[name, decl] : scope->value_namespace) {
+        bind(symbols.intern(name), decl);
+    }
+}
+
+void ScopedSymbolTable::pop() {
+    size_t mark = active.back().undo_mark;
+    while (undo_log.size() > mark) {
+        auto &[symbol, previous] = undo_log.back();
+        bindings[symbol] = std::move(previous);
+        undo_log.pop_back();
+    }
+    active.pop_back();
+}
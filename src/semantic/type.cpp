@@ -2,6 +2,7 @@
 #include "semantic/decl.h"
 #include "semantic/scope.h"
 #include "semantic/type.h"
+#include <array>
 #include <cassert>
 #include <cstddef>
 // #include <iostream>
@@ -73,68 +74,182 @@ string FunctionRealType::show_real_type_info() {
     return reference_type_to_string(is_ref) + " FUNCTION";
 }
 
-RealType_ptr find_real_type(Scope_ptr current_scope, Type_ptr type_ast, map<size_t, RealType_ptr> &type_map, vector<Expr_ptr> &const_expr_queue) {
-    if (type_map.find(type_ast->NodeId) != type_map.end()) {
+namespace {
+
+constexpr size_t REAL_TYPE_KIND_COUNT = static_cast<size_t>(RealTypeKind::FUNCTION) + 1;
+constexpr size_t REFERENCE_TYPE_COUNT = static_cast<size_t>(ReferenceType::REF_MUT) + 1;
+
+RealType_ptr make_primitive(RealTypeKind kind, ReferenceType ref) {
+    switch (kind) {
+        case RealTypeKind::UNIT: return std::make_shared<UnitRealType>(ref);
+        case RealTypeKind::NEVER: return std::make_shared<NeverRealType>(ref);
+        case RealTypeKind::BOOL: return std::make_shared<BoolRealType>(ref);
+        case RealTypeKind::I32: return std::make_shared<I32RealType>(ref);
+        case RealTypeKind::ISIZE: return std::make_shared<IsizeRealType>(ref);
+        case RealTypeKind::U32: return std::make_shared<U32RealType>(ref);
+        case RealTypeKind::USIZE: return std::make_shared<UsizeRealType>(ref);
+        case RealTypeKind::ANYINT: return std::make_shared<AnyIntRealType>(ref);
+        case RealTypeKind::CHAR: return std::make_shared<CharRealType>(ref);
+        case RealTypeKind::STR: return std::make_shared<StrRealType>(ref);
+        case RealTypeKind::STRING: return std::make_shared<StringRealType>(ref);
+        default: return nullptr;
+    }
+}
+
+} // namespace
+
+RealType_ptr TypeContext::primitive(RealTypeKind kind, ReferenceType ref) {
+    // 第一次用的时候一次建好，之后只读，多个线程同时用也没问题
+    static const auto table = [] {
+        std::array<std::array<RealType_ptr, REFERENCE_TYPE_COUNT>, REAL_TYPE_KIND_COUNT> result;
+        for (size_t k = 0; k < REAL_TYPE_KIND_COUNT; k++) {
+            for (size_t r = 0; r < REFERENCE_TYPE_COUNT; r++) {
+                result[k][r] = make_primitive(static_cast<RealTypeKind>(k), static_cast<ReferenceType>(r));
+            }
+        }
+        return result;
+    }();
+    RealType_ptr result = table[static_cast<size_t>(kind)][static_cast<size_t>(ref)];
+    if (result == nullptr) {
+        throw string("Error, ") + real_type_kind_to_string(kind) + " is not a primitive type";
+    }
+    return result;
+}
+
+size_t TypeContext::KeyHash::operator()(const Key &key) const {
+    size_t h = std::hash<const void *>()(key.inner);
+    h ^= key.size + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= (static_cast<size_t>(key.kind) << 2 | static_cast<size_t>(key.ref)) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+template <class Make>
+RealType_ptr TypeContext::find_or_make(const Key &key, Make make) {
+    std::lock_guard<std::mutex> lock(mutex);
+    RealType_ptr &result = composite_types[key];
+    if (result == nullptr) {
+        result = make();
+    }
+    return result;
+}
+
+RealType_ptr TypeContext::array(RealType_ptr element_type, size_t size, ReferenceType ref) {
+    element_type = intern(element_type);
+    return find_or_make(Key{RealTypeKind::ARRAY, ref, element_type.get(), size}, [&] {
+        return std::make_shared<ArrayRealType>(element_type, nullptr, ref, size);
+    });
+}
+
+RealType_ptr TypeContext::pending_array(RealType_ptr element_type, Expr_ptr size_expr, ReferenceType ref) {
+    return std::make_shared<ArrayRealType>(element_type, size_expr, ref);
+}
+
+RealType_ptr TypeContext::struct_type(StructDecl_ptr decl, ReferenceType ref) {
+    if (decl == nullptr) {
+        throw string("Error, struct type without StructDecl");
+    }
+    return find_or_make(Key{RealTypeKind::STRUCT, ref, decl.get(), 0}, [&] {
+        return std::make_shared<StructRealType>(decl->name, ref, decl);
+    });
+}
+
+RealType_ptr TypeContext::enum_type(EnumDecl_ptr decl, ReferenceType ref) {
+    if (decl == nullptr) {
+        throw string("Error, enum type without EnumDecl");
+    }
+    return find_or_make(Key{RealTypeKind::ENUM, ref, decl.get(), 0}, [&] {
+        return std::make_shared<EnumRealType>(decl->name, ref, decl);
+    });
+}
+
+RealType_ptr TypeContext::function_type(FnDecl_ptr decl, ReferenceType ref) {
+    return find_or_make(Key{RealTypeKind::FUNCTION, ref, decl.get(), 0}, [&] {
+        return std::make_shared<FunctionRealType>(decl, ref);
+    });
+}
+
+RealType_ptr TypeContext::with_ref(RealType_ptr type, ReferenceType ref) {
+    assert(type != nullptr);
+    switch (type->kind) {
+        case RealTypeKind::ARRAY: {
+            // pending 的数组在 fill_array_sizes 里已经填好了大小
+            auto array_type = std::static_pointer_cast<ArrayRealType>(type);
+            return array(array_type->element_type, array_type->size, ref);
+        }
+        case RealTypeKind::STRUCT:
+            return struct_type(std::static_pointer_cast<StructRealType>(type)->decl.lock(), ref);
+        case RealTypeKind::ENUM:
+            return enum_type(std::static_pointer_cast<EnumRealType>(type)->decl.lock(), ref);
+        case RealTypeKind::FUNCTION:
+            return function_type(std::static_pointer_cast<FunctionRealType>(type)->decl.lock(), ref);
+        default:
+            return primitive(type->kind, ref);
+    }
+}
+
+RealType_ptr find_real_type(Scope_ptr current_scope, Type_ptr type_ast, NodeTable<RealType_ptr> &type_map, vector<Expr_ptr> &const_expr_queue, TypeContext &types) {
+    if (type_map.contains(type_ast->NodeId)) {
         return type_map[type_ast->NodeId];
     }
     RealType_ptr result_type = nullptr;
     ReferenceType ref_type = type_ast->ref_type;
-    if (auto path_type = dynamic_cast<PathType*>(type_ast.get())) {
+    if (auto path_type = dynamic_cast<PathType*>(type_ast)) {
         string name = path_type->name;
-        while (current_scope != nullptr) {
-            if (current_scope->type_namespace.find(name) != current_scope->type_namespace.end()) {
-                TypeDecl_ptr type_decl = current_scope->type_namespace[name];
+        Scope *lookup_scope = current_scope.get();
+        while (lookup_scope != nullptr) {
+            auto it = lookup_scope->type_namespace.find(name);
+            if (it != lookup_scope->type_namespace.end()) {
+                TypeDecl_ptr type_decl = it->second;
                 if (type_decl->kind == TypeDeclKind::Struct) {
                     auto decl = std::dynamic_pointer_cast<StructDecl>(type_decl);
-                    result_type = std::make_shared<StructRealType>(name, ref_type, decl);
+                    result_type = types.struct_type(decl, ref_type);
                     break;
                 } else if (type_decl->kind == TypeDeclKind::Enum) {
                     auto decl = std::dynamic_pointer_cast<EnumDecl>(type_decl);
-                    result_type = std::make_shared<EnumRealType>(name, ref_type, decl);
+                    result_type = types.enum_type(decl, ref_type);
                     break;
                 } else {
                     throw string("CE, type name ") + name + " is not a struct or enum";
                 }
             } else {
-                current_scope = current_scope->parent.lock();
+                lookup_scope = lookup_scope->parent;
             }
         }
         // 内置类型
         if (result_type == nullptr) {
             if (name == "i32") {
-                result_type = std::make_shared<I32RealType>(ref_type);
+                result_type = TypeContext::primitive(RealTypeKind::I32, ref_type);
             } else if (name == "isize") {
-                result_type = std::make_shared<IsizeRealType>(ref_type);
+                result_type = TypeContext::primitive(RealTypeKind::ISIZE, ref_type);
             } else if (name == "u32") {
-                result_type = std::make_shared<U32RealType>(ref_type);
+                result_type = TypeContext::primitive(RealTypeKind::U32, ref_type);
             } else if (name == "usize") {
-                result_type = std::make_shared<UsizeRealType>(ref_type);
+                result_type = TypeContext::primitive(RealTypeKind::USIZE, ref_type);
             } else if (name == "bool") {
-                result_type = std::make_shared<BoolRealType>(ref_type);
+                result_type = TypeContext::primitive(RealTypeKind::BOOL, ref_type);
             } else if (name == "char") {
-                result_type = std::make_shared<CharRealType>(ref_type);
+                result_type = TypeContext::primitive(RealTypeKind::CHAR, ref_type);
             } else if (name == "str") {
-                result_type = std::make_shared<StrRealType>(ref_type);
+                result_type = TypeContext::primitive(RealTypeKind::STR, ref_type);
             } else if (name == "String") {
-                result_type = std::make_shared<StringRealType>(ref_type);
+                result_type = TypeContext::primitive(RealTypeKind::STRING, ref_type);
             } else {
                 throw string("CE, type name ") + name + " not found";
             }
         }
-    } else if (auto array_type = dynamic_cast<ArrayType*>(type_ast.get())) {
-        RealType_ptr element_type = find_real_type(current_scope, array_type->element_type, type_map, const_expr_queue);
-        auto result_array_type = std::make_shared<ArrayRealType>(element_type, array_type->size_expr, ref_type);
-        result_type = result_array_type;
+    } else if (auto array_type = dynamic_cast<ArrayType*>(type_ast)) {
+        RealType_ptr element_type = find_real_type(current_scope, array_type->element_type, type_map, const_expr_queue, types);
+        result_type = types.pending_array(element_type, array_type->size_expr, ref_type);
         // 数组大小的表达式放入 const_expr_queue
         const_expr_queue.push_back(array_type->size_expr);
-    } else if (dynamic_cast<UnitType*>(type_ast.get())) {
-        result_type = std::make_shared<UnitRealType>(ref_type);
+    } else if (dynamic_cast<UnitType*>(type_ast)) {
+        result_type = TypeContext::primitive(RealTypeKind::UNIT, ref_type);
     } else {
-        assert(dynamic_cast<SelfType*>(type_ast.get()) != nullptr);
+        assert(dynamic_cast<SelfType*>(type_ast) != nullptr);
         // SelfType，一定在 Impl 里面
-        auto impl_scope = current_scope;
+        Scope *impl_scope = current_scope.get();
         while(impl_scope != nullptr && impl_scope->kind != ScopeKind::Impl) {
-            impl_scope = impl_scope->parent.lock();
+            impl_scope = impl_scope->parent;
         }
         if (impl_scope == nullptr) {
             throw string("CE, self type used outside of impl");
@@ -145,7 +260,7 @@ RealType_ptr find_real_type(Scope_ptr current_scope, Type_ptr type_ast, map<size
     return type_map[type_ast->NodeId] = result_type;
 }
 
-void Scope_dfs_and_build_type(Scope_ptr scope, map<size_t, RealType_ptr> &type_map, vector<Expr_ptr> &const_expr_queue) {
+void Scope_dfs_and_build_type(Scope_ptr scope, NodeTable<RealType_ptr> &type_map, vector<Expr_ptr> &const_expr_queue, TypeContext &types) {
     // 如果是 impl，先找到 impl_struct 对应的 StructDecl
     StructDecl_ptr impl_struct_decl = nullptr;
     if (scope->kind == ScopeKind::Impl) {
@@ -156,10 +271,11 @@ void Scope_dfs_and_build_type(Scope_ptr scope, map<size_t, RealType_ptr> &type_m
         将这里面的 fn 和 const 加入到 impl_struct 的 StructDecl 里面
         */
         // 先找到 impl_struct 对应的 StructDecl
-        Scope_ptr current_scope = scope;
+        Scope *current_scope = scope.get();
         while (current_scope != nullptr) {
-            if (current_scope->type_namespace.find(scope->impl_struct) != current_scope->type_namespace.end()) {
-                TypeDecl_ptr type_decl = current_scope->type_namespace[scope->impl_struct];
+            auto it = current_scope->type_namespace.find(scope->impl_struct);
+            if (it != current_scope->type_namespace.end()) {
+                TypeDecl_ptr type_decl = it->second;
                 if (type_decl->kind == TypeDeclKind::Struct) {
                     impl_struct_decl = std::dynamic_pointer_cast<StructDecl>(type_decl);
                     break;
@@ -167,13 +283,13 @@ void Scope_dfs_and_build_type(Scope_ptr scope, map<size_t, RealType_ptr> &type_m
                     throw string("CE, impl struct name ") + scope->impl_struct + " is not a struct";
                 }
             } else {
-                current_scope = current_scope->parent.lock();
+                current_scope = current_scope->parent;
             }
         }
         if (impl_struct_decl == nullptr) {
             throw string("CE, impl struct name ") + scope->impl_struct + " not found";
         }
-        scope->self_struct = std::make_shared<StructRealType>(scope->impl_struct, ReferenceType::NO_REF, impl_struct_decl);
+        scope->self_struct = types.struct_type(impl_struct_decl);
     }
     
     for (auto [name, type_decl] : scope->type_namespace) {
@@ -184,7 +300,7 @@ void Scope_dfs_and_build_type(Scope_ptr scope, map<size_t, RealType_ptr> &type_m
                 if (struct_decl->fields.find(field_name) != struct_decl->fields.end()) {
                     throw string("CE, field name ") + field_name + " redefined in struct " + struct_decl->ast_node->struct_name;
                 }
-                RealType_ptr field_type = find_real_type(scope, field_type_ast, type_map, const_expr_queue);
+                RealType_ptr field_type = find_real_type(scope, field_type_ast, type_map, const_expr_queue, types);
                 struct_decl->fields[field_name] = field_type;
             }
         }
@@ -205,21 +321,21 @@ void Scope_dfs_and_build_type(Scope_ptr scope, map<size_t, RealType_ptr> &type_m
             auto fn_decl = std::dynamic_pointer_cast<FnDecl>(value_decl);
             // 解析 parameters
             for (auto [param_pattern, param_type_ast] : fn_decl->ast_node->parameters) {
-                RealType_ptr param_type = find_real_type(scope, param_type_ast, type_map, const_expr_queue);
+                RealType_ptr param_type = find_real_type(scope, param_type_ast, type_map, const_expr_queue, types);
                 fn_decl->parameters.push_back({param_pattern, param_type});
             }
             // 解析 return type
             if (fn_decl->ast_node->return_type != nullptr) {
-                RealType_ptr return_type = find_real_type(scope, fn_decl->ast_node->return_type, type_map, const_expr_queue);
+                RealType_ptr return_type = find_real_type(scope, fn_decl->ast_node->return_type, type_map, const_expr_queue, types);
                 fn_decl->return_type = return_type;
             } else {
                 // 没有返回类型，默认为 ()
-                fn_decl->return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+                fn_decl->return_type = TypeContext::primitive(RealTypeKind::UNIT);
             }
         } else if (value_decl->kind == ValueDeclKind::Constant) {
             auto const_decl = std::dynamic_pointer_cast<ConstDecl>(value_decl);
             // 解析 const type
-            RealType_ptr const_type = find_real_type(scope, const_decl->ast_node->const_type, type_map, const_expr_queue);
+            RealType_ptr const_type = find_real_type(scope, const_decl->ast_node->const_type, type_map, const_expr_queue, types);
             const_decl->const_type = const_type;
         }
     }
@@ -270,63 +386,29 @@ void Scope_dfs_and_build_type(Scope_ptr scope, map<size_t, RealType_ptr> &type_m
         }
     }
     for (auto &child_scope : scope->children) {
-        Scope_dfs_and_build_type(child_scope, type_map, const_expr_queue);
+        Scope_dfs_and_build_type(child_scope, type_map, const_expr_queue, types);
     }
 }
 
 
-void OtherTypeAndRepeatArrayVisitor::visit(LiteralExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(IdentifierExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(BinaryExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(UnaryExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(CallExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(FieldExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(StructExpr &node) {
-    AST_Walker::visit(node);    
+void OtherTypeAndRepeatArrayVisitor::leave(StructExpr &node) {
     // 解析 node.struct_name
-    find_real_type(node_scope_map[node.struct_name->NodeId], node.struct_name, type_map, const_expr_queue);
-}
-void OtherTypeAndRepeatArrayVisitor::visit(IndexExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(BlockExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(IfExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(WhileExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(LoopExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(ReturnExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(BreakExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(ContinueExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(CastExpr &node) {
+    find_real_type(node_scope_map[node.struct_name->NodeId], node.struct_name, type_map, const_expr_queue, types);
+}
+void OtherTypeAndRepeatArrayVisitor::leave(CastExpr &node) {
     // 将 as 后面的类型解析出来
-    AST_Walker::visit(node);
-    find_real_type(node_scope_map[node.target_type->NodeId], node.target_type, type_map, const_expr_queue);
+    find_real_type(node_scope_map[node.target_type->NodeId], node.target_type, type_map, const_expr_queue, types);
 }
-void OtherTypeAndRepeatArrayVisitor::visit(PathExpr &node) {
-    AST_Walker::visit(node);
+void OtherTypeAndRepeatArrayVisitor::leave(PathExpr &node) {
     // 解析 node.base
-    find_real_type(node_scope_map[node.base->NodeId], node.base, type_map, const_expr_queue);
+    find_real_type(node_scope_map[node.base->NodeId], node.base, type_map, const_expr_queue, types);
 }
-void OtherTypeAndRepeatArrayVisitor::visit(SelfExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(UnitExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(ArrayExpr &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(RepeatArrayExpr &node) {
+void OtherTypeAndRepeatArrayVisitor::enter(RepeatArrayExpr &node) {
     const_expr_queue.push_back(node.size);
-    AST_Walker::visit(node);
-}
-void OtherTypeAndRepeatArrayVisitor::visit(FnItem &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(StructItem &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(EnumItem &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(ImplItem &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(ConstItem &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(LetStmt &node) {
+}
+void OtherTypeAndRepeatArrayVisitor::enter(LetStmt &node) {
     if (node.type != nullptr) {
-        find_real_type(node_scope_map[node.NodeId], node.type, type_map, const_expr_queue);
+        find_real_type(node_scope_map[node.NodeId], node.type, type_map, const_expr_queue, types);
         // 这里不管返回值，因为 type_map 里面已经存了
     }
-    AST_Walker::visit(node);
-}
-void OtherTypeAndRepeatArrayVisitor::visit(ExprStmt &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(ItemStmt &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(PathType &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(ArrayType &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(UnitType &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(SelfType &node) { AST_Walker::visit(node); }
-void OtherTypeAndRepeatArrayVisitor::visit(IdentifierPattern &node) { AST_Walker::visit(node); }
\ No newline at end of file
+}
\ No newline at end of file
@@ -11,61 +11,30 @@
 #include <memory>
 // #include <ostream>
 
-// 只有遇到 ArrayType 的时候，才会用到这个 visitor
-// 其他节点都直接调用 AST_Walker 的 visit 即可
-
-void ArrayTypeVisitor::visit(LiteralExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(IdentifierExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(BinaryExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(UnaryExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(CallExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(FieldExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(StructExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(IndexExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(BlockExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(IfExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(WhileExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(LoopExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(ReturnExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(BreakExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(ContinueExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(CastExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(PathExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(SelfExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(UnitExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(ArrayExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(RepeatArrayExpr &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(FnItem &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(StructItem &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(EnumItem &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(ImplItem &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(ConstItem &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(LetStmt &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(ExprStmt &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(ItemStmt &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(PathType &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(ArrayType &node) {
-    auto target_real_type = type_map[node.NodeId];
-    assert(target_real_type != nullptr);
-    assert(target_real_type->kind == RealTypeKind::ARRAY);
-    auto array_real_type = std::dynamic_pointer_cast<ArrayRealType>(target_real_type);
-    if (!array_real_type) {
-        // 这个时候应该是前面代码写错了，不是 CE，报 Error 的错误
-        throw string("Error, should be array type");
-    }
-    size_t array_size = 0;
-    if (const_expr_to_size_map.find(node.size_expr->NodeId) != const_expr_to_size_map.end()) {
-        array_size = const_expr_to_size_map[node.size_expr->NodeId];
-    } else {
-        // 这个时候应该是前面代码写错了，不是 CE，报 Error 的错误
-        throw string("Error, cannot find array size");
+void ArrayTypeVisitor::fill_array_sizes() {
+    for (ArrayType_ptr node : array_types) {
+        auto target_real_type = type_map[node->NodeId];
+        assert(target_real_type != nullptr);
+        assert(target_real_type->kind == RealTypeKind::ARRAY);
+        auto array_real_type = std::dynamic_pointer_cast<ArrayRealType>(target_real_type);
+        if (!array_real_type) {
+            // 这个时候应该是前面代码写错了，不是 CE，报 Error 的错误
+            throw string("Error, should be array type");
+        }
+        size_t array_size = 0;
+        if (const_expr_to_size_map.contains(node->size_expr->NodeId)) {
+            array_size = const_expr_to_size_map[node->size_expr->NodeId];
+        } else {
+            // 这个时候应该是前面代码写错了，不是 CE，报 Error 的错误
+            throw string("Error, cannot find array size");
+        }
+        array_real_type->size = array_size;
+    }
+    // 数组可以嵌套，所有大小都填好之后才能换成唯一的那个
+    for (ArrayType_ptr node : array_types) {
+        type_map[node->NodeId] = types.intern(type_map[node->NodeId]);
     }
-    array_real_type->size = array_size;
-    AST_Walker::visit(node);
 }
-void ArrayTypeVisitor::visit(UnitType &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(SelfType &node) { AST_Walker::visit(node); }
-void ArrayTypeVisitor::visit(IdentifierPattern &node) { AST_Walker::visit(node); }
 
 bool type_is_number(RealType_ptr checktype) {
     assert(checktype != nullptr);
@@ -81,8 +50,9 @@ bool type_is_number(RealType_ptr checktype) {
 // rust 支持 &mut -> & 的隐式转换
 // 但是赋值的时候要注意只能从 &mut T 赋值给 &T，不能反过来
 // 如果是 赋值操作，则 is_assignment = true
-RealType_ptr type_merge(RealType_ptr left, RealType_ptr right, bool is_assignment) {
+RealType_ptr type_merge(TypeContext &types, RealType_ptr left, RealType_ptr right, bool is_assignment) {
     assert(left != nullptr && right != nullptr);
+    if (left == right) { return left; }
     if (left->kind == RealTypeKind::NEVER) { return right; }
     if (right->kind == RealTypeKind::NEVER) { return left; }
     ReferenceType result_ref;
@@ -105,13 +75,13 @@ RealType_ptr type_merge(RealType_ptr left, RealType_ptr right, bool is_assignmen
             + left->show_real_type_info() + " and " + right->show_real_type_info();
     }
     if (left->kind == RealTypeKind::ANYINT) {
-        if (type_is_number(right)) { result_type = copy(right); }
+        if (type_is_number(right)) { result_type = right; }
         else {
             throw string("CE, cannot merge AnyInt with non-number type\n type info:")
             + left->show_real_type_info() + " and " + right->show_real_type_info();
         }
     } else if (right->kind == RealTypeKind::ANYINT) {
-        if (type_is_number(left)) { result_type = copy(left); }
+        if (type_is_number(left)) { result_type = left; }
         else {
             throw string("CE, cannot merge AnyInt with non-number type\n type info:")
             + left->show_real_type_info() + " and " + right->show_real_type_info();
@@ -123,126 +93,65 @@ RealType_ptr type_merge(RealType_ptr left, RealType_ptr right, bool is_assignmen
                 + left->show_real_type_info() + " and " + right->show_real_type_info();
         }
         if (left->kind == RealTypeKind::ARRAY) {
-            auto left_array = std::dynamic_pointer_cast<ArrayRealType>(left);
-            auto right_array = std::dynamic_pointer_cast<ArrayRealType>(right);
-            assert(left_array != nullptr && right_array != nullptr);
+            auto left_array = std::static_pointer_cast<ArrayRealType>(left);
+            auto right_array = std::static_pointer_cast<ArrayRealType>(right);
             if (left_array->size != right_array->size) {
                 throw string("CE, cannot merge two different array types with size\n type info:")
                 + left->show_real_type_info() + " and " + right->show_real_type_info();
             }
-            auto merged_element_type = type_merge(left_array->element_type, right_array->element_type, is_assignment);
-            result_type = std::make_shared<ArrayRealType>(merged_element_type, nullptr, left->is_ref, left_array->size);
+            auto merged_element_type = type_merge(types, left_array->element_type, right_array->element_type, is_assignment);
+            result_type = types.array(merged_element_type, left_array->size);
         } else {
             if (left->kind == RealTypeKind::STRUCT) {
-                auto left_struct = std::dynamic_pointer_cast<StructRealType>(left);
-                auto right_struct = std::dynamic_pointer_cast<StructRealType>(right);
-                assert(left_struct != nullptr && right_struct != nullptr);
+                auto left_struct = std::static_pointer_cast<StructRealType>(left);
+                auto right_struct = std::static_pointer_cast<StructRealType>(right);
                 if (left_struct->decl.lock() != right_struct->decl.lock()) {
                     throw string("CE, cannot merge two different struct types\n type info:")
                     + left->show_real_type_info() + " and " + right->show_real_type_info();
                 }
             } else if (left->kind == RealTypeKind::ENUM) {
-                auto left_enum = std::dynamic_pointer_cast<EnumRealType>(left);
-                auto right_enum = std::dynamic_pointer_cast<EnumRealType>(right);
-                assert(left_enum != nullptr && right_enum != nullptr);
+                auto left_enum = std::static_pointer_cast<EnumRealType>(left);
+                auto right_enum = std::static_pointer_cast<EnumRealType>(right);
                 if (left_enum->decl.lock() != right_enum->decl.lock()) {
                     throw string("CE, cannot merge two different enum types\n type info:")
                     + left->show_real_type_info() + " and " + right->show_real_type_info();
                 }
             }
-            result_type = copy(left);
+            result_type = left;
         }
     }
-    result_type->is_ref = result_ref;
-    return result_type;
+    return types.with_ref(result_type, result_ref);
 }
 
-RealType_ptr type_of_literal(LiteralType type, string value) {
+RealType_ptr type_of_literal(const LiteralExpr &literal) {
+    LiteralType type = literal.literal_type;
     if (type == LiteralType::STRING) {
         // 类型是 &str
-        return std::make_shared<StrRealType>(ReferenceType::REF);
+        return TypeContext::primitive(RealTypeKind::STR, ReferenceType::REF);
     } else if (type == LiteralType::CHAR) {
-        return std::make_shared<CharRealType>(ReferenceType::NO_REF);
+        return TypeContext::primitive(RealTypeKind::CHAR);
     } else if (type == LiteralType::BOOL) {
-        return std::make_shared<BoolRealType>(ReferenceType::NO_REF);
+        return TypeContext::primitive(RealTypeKind::BOOL);
     } else if (type == LiteralType::NUMBER) {
-        // 看后缀，以及要 check 是否是合法的数字
-        if (value.size() >= 3 && value.substr(value.size() - 3) == "i32") {
-            // i32
-            safe_stoll(value);
-            return std::make_shared<I32RealType>(ReferenceType::NO_REF);
-        } else if (value.size() >= 3 && value.substr(value.size() - 3) == "u32") {
-            // u32
-            safe_stoll(value);
-            return std::make_shared<U32RealType>(ReferenceType::NO_REF);
-        } else if (value.size() >= 5 && value.substr(value.size() - 5) == "isize") {
-            // isize
-            safe_stoll(value);
-            return std::make_shared<IsizeRealType>(ReferenceType::NO_REF);
-        } else if (value.size() >= 5 && value.substr(value.size() - 5) == "usize") {
-            // usize
-            safe_stoll(value);
-            return std::make_shared<UsizeRealType>(ReferenceType::NO_REF);
-        } else {
-            // anyint
-            safe_stoll(value);
-            return std::make_shared<AnyIntRealType>(ReferenceType::NO_REF);
+        // 看后缀，以及要 check 是否是合法的数字（lexer 已经解码好了）
+        integer_literal_value(literal.number, literal.value);
+        switch (literal.number.suffix) {
+            case IntegerSuffix::I32: return TypeContext::primitive(RealTypeKind::I32);
+            case IntegerSuffix::U32: return TypeContext::primitive(RealTypeKind::U32);
+            case IntegerSuffix::ISIZE: return TypeContext::primitive(RealTypeKind::ISIZE);
+            case IntegerSuffix::USIZE: return TypeContext::primitive(RealTypeKind::USIZE);
+            default: return TypeContext::primitive(RealTypeKind::ANYINT);
         }
     } else {
         throw string("Error, unknown literal type");
     }
 }
 
-RealType_ptr copy(RealType_ptr type) {
-    assert(type != nullptr);
-    if (type->kind == RealTypeKind::ARRAY) {
-        auto array_type = std::dynamic_pointer_cast<ArrayRealType>(type);
-        assert(array_type != nullptr);
-        return std::make_shared<ArrayRealType>(copy(array_type->element_type), nullptr, type->is_ref, array_type->size);
-    } else if (type->kind == RealTypeKind::FUNCTION) {
-        auto fn_type = std::dynamic_pointer_cast<FunctionRealType>(type);
-        assert(fn_type != nullptr);
-        return std::make_shared<FunctionRealType>(fn_type->decl.lock(), type->is_ref);
-    } else if (type->kind == RealTypeKind::STRUCT) {
-        auto struct_type = std::dynamic_pointer_cast<StructRealType>(type);
-        assert(struct_type != nullptr);
-        return std::make_shared<StructRealType>(struct_type->name, type->is_ref, struct_type->decl.lock());
-    } else if (type->kind == RealTypeKind::ENUM) {
-        auto enum_type = std::dynamic_pointer_cast<EnumRealType>(type);
-        assert(enum_type != nullptr);
-        return std::make_shared<EnumRealType>(enum_type->name, type->is_ref, enum_type->decl.lock());
-    } else if (type->kind == RealTypeKind::STR) {
-        return std::make_shared<StrRealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::STRING) {
-        return std::make_shared<StringRealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::I32) {
-        return std::make_shared<I32RealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::U32) {
-        return std::make_shared<U32RealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::ISIZE) {
-        return std::make_shared<IsizeRealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::USIZE) {
-        return std::make_shared<UsizeRealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::ANYINT) {
-        return std::make_shared<AnyIntRealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::BOOL) {
-        return std::make_shared<BoolRealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::CHAR) {
-        return std::make_shared<CharRealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::UNIT) {
-        return std::make_shared<UnitRealType>(type->is_ref);
-    } else if (type->kind == RealTypeKind::NEVER) {
-        return std::make_shared<NeverRealType>(type->is_ref);
-    } else {
-        throw string("Error, copy unknown real type");
-    }
-}
-
 void ExprTypeAndLetStmtVisitor::visit(LiteralExpr &node) {
     if (require_function) {
         throw string("CE, literal is not function");
     }
-    auto literal_type = type_of_literal(node.literal_type, node.value);
+    auto literal_type = type_of_literal(node);
     node_type_and_place_kind_map[node.NodeId] = {literal_type, PlaceKind::NotPlace};
 }
 void ExprTypeAndLetStmtVisitor::visit(IdentifierExpr &node) {
@@ -258,7 +167,7 @@ void ExprTypeAndLetStmtVisitor::visit(IdentifierExpr &node) {
         if (decl->kind == ValueDeclKind::Function) {
             auto fn_decl = std::dynamic_pointer_cast<FnDecl>(decl);
             assert(fn_decl != nullptr);
-            result_type = std::make_shared<FunctionRealType>(fn_decl, ReferenceType::NO_REF);
+            result_type = types.function_type(fn_decl);
         }
         else {
             throw string("CE, identifier is not function: ") + node.name;
@@ -306,7 +215,7 @@ void ExprTypeAndLetStmtVisitor::visit(BinaryExpr &node) {
         case Binary_Operator::DIV:
         case Binary_Operator::MOD: {
             if (type_is_number(left_type) && type_is_number(right_type)) {
-                result_type = type_merge(left_type, right_type);
+                result_type = type_merge(types, left_type, right_type);
             } else {
                 throw string("CE, binary operator ") + binary_operator_to_string(node.op) + " requires number types";
             }
@@ -318,7 +227,7 @@ void ExprTypeAndLetStmtVisitor::visit(BinaryExpr &node) {
         case Binary_Operator::XOR: {
             if ((type_is_number(left_type) || left_type->kind == RealTypeKind::BOOL) &&
                 (type_is_number(right_type) || right_type->kind == RealTypeKind::BOOL)) {
-                result_type = type_merge(left_type, right_type);
+                result_type = type_merge(types, left_type, right_type);
             } else {
                 throw string("CE, binary operator ") + binary_operator_to_string(node.op) + " requires number or bool types";
             }
@@ -329,7 +238,7 @@ void ExprTypeAndLetStmtVisitor::visit(BinaryExpr &node) {
         case Binary_Operator::OR_OR: {
             if (left_type->kind == RealTypeKind::BOOL &&
                 right_type->kind == RealTypeKind::BOOL) {
-                result_type = type_merge(left_type, right_type);
+                result_type = type_merge(types, left_type, right_type);
             } else {
                 throw string("CE, binary operator ") + binary_operator_to_string(node.op) + " requires bool types";
             }
@@ -344,8 +253,8 @@ void ExprTypeAndLetStmtVisitor::visit(BinaryExpr &node) {
             // 必须要类型相同
             // 不确定一些奇怪的类型支不支持比较（比如 struct）
             // 先假设支持
-            if (type_merge(left_type, right_type) != nullptr) {
-                result_type = std::make_shared<BoolRealType>(ReferenceType::NO_REF);
+            if (type_merge(types, left_type, right_type) != nullptr) {
+                result_type = TypeContext::primitive(RealTypeKind::BOOL);
             } else {
                 throw string("CE, binary operator ") + binary_operator_to_string(node.op) + " requires two same types";
             }
@@ -366,8 +275,8 @@ void ExprTypeAndLetStmtVisitor::visit(BinaryExpr &node) {
                 throw string("CE, left side of assignment must be a mutable place");
             }
             // 如果类型不同，type_merge 的时候就直接会报错
-            type_merge(left_type, right_type, true);
-            result_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+            type_merge(types, left_type, right_type, true);
+            result_type = TypeContext::primitive(RealTypeKind::UNIT);
             break;
         }
         case Binary_Operator::ADD_ASSIGN:
@@ -380,8 +289,8 @@ void ExprTypeAndLetStmtVisitor::visit(BinaryExpr &node) {
             }
             if (type_is_number(left_type) && type_is_number(right_type)) {
                 // 如果类型不同，type_merge 的时候就直接会报错
-                type_merge(left_type, right_type, true);
-                result_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+                type_merge(types, left_type, right_type, true);
+                result_type = TypeContext::primitive(RealTypeKind::UNIT);
             } else {
                 throw string("CE, binary operator ") + binary_operator_to_string(node.op) + " requires number types";
             }
@@ -396,8 +305,8 @@ void ExprTypeAndLetStmtVisitor::visit(BinaryExpr &node) {
             if ((type_is_number(left_type) || left_type->kind == RealTypeKind::BOOL) &&
                 (type_is_number(right_type) || right_type->kind == RealTypeKind::BOOL)) {
                 // 如果类型不同，type_merge 的时候就直接会报错
-                type_merge(left_type, right_type, true);
-                result_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+                type_merge(types, left_type, right_type, true);
+                result_type = TypeContext::primitive(RealTypeKind::UNIT);
             } else {
                 throw string("CE, binary operator ") + binary_operator_to_string(node.op) + " requires number or bool types";
             }
@@ -409,7 +318,7 @@ void ExprTypeAndLetStmtVisitor::visit(BinaryExpr &node) {
                 throw string("CE, left side of assignment must be a mutable place");
             }
             if (type_is_number(left_type) && type_is_number(right_type)) {
-                result_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+                result_type = TypeContext::primitive(RealTypeKind::UNIT);
             } else {
                 throw string("CE, binary operator ") + binary_operator_to_string(node.op) + " requires number types";
             }
@@ -460,10 +369,7 @@ void ExprTypeAndLetStmtVisitor::visit(UnaryExpr &node) {
         if (right_type->is_ref != ReferenceType::NO_REF) {
             throw string("CE, cannot take reference of a reference type");
         }
-        // 由于会修改，所以就深拷贝一下吧
-        // 前面的地方直接赋值，没关系的
-        result_type = copy(right_type);
-        result_type->is_ref = ReferenceType::REF;
+        result_type = types.with_ref(right_type, ReferenceType::REF);
         place_kind = PlaceKind::NotPlace;
     } else if (node.op == Unary_Operator::REF_MUT) {
         // 右值和 mut 的左值都可以被 &mut 引用
@@ -474,15 +380,13 @@ void ExprTypeAndLetStmtVisitor::visit(UnaryExpr &node) {
         if (right_type->is_ref != ReferenceType::NO_REF) {
             throw string("CE, cannot take reference of a reference type");
         }
-        result_type = copy(right_type);
-        result_type->is_ref = ReferenceType::REF_MUT;
+        result_type = types.with_ref(right_type, ReferenceType::REF_MUT);
         place_kind = PlaceKind::NotPlace;
     } else if (node.op == Unary_Operator::DEREF) {
         if (right_type->is_ref == ReferenceType::NO_REF) {
             throw string("CE, unary operator * requires a reference type operand");
         }
-        result_type = copy(right_type);
-        result_type->is_ref = ReferenceType::NO_REF;
+        result_type = types.with_ref(right_type, ReferenceType::NO_REF);
         if (right_type->is_ref == ReferenceType::REF) {
             place_kind = PlaceKind::ReadOnlyPlace;
         } else {
@@ -500,7 +404,7 @@ void ExprTypeAndLetStmtVisitor::visit(CallExpr &node) {
         throw string("CE, call expression is not function");
     }
     require_function = true;
-    node.callee->accept(*this);
+    dispatch(node.callee);
     require_function = false;
     vector<pair<RealType_ptr, PlaceKind>> arg_types;
     auto [callee_type, callee_place] = node_type_and_place_kind_map[node.callee->NodeId];
@@ -508,7 +412,7 @@ void ExprTypeAndLetStmtVisitor::visit(CallExpr &node) {
         throw string("CE, call expression requires a function type callee");
     }
     for (auto &arg : node.arguments) {
-        arg->accept(*this);
+        dispatch(arg);
         arg_types.push_back(node_type_and_place_kind_map[arg->NodeId]);
     }
     auto fn_type = std::dynamic_pointer_cast<FunctionRealType>(callee_type);
@@ -543,7 +447,7 @@ void ExprTypeAndLetStmtVisitor::visit(FieldExpr &node) {
     if (require_function) {
         // 这个时候是返回一个结构体内的一个函数
         require_function = false;
-        node.base->accept(*this);
+        dispatch(node.base);
         auto [base_type, base_place] = node_type_and_place_kind_map[node.base->NodeId];
         auto func = get_method_func(base_type, base_place, node.field_name);
         if (func == nullptr) {
@@ -553,7 +457,7 @@ void ExprTypeAndLetStmtVisitor::visit(FieldExpr &node) {
             {func, PlaceKind::NotPlace};
     } else {
         // 这个时候是返回一个结构体内的一个字段
-        node.base->accept(*this);
+        dispatch(node.base);
         auto [base_type, base_place] = node_type_and_place_kind_map[node.base->NodeId];
         // base_type 必须是 struct 类型
         if (base_type->kind != RealTypeKind::STRUCT) {
@@ -608,17 +512,17 @@ void ExprTypeAndLetStmtVisitor::visit(StructExpr &node) {
         if (struct_decl->fields.find(fname) == struct_decl->fields.end()) {
             throw string("CE, struct ") + struct_type->name + " has no field named " + fname;
         }
-        type_merge(struct_decl->fields[fname], node_type_and_place_kind_map[fexpr->NodeId].first, true);
+        type_merge(types, struct_decl->fields[fname], node_type_and_place_kind_map[fexpr->NodeId].first, true);
     }
     node_type_and_place_kind_map[node.NodeId] =
-        {std::make_shared<StructRealType>(struct_type->name, ReferenceType::NO_REF, struct_decl), PlaceKind::NotPlace};
+        {types.struct_type(struct_decl), PlaceKind::NotPlace};
 }
 void ExprTypeAndLetStmtVisitor::visit(IndexExpr &node) {
     if (require_function) {
         throw string("CE, index expression is not function");
     }
-    node.base->accept(*this);
-    node.index->accept(*this);
+    dispatch(node.base);
+    dispatch(node.index);
     auto [base_type, base_place] = node_type_and_place_kind_map[node.base->NodeId];
     auto [index_type, index_place] = node_type_and_place_kind_map[node.index->NodeId];
     if (index_type->is_ref != ReferenceType::NO_REF ||
@@ -630,9 +534,9 @@ void ExprTypeAndLetStmtVisitor::visit(IndexExpr &node) {
     }
     // 特判：如果 index 是 LiteralExpr，检查是否越界
     if (auto index_literal = 
-        std::dynamic_pointer_cast<LiteralExpr>(node.index)) {
+        dynamic_cast<LiteralExpr *>(node.index)) {
         if (index_literal->literal_type == LiteralType::NUMBER) {
-            size_t index_value = safe_stoll(index_literal->value);
+            size_t index_value = integer_literal_value(index_literal->number, index_literal->value);
             auto array_type =
                 std::dynamic_pointer_cast<ArrayRealType>(base_type);
             if (index_value >= array_type->size) {
@@ -668,25 +572,25 @@ void ExprTypeAndLetStmtVisitor::visit(BlockExpr &node) {
         if (now_scope->is_main_scope && now_scope->has_exit) {
             throw string("CE, unreachable statement after exit in main function");
         }
-        stmt->accept(*this);
+        dispatch(stmt);
     }
     if (node.tail_statement != nullptr) {
         if (now_scope->is_main_scope && now_scope->has_exit) {
             throw string("CE, unreachable statement after exit in main function");
         }
-        node.tail_statement->accept(*this);
+        dispatch(node.tail_statement);
     }
     if (now_scope->is_main_scope && !now_scope->has_exit) {
         throw string("CE, main function must have an exit call");
     }
     RealType_ptr result_type;
     if (!has_state(node_outcome_state_map[node.NodeId], OutcomeType::NEXT)) {
-        result_type = std::make_shared<NeverRealType>(ReferenceType::NO_REF);
+        result_type = TypeContext::primitive(RealTypeKind::NEVER);
     } else if (node.tail_statement != nullptr) {
         auto [tail_type, tail_place] = node_type_and_place_kind_map[node.tail_statement->NodeId];
         result_type = tail_type;
     } else {
-        result_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        result_type = TypeContext::primitive(RealTypeKind::UNIT);
     }
     if (node.must_return_unit && result_type->kind != RealTypeKind::UNIT && result_type->kind != RealTypeKind::NEVER) {
         throw string("CE, block expression must return unit type");
@@ -701,7 +605,7 @@ void ExprTypeAndLetStmtVisitor::visit(IfExpr &node) {
     AST_Walker::visit(node);
     if (!has_state(node_outcome_state_map[node.NodeId], OutcomeType::NEXT)) {
         node_type_and_place_kind_map[node.NodeId] =
-            {std::make_shared<NeverRealType>(ReferenceType::NO_REF), PlaceKind::NotPlace};
+            {TypeContext::primitive(RealTypeKind::NEVER), PlaceKind::NotPlace};
         return;
     }
     auto [cond_type, cond_place] = node_type_and_place_kind_map[node.condition->NodeId];
@@ -709,12 +613,12 @@ void ExprTypeAndLetStmtVisitor::visit(IfExpr &node) {
         throw string("CE, if expression requires bool type condition");
     }
     RealType_ptr then_type = node_type_and_place_kind_map[node.then_branch->NodeId].first;
-    RealType_ptr else_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+    RealType_ptr else_type = TypeContext::primitive(RealTypeKind::UNIT);
     if (node.else_branch != nullptr) {
         else_type = node_type_and_place_kind_map[node.else_branch->NodeId].first;
     }
     node_type_and_place_kind_map[node.NodeId] =
-        {type_merge(then_type, else_type), PlaceKind::NotPlace};
+        {type_merge(types, then_type, else_type), PlaceKind::NotPlace};
 }
 void ExprTypeAndLetStmtVisitor::visit(WhileExpr &node) {
     if (require_function) {
@@ -723,7 +627,7 @@ void ExprTypeAndLetStmtVisitor::visit(WhileExpr &node) {
     // 放一个 UnitType 在栈里，表示 while 的结果类型
     // 这样 break 的时候，一定得是 Unit Type，否则就不能合并
     // 最后结果一定是 Unit Type
-    loop_type_stack.push_back(std::make_shared<UnitRealType>(ReferenceType::NO_REF));
+    loop_type_stack.push_back(TypeContext::primitive(RealTypeKind::UNIT));
     AST_Walker::visit(node);
     auto [cond_type, cond_place] = node_type_and_place_kind_map[node.condition->NodeId];
     if (cond_type->is_ref != ReferenceType::NO_REF || cond_type->kind != RealTypeKind::BOOL) {
@@ -739,7 +643,7 @@ void ExprTypeAndLetStmtVisitor::visit(LoopExpr &node) {
     }
     // 放一个 NeverType 在栈里，表示 loop 的结果类型
     // break 有任何 type 都可以和他合并
-    loop_type_stack.push_back(std::make_shared<NeverRealType>(ReferenceType::NO_REF));
+    loop_type_stack.push_back(TypeContext::primitive(RealTypeKind::NEVER));
     AST_Walker::visit(node);
     node_type_and_place_kind_map[node.NodeId] =
         {loop_type_stack.back(), PlaceKind::NotPlace};
@@ -758,11 +662,11 @@ void ExprTypeAndLetStmtVisitor::visit(ReturnExpr &node) {
         auto [value_type, value_place] = node_type_and_place_kind_map[node.return_value->NodeId];
         return_type = value_type;
     } else {
-        return_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        return_type = TypeContext::primitive(RealTypeKind::UNIT);
     }
-    type_merge(now_func_decl->return_type, return_type);
+    type_merge(types, now_func_decl->return_type, return_type);
     node_type_and_place_kind_map[node.NodeId] =
-        {std::make_shared<NeverRealType>(ReferenceType::NO_REF), PlaceKind::NotPlace};
+        {TypeContext::primitive(RealTypeKind::NEVER), PlaceKind::NotPlace};
 }
 void ExprTypeAndLetStmtVisitor::visit(BreakExpr &node) {
     if (require_function) {
@@ -777,11 +681,11 @@ void ExprTypeAndLetStmtVisitor::visit(BreakExpr &node) {
         auto [value_type, value_place] = node_type_and_place_kind_map[node.break_value->NodeId];
         break_type = value_type;
     } else {
-        break_type = std::make_shared<UnitRealType>(ReferenceType::NO_REF);
+        break_type = TypeContext::primitive(RealTypeKind::UNIT);
     }
-    loop_type_stack.back() = type_merge(loop_type_stack.back(), break_type);
+    loop_type_stack.back() = type_merge(types, loop_type_stack.back(), break_type);
     node_type_and_place_kind_map[node.NodeId] =
-        {std::make_shared<NeverRealType>(ReferenceType::NO_REF), PlaceKind::NotPlace};
+        {TypeContext::primitive(RealTypeKind::NEVER), PlaceKind::NotPlace};
 }
 void ExprTypeAndLetStmtVisitor::visit(ContinueExpr &node) {
     if (require_function) {
@@ -792,13 +696,13 @@ void ExprTypeAndLetStmtVisitor::visit(ContinueExpr &node) {
     }
     AST_Walker::visit(node);
     node_type_and_place_kind_map[node.NodeId] =
-        {std::make_shared<NeverRealType>(ReferenceType::NO_REF), PlaceKind::NotPlace};
+        {TypeContext::primitive(RealTypeKind::NEVER), PlaceKind::NotPlace};
 }
 void ExprTypeAndLetStmtVisitor::visit(CastExpr &node) {
     if (require_function) {
         throw string("CE, cast expression is not function");
     }
-    node.expr->accept(*this);
+    dispatch(node.expr);
     // target_type 已经在前面被求出来过了
     auto target_type = type_map[node.target_type->NodeId];
     assert(target_type != nullptr);
@@ -856,13 +760,13 @@ void ExprTypeAndLetStmtVisitor::visit(SelfExpr &node) {
         // Struct 的 name：无所谓了，就当作 Self 吧
         // PlaceKind ：暂时应该是 ReadWritePlace，不是特别确定
         node_type_and_place_kind_map[node.NodeId] =
-            {std::make_shared<StructRealType>("Self", ReferenceType::NO_REF, now_func_decl->self_struct.lock()), PlaceKind::ReadWritePlace};
+            {types.struct_type(now_func_decl->self_struct.lock(), ReferenceType::NO_REF), PlaceKind::ReadWritePlace};
     } else if (now_func_decl->receiver_type == fn_reciever_type::SELF_REF) {
         node_type_and_place_kind_map[node.NodeId] =
-            {std::make_shared<StructRealType>("Self", ReferenceType::REF, now_func_decl->self_struct.lock()), PlaceKind::NotPlace};
+            {types.struct_type(now_func_decl->self_struct.lock(), ReferenceType::REF), PlaceKind::NotPlace};
     } else if (now_func_decl->receiver_type == fn_reciever_type::SELF_REF_MUT) {
         node_type_and_place_kind_map[node.NodeId] =
-            {std::make_shared<StructRealType>("Self", ReferenceType::REF_MUT, now_func_decl->self_struct.lock()), PlaceKind::NotPlace};
+            {types.struct_type(now_func_decl->self_struct.lock(), ReferenceType::REF_MUT), PlaceKind::NotPlace};
     } else {
         throw string("Error, unknown self receiver type");
     }
@@ -872,7 +776,7 @@ void ExprTypeAndLetStmtVisitor::visit(UnitExpr &node) {
         throw string("CE, unit expression is not function");
     }
     node_type_and_place_kind_map[node.NodeId] =
-        {std::make_shared<UnitRealType>(ReferenceType::NO_REF), PlaceKind::NotPlace};
+        {TypeContext::primitive(RealTypeKind::UNIT), PlaceKind::NotPlace};
 }
 void ExprTypeAndLetStmtVisitor::visit(ArrayExpr &node) {
     if (require_function) {
@@ -880,23 +784,23 @@ void ExprTypeAndLetStmtVisitor::visit(ArrayExpr &node) {
     }
     AST_Walker::visit(node);
     // 因为 never 和任何的都可以合并，所以一开始就放一个 never
-    RealType_ptr element_type = std::make_shared<NeverRealType>(ReferenceType::NO_REF);
+    RealType_ptr element_type = TypeContext::primitive(RealTypeKind::NEVER);
     for (auto &elem : node.elements) {
         auto [etype, eplace] = node_type_and_place_kind_map[elem->NodeId];
-        element_type = type_merge(element_type, etype);
+        element_type = type_merge(types, element_type, etype);
     }
     node_type_and_place_kind_map[node.NodeId] =
-        {std::make_shared<ArrayRealType>(element_type, nullptr, ReferenceType::NO_REF, node.elements.size()), PlaceKind::NotPlace};
+        {types.array(element_type, node.elements.size()), PlaceKind::NotPlace};
 }
 void ExprTypeAndLetStmtVisitor::visit(RepeatArrayExpr &node) {
     if (require_function) {
         throw string("CE, repeat array expression is not function");
     }
-    node.element->accept(*this);
+    dispatch(node.element);
     auto [elem_type, elem_place] = node_type_and_place_kind_map[node.element->NodeId];
     size_t size = const_expr_to_size_map[node.size->NodeId];
     node_type_and_place_kind_map[node.NodeId] =
-        {std::make_shared<ArrayRealType>(elem_type, nullptr, ReferenceType::NO_REF, size), PlaceKind::NotPlace};
+        {types.array(elem_type, size), PlaceKind::NotPlace};
 }
 
 void ExprTypeAndLetStmtVisitor::visit(FnItem &node) {
@@ -920,13 +824,13 @@ void ExprTypeAndLetStmtVisitor::visit(FnItem &node) {
             intro_let_stmt(now_func_decl->function_scope.lock(), pattern, type);
         now_func_decl->parameter_let_decls.push_back(let_decl);
     }
-    node.body->accept(*this);
+    dispatch(node.body);
     /*
     检查返回类型：首先，return 的类型在 return 会判断
     所以就是 body 的类型和 return type 合并
     如果 body 是 never 在前面应该就会判断
     */
-    type_merge(node_type_and_place_kind_map[node.body->NodeId].first, now_func_decl->return_type);
+    type_merge(types, node_type_and_place_kind_map[node.body->NodeId].first, now_func_decl->return_type);
     now_func_decl = prev_func_decl;
 }
 void ExprTypeAndLetStmtVisitor::visit([[maybe_unused]]StructItem &node) {
@@ -964,7 +868,7 @@ void ExprTypeAndLetStmtVisitor::visit(LetStmt &node) {
     if (node.initializer == nullptr) {
         throw string("CE, let statement must have an initializer");
     }
-    node.initializer->accept(*this);
+    dispatch(node.initializer);
     auto [init_type, init_place] = node_type_and_place_kind_map[node.initializer->NodeId];
     check_let_stmt(node.pattern, type_map[node.type->NodeId], init_type, init_place, node.initializer);
     auto let_decl =
@@ -976,9 +880,6 @@ void ExprTypeAndLetStmtVisitor::visit(ExprStmt &node) {
     node_type_and_place_kind_map[node.NodeId] =
         node_type_and_place_kind_map[node.expr->NodeId];
 }
-void ExprTypeAndLetStmtVisitor::visit(ItemStmt &node) {
-    AST_Walker::visit(node);
-}
 void ExprTypeAndLetStmtVisitor::visit([[maybe_unused]]PathType &node) { return; }
 void ExprTypeAndLetStmtVisitor::visit([[maybe_unused]]ArrayType &node) { return; }
 void ExprTypeAndLetStmtVisitor::visit([[maybe_unused]]UnitType &node) { return; }
@@ -986,16 +887,8 @@ void ExprTypeAndLetStmtVisitor::visit([[maybe_unused]]SelfType &node) { return;
 void ExprTypeAndLetStmtVisitor::visit([[maybe_unused]]IdentifierPattern &node) { return; }
 
 ValueDecl_ptr ExprTypeAndLetStmtVisitor::find_value_decl(Scope_ptr now_scope, const string &name) {
-    while (now_scope != nullptr) {
-        if (scope_local_variable_map[now_scope].find(name) != scope_local_variable_map[now_scope].end()) {
-            return scope_local_variable_map[now_scope][name];
-        }
-        if (now_scope->value_namespace.find(name) != now_scope->value_namespace.end()) {
-            return now_scope->value_namespace[name];
-        }
-        now_scope = now_scope->parent.lock();
-    }
-    return nullptr;
+    symbol_table.enter(now_scope.get());
+    return symbol_table.lookup(symbols.find(name));
 }
 
 // expr_place 好像没啥用
@@ -1003,11 +896,11 @@ ValueDecl_ptr ExprTypeAndLetStmtVisitor::find_value_decl(Scope_ptr now_scope, co
 // 先打个 maybe_unused 再说
 void ExprTypeAndLetStmtVisitor::check_let_stmt(Pattern_ptr let_pattern, RealType_ptr target_type, RealType_ptr expr_type, [[maybe_unused]]PlaceKind expr_place, Expr_ptr initializer) {
     // 如果 initializer 是 LiteralExpr，检查是否越界
-    if (auto literal_expr = std::dynamic_pointer_cast<LiteralExpr>(initializer)) {
-        auto literal_type = type_of_literal(literal_expr->literal_type, literal_expr->value);
+    if (auto literal_expr = dynamic_cast<LiteralExpr *>(initializer)) {
+        auto literal_type = type_of_literal(*literal_expr);
         // 只需要考虑是 anyint 的情况，其他情况早已被检查掉了
         if (literal_type->kind == RealTypeKind::ANYINT) {
-            long long literal_value = safe_stoll(literal_expr->value);
+            long long literal_value = literal_expr->number.value;
             if (target_type->kind == RealTypeKind::USIZE ||
                 target_type->kind == RealTypeKind::U32) {
                 if (literal_value > static_cast<long long>(UINT32_MAX)) {
@@ -1024,22 +917,21 @@ void ExprTypeAndLetStmtVisitor::check_let_stmt(Pattern_ptr let_pattern, RealType
         }
     }
     // Pattern 目前只有 IdentifierPattern
-    auto ident_pattern = std::dynamic_pointer_cast<IdentifierPattern>(let_pattern);
+    auto ident_pattern = dynamic_cast<IdentifierPattern *>(let_pattern);
     // 考虑：let x, let mut x, let &mut x, let &x
     if (ident_pattern->is_mut == Mutibility::IMMUTABLE && ident_pattern->is_ref == ReferenceType::NO_REF) {
         // let x
-        type_merge(target_type, expr_type, true);
+        type_merge(types, target_type, expr_type, true);
     } else if (ident_pattern->is_mut == Mutibility::MUTABLE && ident_pattern->is_ref == ReferenceType::NO_REF) {
         // let mut x
-        type_merge(target_type, expr_type, true);
+        type_merge(types, target_type, expr_type, true);
     } else if (ident_pattern->is_mut == Mutibility::IMMUTABLE && ident_pattern->is_ref == ReferenceType::REF) {
         // let &x
         if (expr_type->is_ref == ReferenceType::NO_REF) {
             throw string("CE, let & requires a reference type initializer");
         }
-        auto real_type = copy(expr_type);
-        real_type->is_ref = ReferenceType::NO_REF;
-        type_merge(target_type, real_type, true);
+        auto real_type = types.with_ref(expr_type, ReferenceType::NO_REF);
+        type_merge(types, target_type, real_type, true);
     } else if (ident_pattern->is_mut == Mutibility::MUTABLE && ident_pattern->is_ref == ReferenceType::REF) {
         // let &mut x
         if (expr_type->is_ref != ReferenceType::REF_MUT) {
@@ -1048,9 +940,8 @@ void ExprTypeAndLetStmtVisitor::check_let_stmt(Pattern_ptr let_pattern, RealType
         if (expr_type->is_ref == ReferenceType::NO_REF) {
             throw string("CE, let & requires a reference type initializer");
         }
-        auto real_type = copy(expr_type);
-        real_type->is_ref = ReferenceType::NO_REF;
-        type_merge(target_type, real_type, true);
+        auto real_type = types.with_ref(expr_type, ReferenceType::NO_REF);
+        type_merge(types, target_type, real_type, true);
     } else {
         throw string("Error, unknown pattern mutibility and reference type");
     }
@@ -1058,15 +949,11 @@ void ExprTypeAndLetStmtVisitor::check_let_stmt(Pattern_ptr let_pattern, RealType
 
 LetDecl_ptr ExprTypeAndLetStmtVisitor::intro_let_stmt(Scope_ptr current_scope, Pattern_ptr let_pattern, RealType_ptr let_type) {
     // Pattern 目前只有 IdentifierPattern
-    auto ident_pattern = std::dynamic_pointer_cast<IdentifierPattern>(let_pattern);
+    auto ident_pattern = dynamic_cast<IdentifierPattern *>(let_pattern);
     // 只要考虑是否 mut
-    if (ident_pattern->is_mut == Mutibility::MUTABLE) {
-        auto let_decl = std::make_shared<LetDecl>(ident_pattern->name, let_type, Mutibility::MUTABLE);
-        scope_local_variable_map[current_scope][ident_pattern->name] = let_decl;
-        return let_decl;
-    }
-    auto let_decl = std::make_shared<LetDecl>(ident_pattern->name, let_type, Mutibility::IMMUTABLE);
-    scope_local_variable_map[current_scope][ident_pattern->name] = let_decl;
+    auto let_decl = std::make_shared<LetDecl>(ident_pattern->name, let_type, ident_pattern->is_mut);
+    symbol_table.enter(current_scope.get());
+    symbol_table.bind(symbols.intern(ident_pattern->name), let_decl);
     return let_decl;
 }
 
@@ -1123,26 +1010,14 @@ void ExprTypeAndLetStmtVisitor::check_cast(RealType_ptr expr_type, RealType_ptr
     }
     // 其他情况必须全部相同了
     // 直接用 type_merge 检查
-    type_merge(expr_type, target_type);
+    type_merge(types, expr_type, target_type);
 }
 
 // 需要考虑 RecieverType
 RealType_ptr ExprTypeAndLetStmtVisitor::get_method_func(RealType_ptr base_type, PlaceKind place_kind, const string &method_name) {
-    FnDecl_ptr method_decl = nullptr;
-    if (base_type->kind == RealTypeKind::STRUCT) {
-        auto struct_type = std::dynamic_pointer_cast<StructRealType>(base_type);
-        auto struct_decl = struct_type->decl.lock();
-        if (struct_decl->methods.find(method_name) == struct_decl->methods.end()) {
-            throw string("CE, struct has no method named ") + method_name;
-        }
-        method_decl = struct_decl->methods[method_name];
-    } else {
-        for (auto &[kind, name, decl] : builtin_method_funcs) {
-            if (kind == base_type->kind && name == method_name) {
-                method_decl = decl;
-                break;
-            }
-        }
+    FnDecl_ptr method_decl = method_table.find(base_type, method_name);
+    if (method_decl == nullptr && base_type->kind == RealTypeKind::STRUCT) {
+        throw string("CE, struct has no method named ") + method_name;
     }
     if (method_decl == nullptr) {
         throw string("CE, type ") + real_type_kind_to_string(base_type->kind) + " has no method named " + method_name;
@@ -1150,15 +1025,15 @@ RealType_ptr ExprTypeAndLetStmtVisitor::get_method_func(RealType_ptr base_type,
     // 检查 self receiver
     if (method_decl->receiver_type == fn_reciever_type::SELF) {
         // 这个时候自动解引用
-        return std::make_shared<FunctionRealType>(method_decl, ReferenceType::NO_REF);
+        return types.function_type(method_decl);
     } else if (method_decl->receiver_type == fn_reciever_type::SELF_REF) {
         // 这个时候自动加引用
-        return std::make_shared<FunctionRealType>(method_decl, ReferenceType::NO_REF);
+        return types.function_type(method_decl);
     } else if (method_decl->receiver_type == fn_reciever_type::SELF_REF_MUT) {
         if (base_type->is_ref == ReferenceType::NO_REF) {
             if (place_kind != PlaceKind::ReadOnlyPlace) {
                 // 可变的左值 和右值应该都可以
-                return std::make_shared<FunctionRealType>(method_decl, ReferenceType::NO_REF);
+                return types.function_type(method_decl);
             } else {
                 throw string("CE, method ") + method_name + " requires a mutable self receiver";
             }
@@ -1166,7 +1041,7 @@ RealType_ptr ExprTypeAndLetStmtVisitor::get_method_func(RealType_ptr base_type,
             throw string("CE, method ") + method_name + " requires a mutable self receiver";
         } else {
             // REF_MUT
-            return std::make_shared<FunctionRealType>(method_decl, ReferenceType::NO_REF);
+            return types.function_type(method_decl);
         }
     } else {
         // no receiver 的情况应该前面已经检查掉了
@@ -1175,24 +1050,12 @@ RealType_ptr ExprTypeAndLetStmtVisitor::get_method_func(RealType_ptr base_type,
 }
 
 RealType_ptr ExprTypeAndLetStmtVisitor::get_associated_func(RealType_ptr base_type, const string &func_name) {
-    FnDecl_ptr func_decl = nullptr;
-    if (base_type->kind == RealTypeKind::STRUCT) {
-        auto struct_type = std::dynamic_pointer_cast<StructRealType>(base_type);
-        auto struct_decl = struct_type->decl.lock();
-        if (struct_decl->associated_func.find(func_name) == struct_decl->associated_func.end()) {
-            throw string("CE, struct has no associated function named ") + func_name;
-        }
-        func_decl = struct_decl->associated_func[func_name];
-    } else {
-        for (auto &[kind, name, decl] : builtin_associated_funcs) {
-            if (kind == base_type->kind && name == func_name) {
-                func_decl = decl;
-                break;
-            }
-        }
+    FnDecl_ptr func_decl = associated_func_table.find(base_type, func_name);
+    if (func_decl == nullptr && base_type->kind == RealTypeKind::STRUCT) {
+        throw string("CE, struct has no associated function named ") + func_name;
     }
     if (func_decl == nullptr) {
         throw string("CE, type ") + real_type_kind_to_string(base_type->kind) + " has no associated function named " + func_name;
     }
-    return std::make_shared<FunctionRealType>(func_decl, ReferenceType::NO_REF);
+    return types.function_type(func_decl);
 }
@@ -1,6 +1,9 @@
 #include "tools/tools.h"
 #include <climits>
 #include <cstdint>
+#include <exception>
+#include <pthread.h>
+#include <vector>
 
 int ch_to_digit(const char &ch) {
     if (ch >= '0' && ch <= '9') {
@@ -14,49 +17,142 @@ int ch_to_digit(const char &ch) {
     }
 }
 
-long long safe_stoll(const string &s) {
-    if (s.empty()) {
-        throw string("CE, empty integer literal");
-    }
-    std::string digits = s;
+IntegerLiteral decode_integer_literal(std::string_view s) {
+    IntegerLiteral literal;
+    std::string_view digits = s;
     long long max_value = LLONG_MAX;
-    auto apply_suffix = [&](const string &suffix, long long limit) {
+    auto apply_suffix = [&](std::string_view suffix, IntegerSuffix kind, long long limit) {
         if (digits.size() <= suffix.size()) {
-            throw string("CE, invalid integer literal: ") + s;
+            literal.invalid = true;
+            return;
         }
-        digits = digits.substr(0, digits.size() - suffix.size());
+        digits.remove_suffix(suffix.size());
+        literal.suffix = kind;
         max_value = limit;
     };
-    if (s.size() >= 3 && s.compare(s.size() - 3, 3, "i32") == 0) {
-        apply_suffix("i32", INT32_MAX);
-    } else if (s.size() >= 3 && s.compare(s.size() - 3, 3, "u32") == 0) {
-        apply_suffix("u32", UINT32_MAX);
-    } else if (s.size() >= 5 && s.compare(s.size() - 5, 5, "isize") == 0) {
-        apply_suffix("isize", INT32_MAX);
-    } else if (s.size() >= 5 && s.compare(s.size() - 5, 5, "usize") == 0) {
-        apply_suffix("usize", UINT32_MAX);
-    }
-    auto it = digits.begin();
-    long long result = 0;
+    if (s.ends_with("i32")) {
+        apply_suffix("i32", IntegerSuffix::I32, INT32_MAX);
+    } else if (s.ends_with("u32")) {
+        apply_suffix("u32", IntegerSuffix::U32, UINT32_MAX);
+    } else if (s.ends_with("isize")) {
+        apply_suffix("isize", IntegerSuffix::ISIZE, INT32_MAX);
+    } else if (s.ends_with("usize")) {
+        apply_suffix("usize", IntegerSuffix::USIZE, UINT32_MAX);
+    }
+    if (literal.invalid || digits.empty()) {
+        literal.invalid = true;
+        return literal;
+    }
     int base = 10;
     if (digits.size() >= 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
         base = 16;
-        it += 2;
+        digits.remove_prefix(2);
     }
     // 别的进制先不管，遇到了再说
-    if (it == digits.end()) {
-        throw string("CE, invalid number literal: ") + s;
+    if (digits.empty()) {
+        literal.invalid = true;
+        return literal;
     }
-    while(it != digits.end()) {
-        int digit = ch_to_digit(*it);
+    long long result = 0;
+    for (char ch : digits) {
+        int digit = ch_to_digit(ch);
         if (digit == -1 || digit >= base) {
-            throw string("CE, invalid digit in number: ") + *it + " base = " + std::to_string(base);
+            literal.invalid = true;
+            return literal;
+        }
+        if (!literal.overflow && result > (max_value - digit) / base) {
+            // 继续往后看，非法字符的优先级更高
+            literal.overflow = true;
         }
-        if (result > (max_value - digit) / base) {
-            throw string("CE, number too large: ") + s;
+        if (!literal.overflow) {
+            result = result * base + digit;
+        }
+    }
+    literal.value = result;
+    return literal;
+}
+
+long long integer_literal_value(const IntegerLiteral &literal, std::string_view s) {
+    if (literal.invalid) {
+        throw string("CE, invalid number literal: ") + string(s);
+    }
+    if (literal.overflow) {
+        throw string("CE, number too large: ") + string(s);
+    }
+    return literal.value;
+}
+
+long long safe_stoll(const string &s) {
+    return integer_literal_value(decode_integer_literal(s), s);
+}
+
+namespace {
+
+struct LargeStackTask {
+    const std::function<void()> *f;
+    std::exception_ptr error;
+};
+
+void *run_large_stack_task(void *arg) {
+    LargeStackTask *task = static_cast<LargeStackTask *>(arg);
+    try {
+        (*task->f)();
+    } catch (...) {
+        task->error = std::current_exception();
+    }
+    return nullptr;
+}
+
+// 线程栈是按需映射的，申请很大也只占用实际用到的部分
+bool start_large_stack_thread(LargeStackTask &task, size_t stack_size, pthread_t &thread) {
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0) {
+        return false;
+    }
+    bool started = pthread_attr_setstacksize(&attr, stack_size) == 0 &&
+                   pthread_create(&thread, &attr, run_large_stack_task, &task) == 0;
+    pthread_attr_destroy(&attr);
+    return started;
+}
+
+} // namespace
+
+void run_with_large_stack(const std::function<void()> &f, size_t stack_size) {
+    LargeStackTask task{&f, nullptr};
+    pthread_t thread;
+    if (!start_large_stack_thread(task, stack_size, thread)) {
+        // 开不了线程就在当前线程上跑
+        f();
+        return;
+    }
+    pthread_join(thread, nullptr);
+    if (task.error) {
+        std::rethrow_exception(task.error);
+    }
+}
+
+void run_in_parallel(size_t thread_count, const std::function<void()> &worker, size_t stack_size) {
+    // 开不了的线程就少开几个，worker 自己从共享的任务队列里取任务，少几个线程结果也一样
+    std::vector<LargeStackTask> tasks(thread_count > 1 ? thread_count - 1 : 0, LargeStackTask{&worker, nullptr});
+    std::vector<pthread_t> threads(tasks.size());
+    std::vector<bool> started(tasks.size(), false);
+    for (size_t t = 0; t < tasks.size(); t++) {
+        started[t] = start_large_stack_thread(tasks[t], stack_size, threads[t]);
+    }
+    std::exception_ptr error;
+    try {
+        worker();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (size_t t = 0; t < tasks.size(); t++) {
+        if (!started[t]) continue;
+        pthread_join(threads[t], nullptr);
+        if (!error && tasks[t].error) {
+            error = tasks[t].error;
         }
-        result = result * base + digit;
-        it++;
     }
-    return result;
+    if (error) {
+        std::rethrow_exception(error);
+    }
 }
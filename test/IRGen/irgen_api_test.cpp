@@ -4,35 +4,34 @@
 
 using namespace ir;
 
-static_assert(std::is_base_of_v<AST_Walker, IRGenVisitor>);
+static_assert(std::is_base_of_v<AST_Walker<IRGenVisitor>, IRGenVisitor>);
 
 static_assert(std::is_constructible_v<
               IRGenerator, IRModule &, IRBuilder &, TypeLowering &,
-              std::map<size_t, Scope_ptr> &,
-              std::map<Scope_ptr, Local_Variable_map> &,
-              std::map<size_t, RealType_ptr> &,
-              std::map<size_t, std::pair<RealType_ptr, PlaceKind>> &,
-              std::map<size_t, OutcomeState> &,
-              std::map<size_t, FnDecl_ptr> &,
+              NodeTable<Scope_ptr> &,
+              NodeTable<RealType_ptr> &,
+              NodeTable<std::pair<RealType_ptr, PlaceKind>> &,
+              NodeTable<OutcomeState> &,
+              NodeTable<FnDecl_ptr> &,
               std::map<ConstDecl_ptr, ConstValue_ptr> &,
-              std::map<size_t, FnDecl_ptr> &,
-              std::map<size_t, ValueDecl_ptr> &,
-              std::map<size_t, LetDecl_ptr> &>);
+              NodeTable<FnDecl_ptr> &,
+              NodeTable<ValueDecl_ptr> &,
+              NodeTable<LetDecl_ptr> &>);
 
 static_assert(std::is_same_v<void (IRGenerator::*)(const std::vector<Item_ptr> &),
                              decltype(&IRGenerator::generate)>);
 
 static_assert(std::is_constructible_v<
               IRGenVisitor, IRModule &, IRBuilder &, TypeLowering &,
-              std::map<size_t, Scope_ptr> &,
-              std::map<size_t, RealType_ptr> &,
-              std::map<size_t, std::pair<RealType_ptr, PlaceKind>> &,
-              std::map<size_t, OutcomeState> &,
-              std::map<size_t, FnDecl_ptr> &,
+              NodeTable<Scope_ptr> &,
+              NodeTable<RealType_ptr> &,
+              NodeTable<std::pair<RealType_ptr, PlaceKind>> &,
+              NodeTable<OutcomeState> &,
+              NodeTable<FnDecl_ptr> &,
               std::map<ConstDecl_ptr, ConstValue_ptr> &,
-              std::map<size_t, FnDecl_ptr> &,
-              std::map<size_t, ValueDecl_ptr> &,
-              std::map<size_t, LetDecl_ptr> &>);
+              NodeTable<FnDecl_ptr> &,
+              NodeTable<ValueDecl_ptr> &,
+              NodeTable<LetDecl_ptr> &>);
 
 static_assert(std::is_default_constructible_v<LoopContext>);
 static_assert(std::is_default_constructible_v<FunctionContext>);
@@ -13,6 +13,7 @@ from pathlib import Path
 CXX_TEST_BINARIES = [
     "irgen_api_test",
     "function_context_default_state_test",
+    "string_literal_dedup_test",
 ]
 
 PASS_MARK = "✅"
@@ -0,0 +1,87 @@
+#include "ir/IRBuilder.h"
+#include "ir/IRGen.h"
+#include "ir/global_lowering.h"
+#include "ir/type_lowering.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "semantic/semantic_checker.h"
+
+#include <iostream>
+#include <string>
+
+namespace {
+
+const std::string PROGRAM = R"(
+fn greet() {
+    println("hello");
+}
+fn main() {
+    println("hello");
+    greet();
+    println("world");
+    print("hello");
+    exit(0);
+}
+)";
+
+std::string generate_ir(const std::string &code) {
+    Lexer lexer;
+    lexer.tokenize(SourceBuffer::from_string(code));
+    Parser parser(lexer);
+    auto items = parser.parse();
+    Semantic_Checker checker(items);
+    checker.checker();
+
+    ir::IRModule module("unknown-unknown-unknown", "");
+    ir::IRBuilder builder(module);
+    ir::TypeLowering type_lowering(module);
+    type_lowering.declare_builtin_string_types();
+    ir::GlobalLoweringDriver global_driver(module, builder, type_lowering,
+                                           checker.const_value_map);
+    global_driver.emit_scope_tree(checker.root_scope);
+
+    ir::IRGenerator generator(
+        module, builder, type_lowering, checker.node_scope_map,
+        checker.type_map,
+        checker.node_type_and_place_kind_map, checker.node_outcome_state_map,
+        checker.call_expr_to_decl_map, checker.const_value_map,
+        checker.fn_item_to_decl_map, checker.identifier_expr_to_decl_map,
+        checker.let_stmt_to_decl_map);
+    generator.generate(items);
+    return module.to_string();
+}
+
+// 以 "@.str." 开头、内容是 content 的全局常量的个数
+size_t count_string_globals(const std::string &ir_text, const std::string &content) {
+    size_t count = 0;
+    size_t line_begin = 0;
+    while (line_begin < ir_text.size()) {
+        size_t line_end = ir_text.find('\n', line_begin);
+        if (line_end == std::string::npos) line_end = ir_text.size();
+        std::string line = ir_text.substr(line_begin, line_end - line_begin);
+        if (line.rfind("@.str.", 0) == 0 && line.find("c\"" + content + "\\00\"") != std::string::npos) {
+            count++;
+        }
+        line_begin = line_end + 1;
+    }
+    return count;
+}
+
+} // namespace
+
+// 多个调用点上内容相同的字符串字面量只生成一个 .str 全局常量
+int main() {
+    std::string ir_text;
+    try {
+        ir_text = generate_ir(PROGRAM);
+    } catch (const std::string &err) {
+        std::cerr << err << std::endl;
+        return 1;
+    }
+    if (count_string_globals(ir_text, "hello") != 1 || count_string_globals(ir_text, "world") != 1) {
+        std::cerr << "expected exactly one .str global per distinct literal" << std::endl;
+        std::cerr << ir_text;
+        return 1;
+    }
+    return 0;
+}
@@ -28,7 +28,7 @@ std::string generate_ir() {
 
     ir::IRGenerator generator(
         module, builder, type_lowering, checker.node_scope_map,
-        checker.scope_local_variable_map, checker.type_map,
+        checker.type_map,
         checker.node_type_and_place_kind_map, checker.node_outcome_state_map,
         checker.call_expr_to_decl_map, checker.const_value_map,
         checker.fn_item_to_decl_map, checker.identifier_expr_to_decl_map,
@@ -1,3 +1,4 @@
+#include "ast/arena.h"
 #include "ir/type_lowering.h"
 #include "semantic/consteval.h"
 #include "semantic/decl.h"
@@ -11,8 +12,11 @@ using namespace ir;
 
 namespace {
 
+// 测试里手工构造的 AST 节点
+ASTArena test_nodes;
+
 StructDecl_ptr make_point_decl() {
-    auto ast = std::make_shared<StructItem>(
+    auto ast = test_nodes.make<StructItem>(
         "Point", std::vector<std::pair<std::string, Type_ptr>>(
                       {{"x", nullptr}, {"y", nullptr}}));
     auto decl = std::make_shared<StructDecl>(ast, "Point");
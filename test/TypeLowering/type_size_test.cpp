@@ -1,3 +1,4 @@
+#include "ast/arena.h"
 #include "ir/type_lowering.h"
 #include "semantic/decl.h"
 #include "semantic/type.h"
@@ -11,6 +12,9 @@ using namespace ir;
 
 namespace {
 
+// 测试里手工构造的 AST 节点
+ASTArena test_nodes;
+
 StructDecl_ptr make_struct(const std::string &name,
                            const std::vector<std::pair<std::string, RealType_ptr>>
                                &fields) {
@@ -18,7 +22,7 @@ StructDecl_ptr make_struct(const std::string &name,
     for (const auto &field : fields) {
         ast_fields.emplace_back(field.first, nullptr);
     }
-    auto ast = std::make_shared<StructItem>(name, ast_fields);
+    auto ast = test_nodes.make<StructItem>(name, ast_fields);
     auto decl = std::make_shared<StructDecl>(ast, name);
     for (const auto &field : fields) {
         decl->field_order.push_back(field.first);
@@ -0,0 +1,72 @@
+#include "lexer/lexer.h"
+#include <cstdint>
+#include <iostream>
+
+// 读入 stdin 的代码，做一串伪随机的修改，每次修改之后增量分词的结果必须和重新分词完全一致
+int main() {
+    SourceBuffer_ptr source = SourceBuffer::from_stdin();
+    string code(source->view());
+    Lexer incremental;
+    try {
+        incremental.tokenize(source);
+    } catch (string err_infomation) {
+        std::cout << "SKIP " << err_infomation << std::endl;
+        return 0;
+    }
+    // 故意包含会打开 / 关闭注释、字符串、字符的片段
+    const string pieces[] = {"", " ", "\n", "x", "r", "12", "_u32", "<", "=", ">>", "/", "*",
+                             "/*", "*/", "//", "\"", "\\", "'a'", "'", "r#\"", "\"#", "#", "fn ", "let y = 0;"};
+    uint64_t seed = 20241017;
+    auto next_random = [&](uint64_t bound) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return bound == 0 ? 0 : (seed >> 33) % bound;
+    };
+    size_t applied = 0;
+    for (int round = 0; round < 400; round++) {
+        size_t offset = next_random(code.size() + 1);
+        size_t removed_length = next_random(std::min<size_t>(8, code.size() - offset) + 1);
+        const string &inserted = pieces[next_random(std::size(pieces))];
+        string new_code = code.substr(0, offset) + inserted + code.substr(offset + removed_length);
+
+        Lexer full;
+        string full_error;
+        try {
+            full.tokenize(SourceBuffer::from_string(new_code));
+        } catch (string err_infomation) {
+            full_error = err_infomation;
+        }
+        string incremental_error;
+        try {
+            incremental.relex(offset, removed_length, inserted);
+        } catch (string err_infomation) {
+            incremental_error = err_infomation;
+        }
+        if (full_error != incremental_error) {
+            std::cerr << "round " << round << " error mismatch: " << full_error << " vs " << incremental_error << std::endl;
+            return 1;
+        }
+        if (!full_error.empty()) {
+            // 出错时增量分词保持原样，接着在旧代码上修改
+            continue;
+        }
+        code = new_code;
+        applied++;
+        if (incremental.tokens.size() != full.tokens.size()) {
+            std::cerr << "round " << round << " token count mismatch" << std::endl;
+            return 1;
+        }
+        for (size_t i = 0; i < full.tokens.size(); i++) {
+            const Token &a = full.tokens[i];
+            const Token &b = incremental.tokens[i];
+            if (a.type != b.type || a.value != b.value || a.begin != b.begin || a.end != b.end ||
+                a.number.value != b.number.value) {
+                std::cerr << "round " << round << " token " << i << " mismatch" << std::endl;
+                a.show_token();
+                b.show_token();
+                return 1;
+            }
+        }
+    }
+    std::cout << "OK " << applied << std::endl;
+    return 0;
+}
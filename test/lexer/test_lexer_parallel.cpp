@@ -0,0 +1,46 @@
+#include "lexer/lexer.h"
+#include <iostream>
+
+// 读入 stdin 的代码，分别顺序分词和切成很小的块并行分词，结果必须完全一致
+int main() {
+    SourceBuffer_ptr source = SourceBuffer::from_stdin();
+    Lexer sequential;
+    string sequential_error;
+    try {
+        sequential.tokenize(source);
+    } catch (string err_infomation) {
+        sequential_error = err_infomation;
+    }
+    for (size_t min_chunk_size : {1, 7, 64, 4096}) {
+        for (size_t thread_count : {2, 3, 8}) {
+            Lexer parallel;
+            string parallel_error;
+            try {
+                parallel.tokenize_parallel(source, thread_count, min_chunk_size);
+            } catch (string err_infomation) {
+                parallel_error = err_infomation;
+            }
+            if (parallel_error != sequential_error) {
+                std::cerr << "error mismatch: " << sequential_error << " vs " << parallel_error << std::endl;
+                return 1;
+            }
+            if (parallel.tokens.size() != sequential.tokens.size()) {
+                std::cerr << "token count mismatch with chunk size " << min_chunk_size << std::endl;
+                return 1;
+            }
+            for (size_t i = 0; i < sequential.tokens.size(); i++) {
+                const Token &a = sequential.tokens[i];
+                const Token &b = parallel.tokens[i];
+                if (a.type != b.type || a.value != b.value || a.symbol_id != b.symbol_id ||
+                    a.begin != b.begin || a.end != b.end) {
+                    std::cerr << "token " << i << " mismatch" << std::endl;
+                    a.show_token();
+                    b.show_token();
+                    return 1;
+                }
+            }
+        }
+    }
+    std::cout << "OK " << sequential.tokens.size() << std::endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "lexer/lexer.h"
+#include "lexer/scan.h"
+#include <iostream>
+
+namespace {
+
+const scan::ScanLevel LEVELS[] = {scan::ScanLevel::SCALAR, scan::ScanLevel::SSE2, scan::ScanLevel::AVX2};
+
+// token 的 value 指向 Lexer 里的内容，Lexer 析构前拷贝出来
+struct TokenCopy {
+    Token_type type;
+    string value;
+    uint32_t symbol_id;
+    size_t begin, end;
+    bool operator==(const TokenCopy &other) const = default;
+};
+
+struct Tokenized {
+    vector<TokenCopy> tokens;
+    string error;
+    bool operator==(const Tokenized &other) const = default;
+};
+
+Tokenized tokenize(const string &code) {
+    Lexer lexer;
+    Tokenized result;
+    try {
+        lexer.tokenize(SourceBuffer::from_string(code));
+    } catch (string err_infomation) {
+        result.error = err_infomation;
+    }
+    for (const Token &token : lexer.tokens) {
+        result.tokens.push_back({token.type, token.str(), token.symbol_id, token.begin, token.end});
+    }
+    return result;
+}
+
+// 每种实现的四个扫描函数从每个位置开始的结果都和逐字节的一样
+bool same_scans(const string &text) {
+    std::string_view view = text;
+    vector<size_t> expected;
+    scan::set_scan_level(scan::ScanLevel::SCALAR);
+    for (size_t pos = 0; pos <= view.size(); pos++) {
+        expected.push_back(scan::skip_whitespace(view, pos));
+        expected.push_back(scan::skip_identifier(view, pos));
+        expected.push_back(scan::find_byte(view, pos, '"'));
+        expected.push_back(scan::find_either(view, pos, '*', '/'));
+    }
+    for (scan::ScanLevel level : LEVELS) {
+        scan::set_scan_level(level);
+        vector<size_t> got;
+        for (size_t pos = 0; pos <= view.size(); pos++) {
+            got.push_back(scan::skip_whitespace(view, pos));
+            got.push_back(scan::skip_identifier(view, pos));
+            got.push_back(scan::find_byte(view, pos, '"'));
+            got.push_back(scan::find_either(view, pos, '*', '/'));
+        }
+        if (got != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+vector<string> samples() {
+    string banner = "/*" + string(100, '*') + "*/\n// " + string(70, '=') + "\nfn main() {}\n";
+    string escapes = "let s: &str = \"";
+    for (int k = 0; k < 8; k++) {
+        escapes += "abc\\\"def\\\\ghi\\n\\t";
+    }
+    escapes += "\";\n";
+    string names = "let " + string(70, 'x') + "_1: u32 = " + string(40, '7') + "u32 + 0x" + string(33, 'f') + ";\n";
+    string high_bytes = "// h\xc3\xa9llo \xe4\xb8\x96\xe7\x95\x8c " + string(40, '-') +
+                        "\n/* \xe4\xb8\x96\xe7\x95\x8c" + string(40, ' ') + "*/ let s: &str = \"\xc3\xa9" +
+                        string(35, 'a') + "\";\n";
+    string bad_byte = "let " + string(30, 'y') + "\xc3\xa9 = 1;\n";
+    string spaces = "let a" + string(50, ' ') + "=\t\t\r\n" + string(33, '\n') + "1;\n";
+    string split = "let a/*c*/b = 2;\nlet x//c\ny = 3;\n";
+    return {banner, escapes, names, high_bytes, bad_byte, spaces, split};
+}
+
+} // namespace
+
+// 分别强制使用逐字节、SSE2、AVX2 的扫描（CPU 不支持的级别会降级），
+// 每个样例前面加 0 ~ 40 个字节让 token 跨过 16 / 32 字节的边界，分词的结果必须和逐字节的完全一致
+int main() {
+    for (const string &sample : samples()) {
+        for (size_t shift = 0; shift <= 40; shift++) {
+            string code = string(shift, ' ') + sample + sample;
+            if (!same_scans(code)) {
+                std::cerr << "scan mismatch with shift " << shift << std::endl;
+                return 1;
+            }
+            scan::set_scan_level(scan::ScanLevel::SCALAR);
+            Tokenized expected = tokenize(code);
+            for (scan::ScanLevel level : LEVELS) {
+                scan::set_scan_level(level);
+                if (tokenize(code) != expected) {
+                    std::cerr << "token mismatch at level " << static_cast<int>(level) << " with shift " << shift
+                              << std::endl;
+                    return 1;
+                }
+            }
+        }
+    }
+    // 注释把标识符分成两个 token
+    scan::set_scan_level(scan::ScanLevel::SCALAR);
+    Tokenized split = tokenize("a/*c*/b x//c\ny");
+    vector<string> values;
+    for (const TokenCopy &token : split.tokens) {
+        values.push_back(token.value);
+    }
+    if (!split.error.empty() || values != vector<string>{"a", "b", "x", "y"}) {
+        std::cerr << "comment should split identifiers" << std::endl;
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "ast/flat_ast.h"
+#include "lexer/lexer.h"
+#include "parser/ast_cache.h"
+#include "parser/parser.h"
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+bool same_flat_ast(const FlatAST &a, const FlatAST &b) {
+    return a.kind == b.kind && a.flags == b.flags && a.node_id == b.node_id && a.subtree_end == b.subtree_end &&
+           a.first_child == b.first_child && a.child_count == b.child_count && a.name == b.name &&
+           a.name_list == b.name_list && a.children == b.children && a.name_lists == b.name_lists &&
+           a.strings == b.strings && a.roots == b.roots;
+}
+
+} // namespace
+
+// 读入 stdin 的代码：序列化 -> 反序列化 -> 重建的 AST 和解析出来的完全一样（包括 NodeId），
+// 截断 / 改坏的数据不会被接受，ASTCache 写进去再读出来也一样
+int main() {
+    SourceBuffer_ptr source = SourceBuffer::from_stdin();
+    Lexer lexer;
+    ParsedAST parsed;
+    try {
+        lexer.tokenize(source);
+        Parser parser(lexer);
+        parsed.items = parser.parse();
+        parsed.node_count = parser.node_count();
+        parsed.arena.adopt(parser.node_arena());
+    } catch (string err_infomation) {
+        std::cout << "SKIP " << err_infomation << std::endl;
+        return 0;
+    }
+    FlatAST flat = FlatAST::build(parsed.items);
+    string data = flat.serialize();
+
+    FlatAST loaded;
+    if (!FlatAST::deserialize(data, loaded) || !same_flat_ast(flat, loaded)) {
+        std::cerr << "deserialize mismatch" << std::endl;
+        return 1;
+    }
+    ASTArena arena;
+    if (!same_flat_ast(flat, FlatAST::build(loaded.to_ast(arena)))) {
+        std::cerr << "to_ast mismatch" << std::endl;
+        return 1;
+    }
+    // 截断的数据一定不合法
+    for (size_t length = 0; length < data.size(); length += 1 + data.size() / 64) {
+        FlatAST truncated;
+        if (FlatAST::deserialize(std::string_view(data).substr(0, length), truncated)) {
+            std::cerr << "accepted truncated data of length " << length << std::endl;
+            return 1;
+        }
+    }
+    // 改坏一个字节：要么不接受，要么重建时报错，要么重建出一棵树，但不能越界
+    for (size_t pos = 0; pos < data.size(); pos += 1 + data.size() / 64) {
+        string broken = data;
+        broken[pos] = static_cast<char>(broken[pos] ^ 0x5a);
+        FlatAST damaged;
+        if (FlatAST::deserialize(broken, damaged)) {
+            ASTArena damaged_arena;
+            try {
+                damaged.to_ast(damaged_arena);
+            } catch (string) {
+            }
+        }
+    }
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() /
+                                ("ast_cache_test_" + std::to_string(ASTCache::hash(source->view())));
+    std::filesystem::remove_all(dir);
+    ASTCache cache(dir.string());
+    if (cache.load(source->view()) != nullptr) {
+        std::cerr << "hit on an empty cache" << std::endl;
+        return 1;
+    }
+    cache.store(source->view(), parsed);
+    std::unique_ptr<ParsedAST> cached = cache.load(source->view());
+    if (cached == nullptr || cached->node_count != parsed.node_count ||
+        !same_flat_ast(flat, FlatAST::build(cached->items))) {
+        std::cerr << "cache round trip mismatch" << std::endl;
+        return 1;
+    }
+    // 源代码变了就不能命中
+    if (cache.load(string(source->view()) + " ") != nullptr) {
+        std::cerr << "hit on different source" << std::endl;
+        return 1;
+    }
+    std::filesystem::remove_all(dir);
+    std::cout << "OK " << flat.size() << " " << data.size() << std::endl;
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "ast/flat_ast.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include <iostream>
+
+// 读入 stdin 的代码，转换成 FlatAST，检查它和指针形式的 AST 一一对应、子树区间和子节点下标一致
+int main() {
+    Lexer lexer;
+    vector<Item_ptr> ast;
+    try {
+        lexer.read_and_get_tokens();
+        Parser parser(lexer);
+        ast = parser.parse();
+        FlatAST flat = FlatAST::build(ast);
+        // 每个节点恰好出现一次：NodeId 是稠密的，FlatAST 中的 NodeId 正好是 [0, node_count) 的一个排列
+        if (flat.size() != parser.node_count()) {
+            std::cerr << "node count mismatch: " << flat.size() << " vs " << parser.node_count() << std::endl;
+            return 1;
+        }
+        vector<bool> seen(flat.size(), false);
+        for (uint32_t i = 0; i < flat.size(); i++) {
+            if (flat.node_id[i] >= flat.size() || seen[flat.node_id[i]]) {
+                std::cerr << "node " << i << " has bad NodeId " << flat.node_id[i] << std::endl;
+                return 1;
+            }
+            seen[flat.node_id[i]] = true;
+            // 存在的子节点依次紧挨着，最后一个子节点的子树结束的地方就是自己的子树结束的地方
+            uint32_t next = i + 1;
+            for (uint32_t child : flat.child_list(i)) {
+                if (child == FlatAST::NO_NODE) continue;
+                if (child != next) {
+                    std::cerr << flat_kind_to_string(flat.kind[i]) << " " << i << " has child " << child
+                              << ", expected " << next << std::endl;
+                    return 1;
+                }
+                next = flat.subtree_end[child];
+            }
+            if (next != flat.subtree_end[i]) {
+                std::cerr << flat_kind_to_string(flat.kind[i]) << " " << i << " has wrong subtree end" << std::endl;
+                return 1;
+            }
+        }
+        size_t expr_count = 0;
+        for (uint32_t root : flat.roots) {
+            flat.for_each_expr(root, [&](uint32_t) { expr_count++; });
+        }
+        std::cout << "OK " << flat.size() << " " << expr_count << " " << flat.strings.size() << std::endl;
+    } catch (string err_infomation) {
+        std::cout << "SKIP " << err_infomation << std::endl;
+    }
+    return 0;
+}
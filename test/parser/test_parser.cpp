@@ -20,7 +20,7 @@ int main() {
         auto ast = parser.parse();
         AST_Printer printer;
         for (const auto &item : ast) {
-            item->accept(printer);
+            printer.dispatch(item);
         }
     } catch(string err_infomation) {
         std::cerr << err_infomation << std::endl;
@@ -0,0 +1,60 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include <iostream>
+
+// 很长的运算符链和很深的括号嵌套：parse_expression 用显式栈，不能爆栈，树的形状要和结合性一致
+int main() {
+    const int chain_length = 200000;
+    const int paren_depth = 100000;
+    string code = "fn main() { let x: i32 = 1";
+    for (int i = 1; i < chain_length; i++) {
+        code += i % 2 ? " + 1" : " - 1";
+    }
+    code += "; let y: i32 = ";
+    code += string(paren_depth, '(') + "-1" + string(paren_depth, ')');
+    code += "; x = y = 2; }";
+    Lexer lexer;
+    vector<Item_ptr> ast;
+    Parser parser(lexer);
+    try {
+        lexer.tokenize(SourceBuffer::from_string(code));
+        ast = parser.parse();
+    } catch (string err_infomation) {
+        std::cerr << err_infomation << std::endl;
+        return 1;
+    }
+    BlockExpr_ptr body = static_cast<BlockExpr_ptr>(static_cast<FnItem_ptr>(ast[0])->body);
+    // 左结合：沿着 left 一直往下是 chain_length - 1 个 BinaryExpr
+    Expr_ptr expr = static_cast<LetStmt_ptr>(body->statements[0])->initializer;
+    int binary_count = 0;
+    while (expr->kind == NodeKind::BinaryExpr) {
+        BinaryExpr_ptr binary = static_cast<BinaryExpr_ptr>(expr);
+        Binary_Operator expected = (chain_length - 1 - binary_count) % 2 ? Binary_Operator::ADD : Binary_Operator::SUB;
+        if (binary->op != expected || binary->right->kind != NodeKind::LiteralExpr) {
+            std::cerr << "wrong chain at " << binary_count << std::endl;
+            return 1;
+        }
+        expr = binary->left;
+        binary_count++;
+    }
+    if (binary_count != chain_length - 1) {
+        std::cerr << "chain length " << binary_count << std::endl;
+        return 1;
+    }
+    // 括号不产生节点
+    expr = static_cast<LetStmt_ptr>(body->statements[1])->initializer;
+    if (expr->kind != NodeKind::UnaryExpr || static_cast<UnaryExpr_ptr>(expr)->right->kind != NodeKind::LiteralExpr) {
+        std::cerr << "wrong parenthesized expression" << std::endl;
+        return 1;
+    }
+    // 赋值右结合：x = (y = 2)
+    expr = static_cast<ExprStmt_ptr>(body->statements[2])->expr;
+    BinaryExpr_ptr assign = static_cast<BinaryExpr_ptr>(expr);
+    if (expr->kind != NodeKind::BinaryExpr || assign->left->kind != NodeKind::IdentifierExpr ||
+        assign->right->kind != NodeKind::BinaryExpr) {
+        std::cerr << "wrong assignment" << std::endl;
+        return 1;
+    }
+    std::cout << "OK " << parser.node_count() << std::endl;
+    return 0;
+}
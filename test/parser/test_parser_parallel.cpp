@@ -0,0 +1,52 @@
+#include "ast/flat_ast.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include <iostream>
+
+// 读入 stdin 的代码，分别顺序解析和并行解析（切得尽量碎），两棵 AST（包括 NodeId）和报错必须完全一致
+int main() {
+    SourceBuffer_ptr source = SourceBuffer::from_stdin();
+    Lexer sequential_lexer, parallel_lexer;
+    try {
+        sequential_lexer.tokenize(source);
+        parallel_lexer.tokenize(source);
+    } catch (string err_infomation) {
+        std::cout << "SKIP " << err_infomation << std::endl;
+        return 0;
+    }
+    Parser sequential_parser(sequential_lexer), parallel_parser(parallel_lexer);
+    string sequential_error, parallel_error;
+    FlatAST sequential, parallel;
+    try {
+        sequential = FlatAST::build(sequential_parser.parse());
+    } catch (string err_infomation) {
+        sequential_error = err_infomation;
+    }
+    try {
+        parallel = FlatAST::build(parallel_parser.parse_parallel(4, 1));
+    } catch (string err_infomation) {
+        parallel_error = err_infomation;
+    }
+    if (sequential_error != parallel_error) {
+        std::cerr << "error mismatch: " << sequential_error << " vs " << parallel_error << std::endl;
+        return 1;
+    }
+    if (!sequential_error.empty()) {
+        std::cout << "SKIP " << sequential_error << std::endl;
+        return 0;
+    }
+    if (sequential_parser.node_count() != parallel_parser.node_count() ||
+        sequential.kind != parallel.kind || sequential.flags != parallel.flags ||
+        sequential.node_id != parallel.node_id || sequential.children != parallel.children ||
+        sequential.name != parallel.name || sequential.name_lists != parallel.name_lists ||
+        sequential.strings != parallel.strings || sequential.roots != parallel.roots) {
+        std::cerr << "AST mismatch" << std::endl;
+        return 1;
+    }
+    if (parallel_lexer.has_more_tokens()) {
+        std::cerr << "tokens left after parse_parallel" << std::endl;
+        return 1;
+    }
+    std::cout << "OK " << parallel.roots.size() << " " << parallel.size() << std::endl;
+    return 0;
+}
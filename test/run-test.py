@@ -5,7 +5,7 @@ def test_lexer():
     # test lexer
     # 只要输出每个测试点的输出，手动对比即可
     print("Running lexer tests...")
-    test_cnt = 6
+    test_cnt = 7
     test_prog = "build/lexer/test_lexer"
     for i in range(1, test_cnt + 1):
         print(f"Running test {i}...")
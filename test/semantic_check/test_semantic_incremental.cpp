@@ -0,0 +1,150 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "semantic/incremental.h"
+#include "semantic/semantic_checker.h"
+#include <filesystem>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+const string BASE = R"(
+const N: usize = 3;
+struct P { x: i32 }
+impl P { fn get(&self) -> i32 { self.x } }
+fn f(p: &P) -> i32 { p.get() + p.x }
+fn g() -> i32 { let a: [i32; N] = [1, 2, 3]; a[0] }
+fn h(v: i32) -> i32 { v + 1 }
+fn main() { let p: P = P { x: 1 }; let s: i32 = f(&p) + g() + h(2); printlnInt(s); exit(0); }
+)";
+// item 的顺序：N P impl f g h main
+enum { ITEM_N, ITEM_P, ITEM_IMPL, ITEM_F, ITEM_G, ITEM_H, ITEM_MAIN, ITEM_COUNT };
+
+string replace(string code, const string &from, const string &to) {
+    code.replace(code.find(from), from.size(), to);
+    return code;
+}
+
+struct Program {
+    Lexer lexer;
+    std::unique_ptr<Parser> parser;
+    vector<Item_ptr> items;
+    explicit Program(const string &code) {
+        lexer.tokenize(SourceBuffer::from_string(code));
+        parser = std::make_unique<Parser>(lexer);
+        items = parser->parse();
+    }
+};
+
+// 用 checked_items 增量检查，返回错误（没有错误返回空串），passed 是检查通过的 item
+string check(const string &code, const std::unordered_set<uint64_t> &checked_items, vector<uint64_t> &passed) {
+    Program program(code);
+    Semantic_Checker checker(program.items, program.parser->node_count());
+    checker.checked_items = &checked_items;
+    string error;
+    try {
+        checker.checker();
+    } catch (string err_infomation) {
+        error = err_infomation;
+    }
+    passed = checker.passed_items;
+    return error;
+}
+
+// 和 BASE 比，哪些 item 的指纹变了
+vector<bool> changed_items(const string &code) {
+    Program base(BASE), edited(code);
+    auto before = ItemDependencies::compute(base.items).fingerprints;
+    auto after = ItemDependencies::compute(edited.items).fingerprints;
+    vector<bool> changed(ITEM_COUNT);
+    for (size_t k = 0; k < ITEM_COUNT; k++) {
+        changed[k] = before[k] != after[k];
+    }
+    return changed;
+}
+
+bool expect_changed(const string &what, const string &code, std::initializer_list<int> expected) {
+    vector<bool> want(ITEM_COUNT, false);
+    for (int k : expected) want[k] = true;
+    if (changed_items(code) != want) {
+        std::cerr << what << ": unexpected set of changed items" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// 指纹只在 item 自己或者它依赖的声明的接口变了的时候才变；增量检查和完整检查的结论一样；缓存能读回来
+int main() {
+    bool ok = true;
+    // 前面的 item 变了（NodeId 都变了），后面的指纹不变
+    ok &= expect_changed("body of h", replace(BASE, "v + 1", "v + 2 * v"), {ITEM_H});
+    ok &= expect_changed("struct field", replace(BASE, "x: i32 }", "x: i32, y: i32 }"),
+                         {ITEM_P, ITEM_IMPL, ITEM_F, ITEM_MAIN});
+    ok &= expect_changed("method body", replace(BASE, "{ self.x }", "{ self.x + 1 }"), {ITEM_IMPL});
+    ok &= expect_changed("method signature", replace(BASE, "get(&self)", "get(&mut self)"),
+                         {ITEM_P, ITEM_IMPL, ITEM_F, ITEM_MAIN});
+    ok &= expect_changed("const value", replace(BASE, "= 3;", "= 4;"), {ITEM_N, ITEM_G});
+    ok &= expect_changed("signature of h", replace(BASE, "h(v: i32)", "h(v: u32)"), {ITEM_H, ITEM_MAIN});
+    // 新的顶层声明和 item 里的局部变量同名，依赖的集合变了
+    ok &= expect_changed("new top-level a", BASE + "const a: i32 = 1;\n", {ITEM_G});
+
+    Program base(BASE);
+    auto dependencies = ItemDependencies::compute(base.items);
+    if (dependencies.dependencies[ITEM_F] != vector<string>{"P", "f"}) {
+        std::cerr << "unexpected dependencies of f" << std::endl;
+        ok = false;
+    }
+
+    // 第一次全部检查，第二次全部跳过，结论都一样
+    std::unordered_set<uint64_t> none;
+    vector<uint64_t> passed;
+    if (!check(BASE, none, passed).empty() || passed.size() != ITEM_COUNT) {
+        std::cerr << "base program should pass" << std::endl;
+        return 1;
+    }
+    std::unordered_set<uint64_t> checked(passed.begin(), passed.end());
+    vector<uint64_t> passed_again;
+    if (!check(BASE, checked, passed_again).empty() || passed_again != passed) {
+        std::cerr << "unchanged program should pass with the same items" << std::endl;
+        ok = false;
+    }
+    // f 的代码没变，但是它依赖的字段类型变了，必须重新检查出错误
+    vector<uint64_t> passed_edit;
+    string error = check(replace(BASE, "x: i32 }", "x: bool }"), checked, passed_edit);
+    if (error.empty()) {
+        std::cerr << "error in f after changing P was not reported" << std::endl;
+        ok = false;
+    }
+    // 改坏的 item 自己一定会重新检查，出错的 item 之前的仍然算检查通过
+    error = check(replace(BASE, "v + 1", "v + true"), checked, passed_edit);
+    if (error.empty() || passed_edit.size() != ITEM_H) {
+        std::cerr << "error in h was not reported" << std::endl;
+        ok = false;
+    }
+
+    // 缓存写进去再读出来一样，没有设置目录时什么都不做
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "checked_item_cache_test";
+    std::filesystem::remove_all(dir);
+    CheckedItemCache cache(dir.string());
+    if (!cache.load().empty()) {
+        std::cerr << "records in an empty cache" << std::endl;
+        ok = false;
+    }
+    cache.store(passed);
+    if (cache.load() != checked) {
+        std::cerr << "cache round trip mismatch" << std::endl;
+        ok = false;
+    }
+    if (!CheckedItemCache("").load().empty()) {
+        std::cerr << "disabled cache returned records" << std::endl;
+        ok = false;
+    }
+    std::filesystem::remove_all(dir);
+    if (!ok) {
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "semantic/semantic_checker.h"
+#include <iostream>
+#include <memory>
+
+namespace {
+
+// 解析一遍并做完语义检查，step4_thread_count = 1 时顺序检查
+struct CheckedProgram {
+    Lexer lexer;
+    std::unique_ptr<Parser> parser;
+    vector<Item_ptr> items;
+    std::unique_ptr<Semantic_Checker> checker;
+    string error;
+
+    CheckedProgram(SourceBuffer_ptr source, size_t thread_count) {
+        try {
+            lexer.tokenize(source);
+            parser = std::make_unique<Parser>(lexer);
+            items = parser->parse();
+            checker = std::make_unique<Semantic_Checker>(items, parser->node_count());
+            checker->step4_thread_count = thread_count;
+            checker->step4_min_items = 1;
+            checker->checker();
+        } catch (string err_infomation) {
+            error = err_infomation;
+        }
+    }
+};
+
+string show_type(const RealType_ptr &type) { return type == nullptr ? "null" : type->show_real_type_info(); }
+
+template <class T>
+bool same_decls(const NodeTable<T> &a, const NodeTable<T> &b, size_t node_count) {
+    for (size_t id = 0; id < node_count; id++) {
+        const T *x = a.get(id), *y = b.get(id);
+        if ((x == nullptr) != (y == nullptr)) return false;
+        if (x != nullptr && ((*x == nullptr) != (*y == nullptr) || (*x != nullptr && (*x)->name != (*y)->name))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// 读入 stdin 的代码，第四步分别顺序检查和多线程检查（每个顶层 item 一个任务），
+// 报错和每个节点的类型、绑定必须完全一致
+int main() {
+    SourceBuffer_ptr source = SourceBuffer::from_stdin();
+    CheckedProgram sequential(source, 1), parallel(source, 4);
+    if (sequential.error != parallel.error) {
+        std::cerr << "error mismatch: " << sequential.error << " vs " << parallel.error << std::endl;
+        return 1;
+    }
+    if (!sequential.error.empty()) {
+        std::cout << "SKIP " << sequential.error << std::endl;
+        return 0;
+    }
+    size_t node_count = sequential.parser->node_count();
+    Semantic_Checker &a = *sequential.checker, &b = *parallel.checker;
+    for (size_t id = 0; id < node_count; id++) {
+        auto *x = a.node_type_and_place_kind_map.get(id);
+        auto *y = b.node_type_and_place_kind_map.get(id);
+        if ((x == nullptr) != (y == nullptr) ||
+            (x != nullptr && (show_type(x->first) != show_type(y->first) || x->second != y->second))) {
+            std::cerr << "type mismatch at node " << id << std::endl;
+            return 1;
+        }
+    }
+    if (!same_decls(a.identifier_expr_to_decl_map, b.identifier_expr_to_decl_map, node_count) ||
+        !same_decls(a.let_stmt_to_decl_map, b.let_stmt_to_decl_map, node_count) ||
+        !same_decls(a.call_expr_to_decl_map, b.call_expr_to_decl_map, node_count)) {
+        std::cerr << "decl mismatch" << std::endl;
+        return 1;
+    }
+    std::cout << "OK " << sequential.items.size() << " " << node_count << std::endl;
+    return 0;
+}
@@ -16,7 +16,7 @@ int main() {
         AST_Printer printer;
         for (const auto &item : items) {
             if (item) {
-                item->accept(printer);
+                printer.dispatch(item);
             }
         }
         return 0;